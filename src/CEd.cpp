@@ -1180,12 +1180,8 @@ void
 CEd::
 doJoin(int line_num1, int line_num2)
 {
-  file_->startGroup();
-
-  for (int i = line_num1; i < line_num2; ++i)
-    file_->joinLine(line_num1 - 1);
-
-  file_->endGroup();
+  if (line_num2 > line_num1)
+    file_->joinLines(line_num1 - 1, line_num2 - line_num1);
 }
 
 void
@@ -1228,12 +1224,8 @@ void
 CEd::
 doDelete(int line_num1, int line_num2)
 {
-  file_->startGroup();
-
-  for (int i = line_num1; i <= line_num2; ++i)
-    deleteLine(line_num1 - 1);
-
-  file_->endGroup();
+  if (line_num2 >= line_num1)
+    file_->deleteLines(line_num1 - 1, line_num2 - line_num1 + 1);
 
   setPos(CIPoint2D(0, line_num1 - 1));
 }
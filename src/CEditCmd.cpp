@@ -13,14 +13,16 @@ CEditCmdMgr(CEditFile *file) :
   addCmd(new CEditDeleteLineCmd (this));
   addCmd(new CEditMoveLineCmd   (this));
   addCmd(new CEditReplaceCmd    (this));
-  addCmd(new CEditInsertCharCmd (this));
-  addCmd(new CEditReplaceCharCmd(this));
-  addCmd(new CEditDeleteCharsCmd(this));
-  addCmd(new CEditSplitLineCmd  (this));
-  addCmd(new CEditJoinLineCmd   (this));
-  addCmd(new CEditMoveToCmd     (this));
-  addCmd(new CEditUndoCmd       (this));
-  addCmd(new CEditRedoCmd       (this));
+  addCmd(new CEditInsertCharCmd  (this));
+  addCmd(new CEditInsertCharsCmd (this));
+  addCmd(new CEditReplaceCharCmd (this));
+  addCmd(new CEditDeleteCharsCmd (this));
+  addCmd(new CEditSplitLineCmd   (this));
+  addCmd(new CEditJoinLineCmd    (this));
+  addCmd(new CEditReplaceLinesCmd(this));
+  addCmd(new CEditMoveToCmd      (this));
+  addCmd(new CEditUndoCmd        (this));
+  addCmd(new CEditRedoCmd        (this));
 }
 
 void
@@ -307,6 +309,58 @@ exec()
 
 //------
 
+CEditInsertCharsCmd::
+CEditInsertCharsCmd(CEditCmdMgr *mgr) :
+ CEditCmd(mgr), line_num_(0), char_num_(0)
+{
+}
+
+CEditInsertCharsCmd::
+CEditInsertCharsCmd(CEditCmdMgr *mgr, int line_num, int char_num, const std::string &chars) :
+ CEditCmd(mgr), line_num_(line_num), char_num_(char_num), chars_(chars)
+{
+  if (mgr_->getDebug())
+    std::cerr << "Add: Insert Chars " << line_num_ << " " << char_num_ << " " << chars_ << "\n";
+}
+
+bool
+CEditInsertCharsCmd::
+exec(const std::vector<std::string> &argList)
+{
+  assert(argList.size() == 3);
+
+  int  line_num = int(CStrUtil::toInteger(argList[0]));
+  int  char_num = int(CStrUtil::toInteger(argList[1]));
+  auto str      = argList[2];
+
+  mgr_->getFile()->addChars(line_num, char_num, str);
+
+  return true;
+}
+
+bool
+CEditInsertCharsCmd::
+exec()
+{
+  if (getState() == UNDO_STATE) {
+    if (mgr_->getDebug())
+      std::cerr << "Exec: Insert Chars " << line_num_ << " " << char_num_ << " " << chars_ << "\n";
+
+    mgr_->getFile()->addChars(line_num_, char_num_, chars_);
+  }
+  else {
+    if (mgr_->getDebug())
+      std::cerr << "Exec: Delete Chars " << line_num_ << " " << char_num_ << " " <<
+                   chars_.size() << "\n";
+
+    mgr_->getFile()->deleteChars(line_num_, char_num_, uint(chars_.size()));
+  }
+
+  return true;
+}
+
+//------
+
 CEditReplaceCharCmd::
 CEditReplaceCharCmd(CEditCmdMgr *mgr) :
  CEditCmd(mgr), line_num_(0), char_num_(0), c_(0)
@@ -484,6 +538,64 @@ exec()
 
 //------
 
+CEditReplaceLinesCmd::
+CEditReplaceLinesCmd(CEditCmdMgr *mgr) :
+ CEditCmd(mgr), line_num_(0), num_lines_(0)
+{
+}
+
+CEditReplaceLinesCmd::
+CEditReplaceLinesCmd(CEditCmdMgr *mgr, int line_num, int num_lines, const Strings &lines) :
+ CEditCmd(mgr), line_num_(line_num), num_lines_(num_lines), lines_(lines)
+{
+  if (mgr_->getDebug())
+    std::cerr << "Add: Replace Lines " << line_num_ << " " << num_lines_ << " " <<
+                 lines_.size() << "\n";
+}
+
+bool
+CEditReplaceLinesCmd::
+exec(const std::vector<std::string> &argList)
+{
+  assert(argList.size() >= 2);
+
+  int line_num  = int(CStrUtil::toInteger(argList[0]));
+  int num_lines = int(CStrUtil::toInteger(argList[1]));
+
+  Strings lines(argList.begin() + 2, argList.end());
+
+  mgr_->getFile()->replaceLines(line_num, num_lines, lines);
+
+  return true;
+}
+
+bool
+CEditReplaceLinesCmd::
+exec()
+{
+  // undo and redo both swap current lines with saved lines
+  Strings lines;
+
+  lines.reserve(num_lines_);
+
+  for (int i = 0; i < num_lines_; ++i)
+    lines.push_back(mgr_->getFile()->getEditLine(line_num_ + i)->getString());
+
+  if (mgr_->getDebug())
+    std::cerr << "Exec: Replace Lines " << line_num_ << " " << num_lines_ << " " <<
+                 lines_.size() << "\n";
+
+  mgr_->getFile()->replaceLines(line_num_, num_lines_, lines_);
+
+  num_lines_ = int(lines_.size());
+
+  lines_.swap(lines);
+
+  return true;
+}
+
+//------
+
 CEditMoveToCmd::
 CEditMoveToCmd(CEditCmdMgr *mgr) :
  CEditCmd(mgr)
@@ -154,6 +154,25 @@ class CEditInsertCharCmd : public CEditCmd {
 
 //---
 
+class CEditInsertCharsCmd : public CEditCmd {
+ public:
+  CEditInsertCharsCmd(CEditCmdMgr *mgr);
+
+  CEditInsertCharsCmd(CEditCmdMgr *mgr, int line_num, int char_num, const std::string &chars);
+
+  const char *getName() const override { return "insert_chars"; }
+
+  bool exec(const std::vector<std::string> &argList) override;
+  bool exec() override;
+
+ private:
+  int         line_num_ { 0 };
+  int         char_num_ { 0 };
+  std::string chars_;
+};
+
+//---
+
 class CEditReplaceCharCmd : public CEditCmd {
  public:
   CEditReplaceCharCmd(CEditCmdMgr *mgr);
@@ -228,6 +247,30 @@ class CEditJoinLineCmd : public CEditCmd {
 
 //---
 
+// swap num_lines lines at line_num with saved lines (bulk line delete, join
+// and shift are one entry of this whatever the number of lines)
+class CEditReplaceLinesCmd : public CEditCmd {
+ public:
+  using Strings = std::vector<std::string>;
+
+ public:
+  CEditReplaceLinesCmd(CEditCmdMgr *mgr);
+
+  CEditReplaceLinesCmd(CEditCmdMgr *mgr, int line_num, int num_lines, const Strings &lines);
+
+  const char *getName() const override { return "replace_lines"; }
+
+  bool exec(const std::vector<std::string> &argList) override;
+  bool exec() override;
+
+ private:
+  int     line_num_  { 0 };
+  int     num_lines_ { 0 };
+  Strings lines_;
+};
+
+//---
+
 class CEditMoveToCmd : public CEditCmd {
  public:
   CEditMoveToCmd(CEditCmdMgr *mgr);
@@ -8,6 +8,10 @@
 #include <CRegExp.h>
 #include <CStrUtil.h>
 #include <CAssert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
 
 CEditFile::
@@ -398,6 +402,8 @@ subAddLine(uint line_num, CEditLine *line)
 {
   lines_.addLine(line_num, line);
 
+  lineAdded(line_num);
+
   addUndo(new CEditDeleteLineCmd(&cmdMgr_, line_num));
 
   setChanged(true);
@@ -419,6 +425,8 @@ subAddChars(uint line_num, uint char_num, const std::string &chars)
 {
   lines_.addLineChars(line_num, char_num, chars);
 
+  lineChanged(line_num);
+
   addUndo(new CEditDeleteCharsCmd(&cmdMgr_, line_num, char_num, uint(chars.size())));
 
   setChanged(true);
@@ -444,6 +452,9 @@ subMoveLine(uint line_num1, int line_num2)
 {
   lines_.moveLine(line_num1, line_num2);
 
+  lineDeleted(line_num1);
+  lineAdded  (line_num2 > int(line_num1) ? line_num2 : line_num2 + 1);
+
   addUndo(new CEditMoveLineCmd(&cmdMgr_, line_num2, line_num1 - 1));
 
   setChanged(true);
@@ -513,12 +524,40 @@ subDeleteLine(uint line_num)
 
   lines_.deleteLine(line_num);
 
+  lineDeleted(line_num);
+
   addUndo(new CEditAddLineCmd(&cmdMgr_, line_num, str));
 
   setChanged(true);
   setUnsaved(true);
 }
 
+void
+CEditFile::
+deleteLines(uint line_num, uint n)
+{
+  if (! CASSERT(line_num < getNumLines(), "Invalid Line Num")) return;
+
+  n = std::min(n, getNumLines() - line_num);
+
+  if (n == 0)
+    return;
+
+  startGroup();
+
+  yankLines('\0', line_num, n);
+
+  // keep one empty line if all lines deleted
+  StringList strs;
+
+  if (n == getNumLines())
+    strs.push_back("");
+
+  subReplaceLines(line_num, n, strs);
+
+  endGroup();
+}
+
 void
 CEditFile::
 deleteWord()
@@ -567,8 +606,7 @@ deleteTo(uint line_num1, uint char_num1, uint line_num2, uint char_num2)
 
     deleteChars(line_num1, char_num1, num);
 
-    for (uint i = 0; i < line_num2 - line_num1 - 1; ++i)
-      deleteLine(line_num1 + i + 1);
+    deleteLines(line_num1 + 1, line_num2 - line_num1 - 1);
 
     cursorDown(1);
 
@@ -579,8 +617,7 @@ deleteTo(uint line_num1, uint char_num1, uint line_num2, uint char_num2)
   else if (line_num2 < line_num1) {
     deleteChars(line_num1, 0, char_num1);
 
-    for (uint i = 0; i < line_num1 - line_num2 - 1; ++i)
-      deleteLine(line_num2 + i + 1);
+    deleteLines(line_num2 + 1, line_num1 - line_num2 - 1);
 
     cursorUp(1);
 
@@ -649,6 +686,38 @@ deleteChars(uint line_num, uint char_num, uint n)
   endGroup();
 }
 
+void
+CEditFile::
+deleteCharsRight(uint n)
+{
+  uint line_num = getRow();
+  uint char_num = getCol();
+
+  uint len = getEditLine(line_num)->getLength();
+
+  if (char_num >= len)
+    return;
+
+  deleteChars(line_num, char_num, std::min(n, len - char_num));
+}
+
+void
+CEditFile::
+deleteCharsLeft(uint n)
+{
+  uint line_num = getRow();
+  uint char_num = getCol();
+
+  n = std::min(n, char_num);
+
+  if (n == 0)
+    return;
+
+  cursorLeft(n);
+
+  deleteChars(line_num, char_num - n, n);
+}
+
 void
 CEditFile::
 subDeleteChars(uint line_num, uint char_num, uint n)
@@ -657,14 +726,14 @@ subDeleteChars(uint line_num, uint char_num, uint n)
 
   CASSERT(char_num + n <= line->getLength(), "Invalid Number of Chars");
 
-  for (uint i = 0; i < n; ++i) {
-    char c = line->getChar(char_num + i);
-
-    addUndo(new CEditInsertCharCmd(&cmdMgr_, line_num, char_num, c));
-  }
+  if (n > 0)
+    addUndo(new CEditInsertCharsCmd(&cmdMgr_, line_num, char_num,
+                                    line->getSubString(char_num, char_num + n - 1)));
 
   lines_.deleteLineChars(line_num, char_num, n);
 
+  lineChanged(line_num);
+
   fixPos();
 
   setChanged(true);
@@ -1024,6 +1093,8 @@ setChar(uint line_num, uint char_num, char c)
   CASSERT(line_num < getNumLines(), "Invalid Line Num");
 
   lines_.setLineChar(line_num, char_num, c);
+
+  lineChanged(line_num);
 }
 
 //---
@@ -1064,6 +1135,8 @@ subInsertChar(uint line_num, uint char_num, char c)
 
   lines_.addLineChar(line_num, char_num, c);
 
+  lineChanged(line_num);
+
   addUndo(new CEditDeleteCharsCmd(&cmdMgr_, line_num, char_num, 1));
 
   setChanged(true);
@@ -1110,6 +1183,8 @@ subReplaceChar(uint line_num, uint char_num, char c)
 
   lines_.replaceLineChar(line_num, char_num, c);
 
+  lineChanged(line_num);
+
   addUndo(new CEditReplaceCharCmd(&cmdMgr_, line_num, char_num, c1));
 
   setChanged(true);
@@ -1146,6 +1221,9 @@ subSplitLine(uint line_num, uint char_num)
 
   lines_.splitLine(line_num, char_num);
 
+  lineChanged(line_num);
+  lineAdded  (line_num + 1);
+
   addUndo(new CEditJoinLineCmd(&cmdMgr_, line_num));
 
   setChanged(true);
@@ -1187,11 +1265,104 @@ subJoinLine(uint line_num)
 
   lines_.joinLine(line_num);
 
+  lineChanged(line_num);
+
   addUndo(new CEditSplitLineCmd(&cmdMgr_, line_num, len1));
 
   subDeleteLine(line_num + 1);
 }
 
+void
+CEditFile::
+joinLines(uint line_num, uint n)
+{
+  if (! CASSERT(line_num < getNumLines(), "Invalid Line Num")) return;
+
+  n = std::min(n, getNumLines() - line_num - 1);
+
+  if (n == 0)
+    return;
+
+  std::string str;
+
+  for (uint i = 0; i <= n; ++i)
+    str += getEditLine(line_num + i)->getString();
+
+  replaceLines(line_num, n + 1, StringList(1, str));
+}
+
+void
+CEditFile::
+replaceLines(uint line_num, uint n, const StringList &strs)
+{
+  startGroup();
+
+  subReplaceLines(line_num, n, strs);
+
+  endGroup();
+}
+
+void
+CEditFile::
+subReplaceLines(uint line_num, uint n, const StringList &strs)
+{
+  if (! CASSERT(line_num + n <= getNumLines(), "Invalid Line Num")) return;
+
+  StringList oldStrs;
+
+  oldStrs.reserve(n);
+
+  for (uint i = 0; i < n; ++i)
+    oldStrs.push_back(getEditLine(line_num + i)->getString());
+
+  LineList lines;
+
+  lines.reserve(strs.size());
+
+  for (const auto &str : strs) {
+    auto *line = CEditMgrInst->createLine(this);
+
+    line->addChars(0, str);
+
+    lines.push_back(line);
+  }
+
+  lines_.replaceLines(line_num, n, lines);
+
+  uint m = uint(strs.size());
+
+  for (uint i = 0; i < std::min(n, m); ++i)
+    lineChanged(line_num + i);
+
+  if      (n > m)
+    linesDeleted(line_num + m, n - m);
+  else if (m > n)
+    linesAdded(line_num + n, m - n);
+
+  addUndo(new CEditReplaceLinesCmd(&cmdMgr_, line_num, m, oldStrs));
+
+  fixPos();
+
+  setChanged(true);
+  setUnsaved(true);
+}
+
+void
+CEditFile::
+linesAdded(uint line_num, uint n)
+{
+  for (uint i = 0; i < n; ++i)
+    lineAdded(line_num + i);
+}
+
+void
+CEditFile::
+linesDeleted(uint line_num, uint n)
+{
+  for (uint i = 0; i < n; ++i)
+    lineDeleted(line_num);
+}
+
 //---
 
 void
@@ -1306,7 +1477,7 @@ cursorUp(uint n, uint *line_num, uint *char_num)
       break;
     }
 
-    --(*line_num);
+    *line_num = prevVisibleLine(*line_num);
   }
 
   if (*char_num >= getLineEnd(*line_num))
@@ -1341,12 +1512,14 @@ cursorDown(uint n, uint *line_num, uint *char_num)
   bool rc = true;
 
   for (uint i = 0; i < n; ++i) {
-    if (*line_num >= getNumLines() - 1) {
+    uint line_num1 = nextVisibleLine(*line_num);
+
+    if (line_num1 >= getNumLines()) {
       rc = false;
       break;
     }
 
-    ++(*line_num);
+    *line_num = line_num1;
   }
 
   if (*char_num >= getLineEnd(*line_num))
@@ -2238,6 +2411,8 @@ subReplace(uint line_num, uint char_num1, uint char_num2, const std::string &rep
 
   lines_.replaceLineChars(line_num, char_num1, char_num2, replaceStr);
 
+  lineChanged(line_num);
+
   char_num2 = char_num1 + uint(replaceStr.size()) - 1;
 
   addUndo(new CEditReplaceCmd(&cmdMgr_, line_num, char_num1, char_num2, old));
@@ -2357,6 +2532,22 @@ inGroup() const
   return ! groupList_.empty();
 }
 
+void
+CEditFile::
+startUndoGroup()
+{
+  undo_.startGroup();
+
+  addUndo(new CEditMoveToCmd(&cmdMgr_, getRow(), getCol()));
+}
+
+void
+CEditFile::
+endUndoGroup()
+{
+  undo_.endGroup();
+}
+
 void
 CEditFile::
 addUndo(CEditCmd *cmd)
@@ -2411,6 +2602,8 @@ undoLine()
     cursor_->updateLastLine();
 
     lines_.replaceLineChars(last_line.row, text);
+
+    lineChanged(last_line.row);
   }
 }
 
@@ -2548,8 +2741,11 @@ runEdCmd(const std::string &str, bool &quitted)
     addMsgLine(msg);
   }
   else if (cmd == "replay") {
-    if (num_words > 1)
-      replayFile(words[1]);
+    if (num_words > 1) {
+      rc = replayFile(words[1]);
+
+      quitted = replayQuit_;
+    }
   }
   else {
     rc = ed_->execCmd(str);
@@ -2600,6 +2796,8 @@ setOptionString(const std::string &name, const std::string &arg)
     options_.shiftwidth = int(CStrUtil::toInteger(arg1));
   else if (name1 == "showmatch")
     options_.showmatch = CStrUtil::toBool(arg1);
+  else if (name1 == "wrap")
+    options_.wrap = CStrUtil::toBool(arg1);
 
   optionChanged(name1);
 }
@@ -2624,11 +2822,179 @@ optionChanged(const std::string &)
 {
 }
 
+bool
+CEditFile::
+replayFile(const std::string &filename)
+{
+  using Clock = std::chrono::steady_clock;
+
+  CFile file(filename);
+
+  if (! file.exists() || ! file.isRegular()) {
+    displayError(StringList({"Can't read '" + filename + "'"}));
+    return false;
+  }
+
+  // nested replay (replay ex command) adds to current phases
+  bool outer = (replayDepth_ == 0);
+
+  if (outer) {
+    replayPhases_.clear();
+
+    replayPhases_.push_back(CEditReplayPhase("replay"));
+
+    replayQuit_ = false;
+  }
+
+  ++replayDepth_;
+
+  auto addTime = [&](bool key, const Clock::time_point &t1) {
+    auto t2 = Clock::now();
+
+    auto &phase = replayPhases_.back();
+
+    phase.times.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+
+    if (key)
+      ++phase.numKeys;
+    else
+      ++phase.numCmds;
+  };
+
+  auto numReplayEvents = [&]() {
+    size_t n = 0;
+
+    for (const auto &phase : replayPhases_)
+      n += phase.times.size();
+
+    return n;
+  };
+
+  bool rc = true;
+
+  std::string line;
+
+  while (! replayQuit_ && file.readLine(line)) {
+    uint len = uint(line.size());
+
+    if (len == 0) continue;
+
+    // comment or phase mark (not key escapes)
+    if (line[0] == '\\' && len > 1) {
+      if (line[1] == '#')
+        continue;
+
+      if (line.substr(1, 5) == "phase" && (len == 6 || isspace(line[6]))) {
+        auto name = CStrUtil::stripSpaces(line.substr(6));
+
+        if (name == "")
+          name = "phase" + CStrUtil::toString(replayPhases_.size());
+
+        // drop unused initial phase
+        if (replayPhases_.back().times.empty())
+          replayPhases_.pop_back();
+
+        replayPhases_.push_back(CEditReplayPhase(name));
+
+        continue;
+      }
+    }
+
+    // ex command (':' prefix is not part of command) or search
+    if (line[0] == ':' || line[0] == '/') {
+      auto cmd = (line[0] == ':' ? line.substr(1) : line);
+
+      auto numEvents = numReplayEvents();
+
+      auto t1 = Clock::now();
+
+      bool quitted;
+
+      runEdCmd(cmd, quitted);
+
+      replayEvent();
+
+      // not timed if replay command (its events are)
+      if (numReplayEvents() == numEvents)
+        addTime(false, t1);
+
+      if (quitted)
+        replayQuit_ = true;
+
+      continue;
+    }
+
+    // keys
+    for (uint i = 0; i < len; ++i) {
+      char c      = line[i];
+      bool escape = false;
+
+      if (c == '\\' && i < len - 1) {
+        c      = line[++i];
+        escape = true;
+      }
+
+      auto numEvents = numReplayEvents();
+
+      auto t1 = Clock::now();
+
+      if (! replayKey(c, escape)) {
+        displayError(StringList({"Replay of keys not supported"}));
+        rc = false;
+        break;
+      }
+
+      replayEvent();
+
+      // not timed if key ran replay command (its events are)
+      if (numReplayEvents() == numEvents)
+        addTime(true, t1);
+    }
+
+    if (! rc)
+      break;
+  }
+
+  --replayDepth_;
+
+  if (outer) {
+    StringList lines;
+
+    getReplayStats(lines);
+
+    displayMessage(lines);
+  }
+
+  return rc;
+}
+
+bool
+CEditFile::
+replayKey(char, bool)
+{
+  return false;
+}
+
 void
 CEditFile::
-replayFile(const std::string &)
+getReplayStats(StringList &lines) const
 {
-  CASSERT(0, "Not Implemented");
+  char buffer[256];
+
+  for (const auto &phase : replayPhases_) {
+    if (phase.times.empty())
+      continue;
+
+    auto times = phase.sortedTimes();
+
+    snprintf(buffer, sizeof(buffer),
+             "%-12s %7u keys %5u cmds %10.3f ms  p50 %8.3f  p90 %8.3f  p99 %8.3f  max %8.3f ms",
+             phase.name.c_str(), phase.numKeys, phase.numCmds, phase.total(),
+             CEditReplayPhase::percentile(times, 0.5 ), CEditReplayPhase::percentile(times, 0.9),
+             CEditReplayPhase::percentile(times, 0.99), CEditReplayPhase::percentile(times, 1.0));
+
+    lines.push_back(buffer);
+  }
 }
 
 void
@@ -2869,14 +3235,33 @@ deleteLine(uint line_num)
     lines_[i]->setChanged(true);
 }
 
+void
+CEditFileLines::
+replaceLines(uint line_num, uint n, const LineList &lines)
+{
+  auto p = lines_.begin() + line_num;
+
+  for (uint i = 0; i < n; ++i)
+    delete p[i];
+
+  p = lines_.erase(p, p + n);
+
+  lines_.insert(p, lines.begin(), lines.end());
+
+  // following lines only move if line count changed
+  uint line_num2 = uint(n != lines.size() ? lines_.size() : line_num + lines.size());
+
+  for (uint i = line_num; i < line_num2; ++i)
+    lines_[i]->setChanged(true);
+}
+
 void
 CEditFileLines::
 deleteLineChars(uint line_num, uint char_num, uint n)
 {
   auto *line = lines_[line_num];
 
-  for (uint i = 0; i < n; ++i)
-    line->deleteChar(char_num);
+  line->deleteChars(char_num, n);
 
   line->setChanged(true);
 }
@@ -2965,3 +3350,41 @@ toEnd()
 
   return *this;
 }
+
+//------
+
+double
+CEditReplayPhase::
+total() const
+{
+  double t = 0.0;
+
+  for (auto time : times)
+    t += time;
+
+  return t;
+}
+
+CEditReplayPhase::Times
+CEditReplayPhase::
+sortedTimes() const
+{
+  auto times1 = times;
+
+  std::sort(times1.begin(), times1.end());
+
+  return times1;
+}
+
+double
+CEditReplayPhase::
+percentile(const Times &sorted, double p)
+{
+  if (sorted.empty())
+    return 0.0;
+
+  // smallest time with at least fraction p of times at or below it
+  auto rank = size_t(std::ceil(double(sorted.size())*p));
+
+  return sorted[std::min(std::max(rank, size_t(1)), sorted.size()) - 1];
+}
@@ -71,6 +71,30 @@ struct CEditBuffer {
 
 //---
 
+// latencies (ms) of events (keys or ex commands) replayed in a phase
+struct CEditReplayPhase {
+  using Times = std::vector<double>;
+
+  std::string name;
+  Times       times;
+  uint        numKeys { 0 };
+  uint        numCmds { 0 };
+
+  CEditReplayPhase(const std::string &name1="") :
+   name(name1) {
+  }
+
+  double total() const;
+
+  // times in increasing order
+  Times sortedTimes() const;
+
+  // nearest rank latency at fraction p (0-1) of sorted times
+  static double percentile(const Times &sorted, double p);
+};
+
+//---
+
 class CEditFileLines {
  public:
   using LineList = std::vector<CEditLine *>;
@@ -115,6 +139,9 @@ class CEditFileLines {
 
   void deleteLine(uint line_num);
 
+  // replace n lines at line_num with lines (one splice)
+  void replaceLines(uint line_num, uint n, const LineList &lines);
+
   void deleteLineChars(uint line_num, uint char_num, uint n);
 
  private:
@@ -135,6 +162,8 @@ class CEditFile {
   using BufferMap  = std::map<char, CEditBuffer>;
   using StringList = std::vector<std::string>;
 
+  using ReplayPhases = std::vector<CEditReplayPhase>;
+
   using const_line_iterator = LineList::const_iterator;
 
   class CharIterator {
@@ -176,6 +205,7 @@ class CEditFile {
     bool list;
     bool number;
     bool showmatch;
+    bool wrap;
     uint shiftwidth;
 
     Options() :
@@ -183,6 +213,7 @@ class CEditFile {
      list      (false),
      number    (false),
      showmatch (false),
+     wrap      (false),
      shiftwidth(2) {
     }
   };
@@ -286,6 +317,9 @@ class CEditFile {
   virtual void deleteLine();
   virtual void deleteLine(uint line_num);
 
+  // delete n lines (one undo entry)
+  virtual void deleteLines(uint line_num, uint n);
+
   void deleteWord();
   void deleteWord(uint line_num, uint char_num);
 
@@ -298,6 +332,10 @@ class CEditFile {
   void deleteChars(uint n);
   void deleteChars(uint line_num, uint char_num, uint n);
 
+  // delete up to n chars at or before cursor (clamped to line)
+  void deleteCharsRight(uint n);
+  void deleteCharsLeft (uint n);
+
   void deleteTo(uint line_num, uint char_num);
   void deleteTo(uint line_num1, uint char_num1, uint line_num2, uint char_num2);
 
@@ -333,6 +371,12 @@ class CEditFile {
   virtual void joinLine();
   virtual void joinLine(uint line_num);
 
+  // join n lines after line_num onto it (one undo entry)
+  virtual void joinLines(uint line_num, uint n);
+
+  // replace n lines at line_num with strs (one undo entry)
+  void replaceLines(uint line_num, uint n, const StringList &strs);
+
   void newLineBelow();
   void newLineAbove();
 
@@ -348,6 +392,10 @@ class CEditFile {
   bool cursorDown(uint n);
   bool cursorDown(uint n, uint *line_num, uint *char_num);
 
+  // move by screen rows (differs from cursorUp/cursorDown for wrapped lines)
+  virtual bool cursorScreenUp  (uint n) { return cursorUp  (n); }
+  virtual bool cursorScreenDown(uint n) { return cursorDown(n); }
+
   void cursorToLeft();
   void cursorToLeft(uint *line_num, uint *char_num);
 
@@ -474,6 +522,11 @@ class CEditFile {
   virtual void endGroup();
   virtual bool inGroup() const;
 
+  // undo group only (deleted text is not collected so yanks stay visible
+  // to later commands, e.g. macro playback)
+  void startUndoGroup();
+  void endUndoGroup();
+
   //---
 
   virtual void addUndo(CEditCmd *cmd);
@@ -505,7 +558,17 @@ class CEditFile {
 
   virtual CEditBuffer &getBuffer(char c='\0');
 
-  virtual void replayFile(const std::string &filename);
+  // replay session file as fast as possible timing each event. Lines are
+  // keys ('\' escapes special keys), ':' ex commands, '/' searches, '\phase
+  // <name>' marks starting a new timed phase or '\#' comments. Per phase
+  // latencies are displayed when done (also see CVEditBench -replay in
+  // src/test)
+  virtual bool replayFile(const std::string &filename);
+
+  const ReplayPhases &getReplayPhases() const { return replayPhases_; }
+
+  // one line per phase (events, total, p50, p90, p99 and max latency)
+  void getReplayStats(StringList &lines) const;
 
   void addMsgLine(const std::string &msg);
   void addErrLine(const std::string &msg);
@@ -528,10 +591,31 @@ class CEditFile {
   void subReplaceChar(uint line_num1, uint char_num, char c);
   void subSplitLine(uint line_num, uint char_num);
   void subJoinLine(uint line_num);
+  void subReplaceLines(uint line_num, uint n, const StringList &strs);
   bool subReplace(uint line_num, uint char_num1, uint char_num2, const std::string &replaceStr);
 
+  // notify line list changes (line_num is index after the change)
+  virtual void lineAdded  (uint) { }
+  virtual void lineDeleted(uint) { }
+  virtual void lineChanged(uint) { }
+
+  // notify n lines added or deleted at line_num (once for the whole range)
+  virtual void linesAdded  (uint line_num, uint n);
+  virtual void linesDeleted(uint line_num, uint n);
+
+  // visible line before/after line for cursor motion (skips lines hidden in
+  // closed folds)
+  virtual uint prevVisibleLine(uint line_num) const { return line_num - 1; }
+  virtual uint nextVisibleLine(uint line_num) const { return line_num + 1; }
+
   void fixPos();
 
+  // replay key c (escape is char after '\') : false if keys not supported
+  virtual bool replayKey(char c, bool escape);
+
+  // called after each replayed event in its timed region (e.g. to draw)
+  virtual void replayEvent() { }
+
  private:
   CEditFile(const CEditFile &rhs);
   CEditFile &operator=(const CEditFile &rhs);
@@ -573,6 +657,11 @@ class CEditFile {
 
   StringList msgLines_;
   StringList errLines_;
+
+  // replay
+  ReplayPhases replayPhases_;
+  uint         replayDepth_ { 0 };
+  bool         replayQuit_  { false }; // quit command replayed
 };
 
 #endif
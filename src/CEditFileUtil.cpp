@@ -69,27 +69,25 @@ shiftLeft(uint line_num1, uint line_num2)
 
   uint n = file_->getOptions().shiftwidth;
 
-  file_->startGroup();
+  CEditFile::StringList strs;
 
   for (uint line_num = line_num1; line_num <= line_num2; ++line_num) {
-    const auto *line = file_->getEditLine(line_num);
+    auto str = file_->getEditLine(line_num)->getString();
 
-    uint len = line->getLength();
+    uint len = uint(str.size());
 
     uint n1 = 0;
 
     for (uint j = 0; j < n && j < len; ++j) {
-      char c = line->getChar(j);
-
-      if (! isspace(c)) break;
+      if (! isspace(str[j])) break;
 
       ++n1;
     }
 
-    file_->deleteChars(line_num, 0, n1);
+    strs.push_back(str.substr(n1));
   }
 
-  file_->endGroup();
+  file_->replaceLines(line_num1, uint(strs.size()), strs);
 }
 
 void
@@ -99,24 +97,20 @@ shiftRight(uint line_num1, uint line_num2)
   if (line_num1 > line_num2)
     std::swap(line_num1, line_num2);
 
-  std::string chars;
-
-  uint n = file_->getOptions().shiftwidth;
+  std::string chars(file_->getOptions().shiftwidth, ' ');
 
-  for (uint j = 0; j < n; ++j)
-    chars += " ";
-
-  file_->startGroup();
+  CEditFile::StringList strs;
 
   for (uint line_num = line_num1; line_num <= line_num2; ++line_num) {
-    const auto *line = file_->getEditLine(line_num);
-
-    if (line->isEmpty()) continue;
+    auto str = file_->getEditLine(line_num)->getString();
 
-    file_->addChars(line_num, 0, chars);
+    if (str.empty())
+      strs.push_back(str);
+    else
+      strs.push_back(chars + str);
   }
 
-  file_->endGroup();
+  file_->replaceLines(line_num1, uint(strs.size()), strs);
 }
 
 void
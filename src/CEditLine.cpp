@@ -215,10 +215,9 @@ void
 CEditLine::
 deleteChars(uint pos, uint num)
 {
-  if (! CASSERT(pos < getLength() + num - 1, "Invalid Char Num")) return;
+  if (! CASSERT(pos + num <= getLength(), "Invalid Char Num")) return;
 
-  for (uint i = 0; i < num; ++i)
-    deleteChar(pos);
+  chars_.deleteChars(pos, num);
 }
 
 void
@@ -533,8 +532,13 @@ void
 CEditLineChars::
 deleteChars(uint pos, uint num)
 {
-  for (uint i = 0; i < num; ++i)
-    deleteChar(pos);
+  auto p1 = chars_.begin() + pos;
+  auto p2 = p1 + num;
+
+  for (auto p = p1; p != p2; ++p)
+    delete *p;
+
+  chars_.erase(p1, p2);
 }
 
 void
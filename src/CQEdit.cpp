@@ -25,7 +25,7 @@ init()
 
 CQEdit::
 CQEdit(QWidget *parent) :
- QWidget(parent)
+ QWidget(parent), frame_scheduler_(this, [this](uint) { updateFrame(); })
 {
   file_ = std::make_unique<CQEditFile>(this);
 
@@ -83,7 +83,7 @@ void
 CQEdit::
 draw(QPainter *painter)
 {
-  CQEditRenderer renderer(area_->getCanvas(), painter);
+  CQEditRenderer renderer(area_->getCanvas(), painter, &glyph_atlas_);
 
   CVEditMgrInst->setRenderer(&renderer);
 
@@ -96,7 +96,16 @@ void
 CQEdit::
 update()
 {
-  area_->getCanvas()->update();
+  // edit commands update many times so only redraw once all are processed
+  frame_scheduler_.schedule(1);
+}
+
+void
+CQEdit::
+updateFrame()
+{
+  if (area_)
+    area_->getCanvas()->update();
 
   emit stateChanged();
 }
@@ -414,8 +423,8 @@ itemClickedSlot(QTreeWidgetItem *item)
 //------
 
 CQEditRenderer::
-CQEditRenderer(QWidget *w, QPainter *painter) :
- w_(w), painter_(painter)
+CQEditRenderer(QWidget *w, QPainter *painter, CQGlyphAtlas *atlas) :
+ w_(w), painter_(painter), atlas_(atlas)
 {
 }
 
@@ -438,6 +447,10 @@ setFont(CFontPtr font)
 
   ascent_  = fm.ascent ();
   descent_ = fm.descent();
+
+  // atlas images are rebuilt if font changed
+  if (atlas_)
+    atlas_->setFont(qfont);
 }
 
 void
@@ -458,9 +471,7 @@ void
 CQEditRenderer::
 drawChar(const CIPoint2D &p, char c)
 {
-  std::string str(&c, 1);
-
-  drawString(p, str);
+  painter_->drawText(p.x, p.y + ascent_, QString(QLatin1Char(c)));
 }
 
 void
@@ -469,3 +480,35 @@ drawString(const CIPoint2D &p, const std::string &str)
 {
   painter_->drawText(p.x, p.y + ascent_, str.c_str());
 }
+
+void
+CQEditRenderer::
+drawRun(const CIBBox2D &bbox, const std::string &str, const CRGBA &bg,
+        const CRGBA &fg, bool filled)
+{
+  if (! filled)
+    painter_->fillRect(CQUtil::toQRect(bbox), QBrush(CQUtil::rgbaToColor(bg)));
+
+  auto qstr = QString::fromLatin1(str.c_str(), int(str.size()));
+
+  if (atlas_)
+    atlas_->drawText(painter_, bbox.getXMin(), bbox.getYMin() + ascent_ - atlas_->charAscent(),
+                     qstr, CQUtil::rgbaToColor(fg));
+  else {
+    painter_->setPen(CQUtil::rgbaToColor(fg));
+
+    painter_->drawText(bbox.getXMin(), bbox.getYMin() + ascent_, qstr);
+  }
+}
+
+void
+CQEditRenderer::
+drawNumber(const CIPoint2D &p, uint num, const CRGBA &fg)
+{
+  // digit cells blitted from atlas (no string formatting)
+  if (atlas_)
+    atlas_->drawNumber(painter_, p.x, p.y + ascent_ - atlas_->charAscent(), num, 0,
+                       CQUtil::rgbaToColor(fg));
+  else
+    CVEditRenderer::drawNumber(p, num, fg);
+}
@@ -3,6 +3,8 @@
 
 #include <CQEditFile.h>
 #include <CQWinWidget.h>
+#include <CQGlyphAtlas.h>
+#include <CQFrameScheduler.h>
 #include <CIBBox2D.h>
 #include <CEvent.h>
 
@@ -34,8 +36,11 @@ class CQEdit : public QWidget {
 
   void draw(QPainter *painter);
 
+  // request redraw and state change (coalesced to once per event loop turn)
   void update();
 
+  const CQFrameScheduler &frameScheduler() const { return frame_scheduler_; }
+
   void keyPress  (const CKeyEvent   &event);
   void keyRelease(const CKeyEvent   &event);
 
@@ -81,6 +86,9 @@ class CQEdit : public QWidget {
 
   void quitCommand();
 
+ private:
+  void updateFrame();
+
  private:
   using FileP = std::unique_ptr<CQEditFile>;
   using AreaP = std::unique_ptr<CQEditArea>;
@@ -90,6 +98,8 @@ class CQEdit : public QWidget {
   CQHistoryLineEdit* cmd_       { nullptr };
   CQEditMarks*       marks_     { nullptr };
   CQEditRegisters*   registers_ { nullptr };
+  CQGlyphAtlas       glyph_atlas_;
+  CQFrameScheduler   frame_scheduler_;
 };
 
 //---
@@ -30,6 +30,7 @@ CVEditLine.cpp \
 CVEditMgr.cpp \
 CVEditVi.cpp \
 CVLineEdit.cpp \
+CVEditSelection.cpp \
 \
 CEditChar.cpp \
 CEditCmd.cpp \
@@ -48,8 +49,18 @@ CEd.cpp \
 CSyntax.cpp \
 CSyntaxCPP.cpp \
 CSyntaxC.cpp \
+CSyntaxTable.cpp \
+CSyntaxWorker.cpp \
+CSyntaxDef.cpp \
+CSyntaxGeneric.cpp \
+CSyntaxBrackets.cpp \
+CFoldTree.cpp \
+CTabMap.cpp \
+CWrapIndex.cpp \
 \
 CQHistoryLineEdit.cpp \
+CQGlyphAtlas.cpp \
+CQFrameScheduler.cpp \
 
 HEADERS += \
 CQEditTest.h \
@@ -68,6 +79,7 @@ CVEditLine.h \
 CVEditMgr.h \
 CVEditVi.h \
 CVLineEdit.h \
+CVEditSelection.h \
 \
 CEditChar.h \
 CEditCmd.h \
@@ -88,8 +100,20 @@ CEd.h \
 CSyntax.h \
 CSyntaxCPP.h \
 CSyntaxC.h \
+CSyntaxTable.h \
+CSyntaxKeywords.h \
+CSyntaxWorker.h \
+CSyntaxDef.h \
+CSyntaxGeneric.h \
+CSyntaxBrackets.h \
+CFoldTree.h \
+CTabMap.h \
+CWrapIndex.h \
+CDigits.h \
 \
 CQHistoryLineEdit.h \
+CQGlyphAtlas.h \
+CQFrameScheduler.h \
 
 DESTDIR     = ../bin
 OBJECTS_DIR = ../obj
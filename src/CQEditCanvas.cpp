@@ -6,6 +6,8 @@
 #include <QGridLayout>
 #include <QScrollBar>
 #include <QPainter>
+#include <QPaintEvent>
+#include <cstring>
 
 CQEditArea::
 CQEditArea(CQEdit *edit) :
@@ -77,9 +79,8 @@ void
 CQEditArea::
 vscrollSlot(int y)
 {
-  edit_->getFile()->setYOffset(-y);
-
-  edit_->getFile()->setIgnoreChanged(true);
+  // moves drawn image so only exposed rows are redrawn
+  edit_->getFile()->scrollYOffset(-y);
 
   canvas_->update();
 }
@@ -95,9 +96,34 @@ CQEditCanvas(CQEditArea *area) :
   setFocusPolicy(Qt::StrongFocus);
 }
 
+bool
+CQEditCanvas::
+scrollImage(int dy, const QRect &damage, const QColor &bg)
+{
+  if (qimage_.isNull() || std::abs(dy) >= qimage_.height())
+    return false;
+
+  // move scanlines
+  int h   = qimage_.height();
+  int bpl = qimage_.bytesPerLine();
+
+  uchar *bits = qimage_.bits();
+
+  if (dy > 0)
+    memmove(bits + dy*bpl, bits, size_t(h - dy)*bpl);
+  else
+    memmove(bits, bits - dy*bpl, size_t(h + dy)*bpl);
+
+  QPainter painter(&qimage_);
+
+  painter.fillRect(damage, bg);
+
+  return true;
+}
+
 void
 CQEditCanvas::
-paintEvent(QPaintEvent *)
+paintEvent(QPaintEvent *e)
 {
   QPainter ipainter(&qimage_);
 
@@ -105,7 +131,7 @@ paintEvent(QPaintEvent *)
 
   QPainter painter(this);
 
-  painter.drawImage(QPoint(0, 0), qimage_);
+  painter.drawImage(e->rect(), qimage_, e->rect());
 
   area_->updateScrollbars();
 }
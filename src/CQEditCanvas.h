@@ -47,6 +47,9 @@ class CQEditCanvas : public QWidget {
  public:
   CQEditCanvas(CQEditArea *edit);
 
+  // move drawn image contents by dy pixels and fill damage rect
+  bool scrollImage(int dy, const QRect &damage, const QColor &bg);
+
   void paintEvent(QPaintEvent *) override;
   void resizeEvent(QResizeEvent *) override;
 
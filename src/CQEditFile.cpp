@@ -1,9 +1,12 @@
 #include <CQEditFile.h>
 #include <CQEdit.h>
+#include <CQEditCanvas.h>
+#include <CQUtil.h>
 #include <CQFont.h>
 
 #include <QApplication>
 #include <QClipboard>
+#include <QTimer>
 
 CQEditFile::
 CQEditFile(CQEdit *edit) :
@@ -70,6 +73,22 @@ update()
   edit_->update();
 }
 
+bool
+CQEditFile::
+scrollWindow(int dy, const CIBBox2D &damage)
+{
+  return edit_->getArea()->getCanvas()->scrollImage(dy, CQUtil::toQRect(damage),
+                                                   CQUtil::rgbaToColor(getBg()));
+}
+
+void
+CQEditFile::
+syntaxPending()
+{
+  // redraw shortly to pick up background highlight results
+  QTimer::singleShot(50, edit_, [this]() { update(); });
+}
+
 void
 CQEditFile::
 saveAndQuit()
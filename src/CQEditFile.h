@@ -28,6 +28,10 @@ class CQEditFile : public CVEditFile {
 
   void update();
 
+  bool scrollWindow(int dy, const CIBBox2D &damage) override;
+
+  void syntaxPending();
+
   void saveAndQuit();
 
   void quit();
@@ -4,6 +4,7 @@
 #include <CVEditMgr.h>
 
 class QPainter;
+class CQGlyphAtlas;
 
 class CQEditFactory : public CVEditFactory {
  public:
@@ -16,7 +17,7 @@ class CQEditFactory : public CVEditFactory {
 
 class CQEditRenderer : public CVEditRenderer {
  public:
-  CQEditRenderer(QWidget *w, QPainter *painter);
+  CQEditRenderer(QWidget *w, QPainter *painter, CQGlyphAtlas *atlas=nullptr);
 
  ~CQEditRenderer() { }
 
@@ -32,11 +33,17 @@ class CQEditRenderer : public CVEditRenderer {
 
   void drawString(const CIPoint2D &p, const std::string &str) override;
 
+  void drawRun(const CIBBox2D &bbox, const std::string &str, const CRGBA &bg,
+               const CRGBA &fg, bool filled) override;
+
+  void drawNumber(const CIPoint2D &p, uint num, const CRGBA &fg) override;
+
  private:
-  QWidget*  w_       { nullptr };
-  QPainter* painter_ { nullptr };
-  int       ascent_  { 10 };
-  int       descent_ { 0 };
+  QWidget*      w_       { nullptr };
+  QPainter*     painter_ { nullptr };
+  CQGlyphAtlas* atlas_   { nullptr };
+  int           ascent_  { 10 };
+  int           descent_ { 0 };
 };
 
 #endif
@@ -5,6 +5,7 @@
 #include <QComboBox>
 #include <QVBoxLayout>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QLineEdit>
 #include <QToolButton>
 
@@ -15,6 +16,7 @@
 #include <CQColorChooser.h>
 #include <CQTabWidget.h>
 #include <CQEditBg.h>
+#include <CVEditVi.h>
 #include <CQUtil.h>
 #include <CQUtilFont.h>
 #include <CQUtilRGBA.h>
@@ -85,7 +87,18 @@ addFile(const std::string &fileName)
 
   edit->getFile()->loadLines(fileName);
 
-  edit->getFile()->setSyntax(new CSyntaxCPP);
+  // syntax from file extension (language definition file if one exists for it)
+  auto *file = edit->getFile();
+
+  auto pos = fileName.rfind('.');
+  auto ext = (pos != std::string::npos ? fileName.substr(pos + 1) : std::string());
+
+  if      (ext == "c")
+    file->setOptionString("syntax", ext);
+  else if (ext != "" && QFileInfo(file->syntaxFileName(ext).c_str()).exists())
+    file->setOptionString("syntax", ext);
+  else
+    file->setSyntax(new CSyntaxCPP);
 
   connect(edit, SIGNAL(stateChanged   ()), this, SLOT(updateStatus()));
   connect(edit, SIGNAL(fileNameChanged()), this, SLOT(updateTitle ()));
@@ -553,6 +566,15 @@ updateStatus()
     mode = "Vi ";
 
     mode += (file->getInsertMode() ? "(Insert)" : "(Command)");
+
+    // recording register or last macro playback throughput
+    auto *vi = file->getVi();
+
+    if      (vi->isRecording())
+      mode += QString(" recording @%1").arg(QChar(vi->getRecordRegister()));
+    else if (vi->getPlayKeys() > 0)
+      mode += QString(" %1 keys (%2 keys/s)").
+                arg(vi->getPlayKeys()).arg(vi->getPlayRate(), 0, 'f', 0);
   }
   else
     mode = "Text";
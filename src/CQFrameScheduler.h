@@ -0,0 +1,51 @@
+#ifndef CQFRAME_SCHEDULER_H
+#define CQFRAME_SCHEDULER_H
+
+#include <sys/types.h>
+#include <functional>
+
+class QObject;
+
+// Coalesces repaint/state change requests into one flush per event loop turn.
+//
+// Requests OR their flags into a pending set and the first request of a turn
+// posts a zero timeout callback (owned by the context object) which passes
+// the accumulated flags to the flush function. Requests made while a flush
+// is pending are counted as suppressed to show how much work was saved.
+class CQFrameScheduler {
+ public:
+  using Flush = std::function<void (uint flags)>;
+
+ public:
+  CQFrameScheduler(QObject *context, const Flush &flush);
+
+  // add flags to pending set and post flush if not already pending
+  void schedule(uint flags);
+
+  // run pending flush now (e.g. before a query needing up to date state)
+  void flush();
+
+  bool isPending() const { return pending_; }
+
+  uint pendingFlags() const { return flags_; }
+
+  //---
+
+  // statistics
+  uint numRequests  () const { return numRequests_  ; }
+  uint numFlushes   () const { return numFlushes_   ; }
+  uint numSuppressed() const { return numSuppressed_; }
+
+  void resetStats();
+
+ private:
+  QObject* context_       { nullptr };
+  Flush    flush_;
+  uint     flags_         { 0 };
+  bool     pending_       { false };
+  uint     numRequests_   { 0 };
+  uint     numFlushes_    { 0 };
+  uint     numSuppressed_ { 0 };
+};
+
+#endif
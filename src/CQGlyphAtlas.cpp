@@ -0,0 +1,175 @@
+#include <CQGlyphAtlas.h>
+#include <CDigits.h>
+
+#include <QPainter>
+#include <QFontInfo>
+#include <QFontMetrics>
+
+namespace {
+
+// limit number of cached colors (token colors plus a few selection colors)
+const uint MAX_COLOR_IMAGES = 64;
+
+}
+
+CQGlyphAtlas::
+CQGlyphAtlas()
+{
+}
+
+void
+CQGlyphAtlas::
+setFont(const QFont &font)
+{
+  if (fontSet_ && font == font_)
+    return;
+
+  font_    = font;
+  fontSet_ = true;
+
+  QFontMetrics fm(font_);
+
+  fixedPitch_ = QFontInfo(font_).fixedPitch();
+  charWidth_  = fm.horizontalAdvance("X");
+  charAscent_ = fm.ascent();
+  charHeight_ = fm.ascent() + fm.descent();
+
+  // font info can report false for some fixed width fonts so also compare widths
+  if (! fixedPitch_)
+    fixedPitch_ = (fm.horizontalAdvance("i") == charWidth_ &&
+                   fm.horizontalAdvance("W") == charWidth_);
+
+  clear();
+}
+
+void
+CQGlyphAtlas::
+clear()
+{
+  images_.clear();
+}
+
+void
+CQGlyphAtlas::
+drawText(QPainter *painter, int x, int y, const QString &str, const QColor &c)
+{
+  if (! fixedPitch_) {
+    painter->setPen(c);
+    painter->drawText(x, y + charAscent_, str);
+    return;
+  }
+
+  // images are drawn at device resolution
+  qreal dpr = (painter->device() ? painter->device()->devicePixelRatioF() : 1.0);
+
+  if (dpr != dpr_) {
+    dpr_ = dpr;
+
+    clear();
+  }
+
+  const QImage &image = colorImage(c);
+
+  bool penSet = false;
+
+  int n = str.size();
+
+  for (int i = 0; i < n; ++i, x += charWidth_) {
+    ushort uc = str[i].unicode();
+
+    if (uc == ' ')
+      continue;
+
+    if (uc >= FIRST_CHAR && uc <= LAST_CHAR) {
+      QRectF source((uc - FIRST_CHAR)*charWidth_*dpr_, 0, charWidth_*dpr_, charHeight_*dpr_);
+
+      painter->drawImage(QRectF(x, y, charWidth_, charHeight_), image, source);
+    }
+    else {
+      if (! penSet) {
+        painter->setPen(c);
+
+        penSet = true;
+      }
+
+      painter->drawText(x, y + charAscent_, QString(str[i]));
+    }
+  }
+}
+
+void
+CQGlyphAtlas::
+drawNumber(QPainter *painter, int x, int y, uint num, int width, const QColor &c)
+{
+  int n = CDigits::numDigits(num);
+
+  if (width > n)
+    x += (width - n)*charWidth_;
+
+  if (! fixedPitch_) {
+    painter->setPen(c);
+    painter->drawText(x, y + charAscent_, QString::number(num));
+    return;
+  }
+
+  qreal dpr = (painter->device() ? painter->device()->devicePixelRatioF() : 1.0);
+
+  if (dpr != dpr_) {
+    dpr_ = dpr;
+
+    clear();
+  }
+
+  const QImage &image = colorImage(c);
+
+  // blit digit cells from least significant (rightmost) digit
+  x += (n - 1)*charWidth_;
+
+  for (int i = 0; i < n; ++i, x -= charWidth_, num /= 10) {
+    int uc = '0' + int(num % 10);
+
+    QRectF source((uc - FIRST_CHAR)*charWidth_*dpr_, 0, charWidth_*dpr_, charHeight_*dpr_);
+
+    painter->drawImage(QRectF(x, y, charWidth_, charHeight_), image, source);
+  }
+}
+
+const QImage &
+CQGlyphAtlas::
+colorImage(const QColor &c)
+{
+  auto p = images_.find(c.rgba());
+
+  if (p != images_.end())
+    return (*p).second;
+
+  if (images_.size() >= MAX_COLOR_IMAGES)
+    clear();
+
+  // one row of cells for printable chars
+  int numChars = LAST_CHAR - FIRST_CHAR + 1;
+
+  QImage image(int(numChars*charWidth_*dpr_), int(charHeight_*dpr_),
+               QImage::Format_ARGB32_Premultiplied);
+
+  image.setDevicePixelRatio(dpr_);
+
+  image.fill(Qt::transparent);
+
+  QPainter painter(&image);
+
+  painter.setFont(font_);
+  painter.setPen (c);
+
+  for (int i = 0; i < numChars; ++i) {
+    QRect cell(i*charWidth_, 0, charWidth_, charHeight_);
+
+    painter.setClipRect(cell);
+
+    painter.drawText(cell.x(), charAscent_, QString(QChar(FIRST_CHAR + i)));
+  }
+
+  painter.end();
+
+  return (images_[c.rgba()] = image);
+}
@@ -0,0 +1,59 @@
+#ifndef CQGLYPH_ATLAS_H
+#define CQGLYPH_ATLAS_H
+
+#include <QFont>
+#include <QImage>
+#include <QColor>
+#include <map>
+
+class QPainter;
+
+// Pre-rasterized printable ASCII glyphs of a fixed width font.
+//
+// One image per text color holds a cell for each printable ASCII char so a
+// string is drawn by blitting cells instead of shaping text. Other chars (and
+// all chars of a proportional font) are drawn with QPainter::drawText. The
+// images are discarded when the font or device pixel ratio changes.
+class CQGlyphAtlas {
+ public:
+  CQGlyphAtlas();
+
+  // set font (clears atlas if different)
+  void setFont(const QFont &font);
+
+  const QFont &font() const { return font_; }
+
+  int charWidth () const { return charWidth_ ; }
+  int charHeight() const { return charHeight_; }
+  int charAscent() const { return charAscent_; }
+
+  void clear();
+
+  // draw string with top left at x, y (one cell per char)
+  void drawText(QPainter *painter, int x, int y, const QString &str, const QColor &c);
+
+  // draw number right aligned in width cells (0 for number's digits) without
+  // formatting a string (e.g. line number gutter)
+  void drawNumber(QPainter *painter, int x, int y, uint num, int width, const QColor &c);
+
+ private:
+  static const int FIRST_CHAR = 33;  // '!'
+  static const int LAST_CHAR  = 126; // '~'
+
+  using ColorImages = std::map<QRgb, QImage>;
+
+ private:
+  const QImage &colorImage(const QColor &c);
+
+ private:
+  QFont       font_;
+  bool        fontSet_    { false };
+  bool        fixedPitch_ { false };
+  int         charWidth_  { 8 };
+  int         charHeight_ { 12 };
+  int         charAscent_ { 10 };
+  qreal       dpr_        { 1.0 };
+  ColorImages images_;
+};
+
+#endif
@@ -37,6 +37,33 @@ parseFile(CFile *file)
   term();
 }
 
+void
+CSyntax::
+parse(CSyntaxLineIterator &lines)
+{
+  uint             line_num;
+  std::string_view line;
+
+  while (lines.nextLine(line_num, line)) {
+    line_num_ = line_num;
+
+    processLine(line);
+  }
+}
+
+void
+CSyntax::
+parseText(const std::string_view &text)
+{
+  init();
+
+  CSyntaxTextLines lines(text);
+
+  parse(lines);
+
+  term();
+}
+
 void
 CSyntax::
 init()
@@ -89,3 +116,43 @@ addText(uint line_num, uint word_start, const std::string &word)
   if (notifier_)
     notifier_->addText(line_num, word_start, word);
 }
+
+void
+CSyntax::
+addSpans(uint line_num, const std::string_view &line, const CSyntaxSpans &spans)
+{
+  if (notifier_)
+    notifier_->addSpans(line_num, line, spans);
+  else {
+    for (const auto &span : spans)
+      std::cerr << line_num << ":" << span.start << ">" <<
+                   line.substr(span.start, span.len) << std::endl;
+  }
+}
+
+//---
+
+bool
+CSyntaxTextLines::
+nextLine(uint &line_num, std::string_view &line)
+{
+  if (pos_ >= text_.size())
+    return false;
+
+  size_t end = text_.find('\n', pos_);
+
+  if (end == std::string_view::npos)
+    end = text_.size();
+
+  line = text_.substr(pos_, end - pos_);
+
+  // dos line ending
+  if (! line.empty() && line.back() == '\r')
+    line.remove_suffix(1);
+
+  line_num = line_num_++;
+
+  pos_ = end + 1;
+
+  return true;
+}
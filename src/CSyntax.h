@@ -2,6 +2,8 @@
 #define CSYNTAX_H
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <sys/types.h>
 
 enum class CSyntaxToken {
@@ -12,8 +14,67 @@ enum class CSyntaxToken {
   COMMENT
 };
 
+// token span of line
+struct CSyntaxSpan {
+  uint         start { 0 };
+  uint         len   { 0 };
+  CSyntaxToken token { CSyntaxToken::NONE };
+};
+
+using CSyntaxSpans = std::vector<CSyntaxSpan>;
+
 class CFile;
 
+// source of lines for CSyntax::parse. Lines are returned as views into the
+// source's own storage (valid until the next call) so no line is copied
+class CSyntaxLineIterator {
+ public:
+  virtual ~CSyntaxLineIterator() { }
+
+  // get next line to process and its number (false when done)
+  virtual bool nextLine(uint &line_num, std::string_view &line) = 0;
+};
+
+// lines of text buffer (e.g. mapped file) split at newlines
+class CSyntaxTextLines : public CSyntaxLineIterator {
+ public:
+  CSyntaxTextLines(const std::string_view &text, uint line_num=0) :
+   text_(text), line_num_(line_num) {
+  }
+
+  bool nextLine(uint &line_num, std::string_view &line) override;
+
+ private:
+  std::string_view text_;
+  size_t           pos_      { 0 };
+  uint             line_num_ { 0 };
+};
+
+// lines line_num1 to line_num2 of random access source (getLine(i) returns
+// view of line i)
+template<typename GetLine>
+class CSyntaxLineRange : public CSyntaxLineIterator {
+ public:
+  CSyntaxLineRange(uint line_num1, uint line_num2, const GetLine &getLine) :
+   line_num_(line_num1), line_num2_(line_num2), getLine_(getLine) {
+  }
+
+  bool nextLine(uint &line_num, std::string_view &line) override {
+    if (line_num_ > line_num2_)
+      return false;
+
+    line_num = line_num_;
+    line     = getLine_(line_num_++);
+
+    return true;
+  }
+
+ private:
+  uint    line_num_  { 0 };
+  uint    line_num2_ { 0 };
+  GetLine getLine_;
+};
+
 class CSyntaxNotifier {
  public:
   virtual ~CSyntaxNotifier() { }
@@ -28,6 +89,12 @@ class CSyntaxNotifier {
                         const std::string &word, CSyntaxToken token) = 0;
 
   virtual void addText(uint, uint, const std::string &) { }
+
+  // all tokens of line (default calls addToken for each)
+  virtual void addSpans(uint line_num, const std::string_view &line, const CSyntaxSpans &spans) {
+    for (const auto &span : spans)
+      addToken(line_num, span.start, std::string(line.substr(span.start, span.len)), span.token);
+  }
 };
 
 class CSyntax {
@@ -40,12 +107,29 @@ class CSyntax {
 
   void parseFile(CFile *file);
 
+  // process lines from iterator continuing from current lexer state (init
+  // and term are left to caller so a range can be parsed)
+  void parse(CSyntaxLineIterator &lines);
+
+  // process all lines of text buffer
+  void parseText(const std::string_view &text);
+
+  uint lineNum() const { return line_num_; }
+  void setLineNum(uint line_num) { line_num_ = line_num; }
+
+  // lexer state at end of last processed line (zero for stateless lexers)
+  virtual uint getState() const { return 0; }
+  virtual void setState(uint) { }
+
+  // copy of lexer and its state for use on another thread (null if not supported)
+  virtual CSyntax *dup() const { return nullptr; }
+
   virtual void init();
   virtual void term();
 
   virtual void preProcessLine(const std::string &line);
 
-  virtual void processLine(const std::string &line) = 0;
+  virtual void processLine(const std::string_view &line) = 0;
 
   virtual void postProcessLine(const std::string &line);
 
@@ -54,6 +138,8 @@ class CSyntax {
 
   virtual void addText(uint line_num, uint word_start, const std::string &text);
 
+  virtual void addSpans(uint line_num, const std::string_view &line, const CSyntaxSpans &spans);
+
  protected:
   uint             line_num_ { 0 };
   CSyntaxNotifier *notifier_ { nullptr };
@@ -1,24 +1,15 @@
 #ifndef CSYNTAX_C_H
 #define CSYNTAX_C_H
 
-#include <CSyntax.h>
+#include <CSyntaxTable.h>
 
-class CFile;
-
-class CSyntaxC : public CSyntax {
+class CSyntaxC : public CSyntaxTable {
  public:
   CSyntaxC();
 
   virtual ~CSyntaxC();
 
-  void processLine(const std::string &line) override;
-
- private:
-  CSyntaxToken findWord(const std::string &str);
-
- private:
-  bool         continued_ { false };
-  CSyntaxToken last_token_;
+  CSyntax *dup() const override { return new CSyntaxC(*this); }
 };
 
 #endif
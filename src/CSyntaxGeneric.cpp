@@ -0,0 +1,26 @@
+#include <CSyntaxGeneric.h>
+
+CSyntaxGeneric *
+CSyntaxGeneric::
+load(const std::string &fileName, std::string &msg)
+{
+  auto syntaxDef = std::make_shared<CSyntaxDef>();
+
+  if (! syntaxDef->load(fileName)) {
+    msg = syntaxDef->errorMsg();
+    return nullptr;
+  }
+
+  return new CSyntaxGeneric(syntaxDef);
+}
+
+CSyntaxGeneric::
+CSyntaxGeneric(const DefP &syntaxDef) :
+ CSyntaxTable(syntaxDef->def()), syntax_def_(syntaxDef)
+{
+}
+
+CSyntaxGeneric::
+~CSyntaxGeneric()
+{
+}
@@ -0,0 +1,141 @@
+#ifndef CSYNTAX_KEYWORDS_H
+#define CSYNTAX_KEYWORDS_H
+
+#include <CSyntax.h>
+#include <string_view>
+#include <cstring>
+#include <cstddef>
+
+// Keyword lookup using a perfect hash table generated at compile time.
+//
+// A word is resolved with one hash, one table index and one compare. The
+// table is plain data (no heap allocation or startup initialization).
+//
+// Usage:
+//   static constexpr std::string_view keywords[] = { "if", "else", ... };
+//   static constexpr CSyntaxKeywordHash keywordHash(keywords);
+//   ... keywordHash.keywords().find(str, len) ...
+
+namespace CSyntaxKeywordUtil {
+
+constexpr char lower(char c) {
+  return (c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c);
+}
+
+constexpr uint hash(const char *str, uint len, uint seed, bool case_sensitive) {
+  uint h = seed ^ (len*0x9e3779b9u);
+
+  for (uint i = 0; i < len; ++i) {
+    char c = (case_sensitive ? str[i] : lower(str[i]));
+
+    h = (h ^ uint((unsigned char) c))*16777619u;
+  }
+
+  return h ^ (h >> 15);
+}
+
+constexpr std::size_t tableSize(std::size_t n) {
+  // power of two with plenty of space so a seed is found quickly
+  std::size_t size = 16;
+
+  while (size < 16*n)
+    size *= 2;
+
+  return size;
+}
+
+}
+
+//---
+
+// view of a generated table (what the lexer uses)
+struct CSyntaxKeywords {
+  const std::string_view *keywords       { nullptr };
+  const unsigned char    *slots          { nullptr }; // keyword index + 1 (0 if empty)
+  uint                    mask           { 0 };
+  uint                    seed           { 0 };
+  bool                    case_sensitive { true };
+
+  CSyntaxToken find(const char *str, uint len) const {
+    if (! slots) return CSyntaxToken::NONE;
+
+    uint ind = slots[CSyntaxKeywordUtil::hash(str, len, seed, case_sensitive) & mask];
+    if (! ind) return CSyntaxToken::NONE;
+
+    const auto &keyword = keywords[ind - 1];
+    if (keyword.size() != len) return CSyntaxToken::NONE;
+
+    if (case_sensitive) {
+      if (memcmp(keyword.data(), str, len) != 0)
+        return CSyntaxToken::NONE;
+    }
+    else {
+      for (uint i = 0; i < len; ++i)
+        if (keyword[i] != CSyntaxKeywordUtil::lower(str[i]))
+          return CSyntaxToken::NONE;
+    }
+
+    return CSyntaxToken::KEYWORD;
+  }
+};
+
+//---
+
+// compile time perfect hash table for N keywords (lower case if case insensitive)
+template<std::size_t N, bool CASE_SENSITIVE=true>
+class CSyntaxKeywordHash {
+ public:
+  static constexpr std::size_t SIZE = CSyntaxKeywordUtil::tableSize(N);
+
+  static_assert(N < 255, "too many keywords");
+
+  constexpr CSyntaxKeywordHash(const std::string_view (&keywords)[N]) :
+   keywords_(keywords) {
+    // find seed which maps every keyword to its own slot
+    for (uint seed = 1; ; ++seed) {
+      if (build(seed)) {
+        seed_ = seed;
+        break;
+      }
+
+      if (seed > 100000)
+        throw "no perfect hash for keywords (duplicate keyword ?)";
+    }
+  }
+
+  constexpr CSyntaxKeywords keywords() const {
+    return CSyntaxKeywords { keywords_, slots_, uint(SIZE - 1), seed_, CASE_SENSITIVE };
+  }
+
+ private:
+  constexpr bool build(uint seed) {
+    uint used[N] { };
+
+    for (std::size_t i = 0; i < N; ++i) {
+      const auto &keyword = keywords_[i];
+
+      uint h = CSyntaxKeywordUtil::hash(keyword.data(), uint(keyword.size()),
+                                        seed, CASE_SENSITIVE) & uint(SIZE - 1);
+
+      if (slots_[h]) {
+        // collision so clear slots set by this seed
+        for (std::size_t j = 0; j < i; ++j)
+          slots_[used[j]] = 0;
+
+        return false;
+      }
+
+      slots_[h] = (unsigned char) (i + 1);
+      used  [i] = h;
+    }
+
+    return true;
+  }
+
+ private:
+  const std::string_view *keywords_ { nullptr };
+  unsigned char           slots_[SIZE] { };
+  uint                    seed_ { 0 };
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef CSYNTAX_TABLE_H
+#define CSYNTAX_TABLE_H
+
+#include <CSyntaxKeywords.h>
+#include <vector>
+
+// Table driven lexer core.
+//
+// A language is described by a Def (keywords, comment and string delimiters,
+// preprocessor prefix) which is compiled into per character action and class
+// tables. Lines are scanned into (start, length, token) spans without building
+// strings.
+class CSyntaxTable : public CSyntax {
+ public:
+  // language description
+  struct Def {
+    const char        *name                { "" };
+    CSyntaxKeywords    keywords;                        // keyword hash table
+    const char        *line_comment        { nullptr }; // comment to end of line
+    const char        *block_comment_start { nullptr }; // multi-line comment
+    const char        *block_comment_end   { nullptr };
+    const char        *quotes              { "" };      // string delimiter chars
+    char               prepro              { '\0' };    // preprocessor line prefix
+  };
+
+  using Span  = CSyntaxSpan;
+  using Spans = CSyntaxSpans;
+
+  // state carried between lines
+  enum State {
+    STATE_NORMAL        = 0,
+    STATE_BLOCK_COMMENT = 1,
+    STATE_PREPRO        = 2 // continued preprocessor line
+  };
+
+ public:
+  CSyntaxTable(const Def &def);
+
+  virtual ~CSyntaxTable();
+
+  const Def &def() const { return def_; }
+
+  uint getState() const override { return state_; }
+  void setState(uint state) override { state_ = state; }
+
+  void init() override;
+
+  void processLine(const std::string_view &line) override;
+
+  // lex line into spans (spans are cleared first, reuse to avoid allocation)
+  void lexLine(const char *str, uint len, Spans &spans);
+
+  CSyntaxToken findWord(const char *str, uint len) const {
+    return def_.keywords.find(str, len);
+  }
+
+ protected:
+  // spans of last processed line
+  const Spans &spans() const { return spans_; }
+
+ private:
+  enum Action : unsigned char {
+    ACTION_TEXT,
+    ACTION_SPACE,
+    ACTION_WORD,
+    ACTION_STRING,
+    ACTION_COMMENT
+  };
+
+  bool matchAt(const char *str, uint len, uint i, const char *delim) const;
+
+  bool findBlockEnd(const char *str, uint len, uint i, uint &end) const;
+
+ private:
+  Def           def_;
+  unsigned char action_[256];
+  bool          word_[256];               // identifier (non-start) chars
+  uint          state_ { STATE_NORMAL };
+  Spans         spans_;
+};
+
+#endif
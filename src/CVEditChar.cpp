@@ -4,7 +4,7 @@
 
 CVEditChar::
 CVEditChar() :
- CEditChar(), selected_(false)
+ CEditChar()
 {
 }
 
@@ -56,33 +56,36 @@ setFg(const CVEditLine *, const CRGBA &fg)
 
 void
 CVEditChar::
-setSelected(bool selected)
+getDrawColors(const CVEditLine *line, bool selected, bool filled, CRGBA &bg1, CRGBA &fg1,
+              bool &filled1) const
 {
-  selected_ = selected;
+  filled1 = filled;
 
-  setChanged(true);
-}
-
-void
-CVEditChar::
-draw(CVEditFile *file, const CVEditLine *line, const CIBBox2D &bbox, bool filled)
-{
-  CRGBA bg1, fg1;
-
-  if (selected_) {
+  if (selected) {
     bg1 = getFg(line);
 
-    filled = false;
+    filled1 = false;
   }
   else {
     if (! filled)
       bg1 = getBg(line);
   }
 
-  if (selected_)
+  if (selected)
     fg1 = getBg(line);
   else
     fg1 = getFg(line);
+}
+
+void
+CVEditChar::
+draw(CVEditFile *file, const CVEditLine *line, const CIBBox2D &bbox, bool selected,
+     bool filled)
+{
+  CRGBA bg1, fg1;
+  bool  filled1;
+
+  getDrawColors(line, selected, filled, bg1, fg1, filled1);
 
-  file->drawFilledChar(bbox, getChar(), bg1, fg1, filled);
+  file->drawFilledChar(bbox, getChar(), bg1, fg1, filled1);
 }
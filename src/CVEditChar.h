@@ -29,16 +29,17 @@ class CVEditChar : public CEditChar {
   const CRGBA &getFg(const CVEditLine *vline) const;
   virtual void setFg(const CVEditLine *vline, const CRGBA &fg);
 
-  // Selected
-  bool getSelected() const { return selected_; }
-  virtual void setSelected(bool selected);
+  // colors to draw char with in line (selected chars are inverted, filled is
+  // whether bg is already filled)
+  void getDrawColors(const CVEditLine *vline, bool selected, bool filled, CRGBA &bg,
+                     CRGBA &fg, bool &filled1) const;
 
   // Draw
-  virtual void draw(CVEditFile *file, const CVEditLine *vline, const CIBBox2D &bbox, bool fill);
+  virtual void draw(CVEditFile *file, const CVEditLine *vline, const CIBBox2D &bbox,
+                    bool selected, bool fill);
 
  private:
   CVEditCharStyle style_;
-  bool            selected_ { false };
 };
 
 #endif
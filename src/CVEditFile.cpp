@@ -8,9 +8,147 @@
 #include <CEvent.h>
 #include <CFontMgr.h>
 #include <CStrUtil.h>
-#include <CSyntax.h>
+#include <CSyntaxWorker.h>
+#include <CSyntaxBrackets.h>
+#include <CDigits.h>
+#include <CSyntaxC.h>
+#include <CSyntaxCPP.h>
+#include <CSyntaxGeneric.h>
 #include <CRGBName.h>
 #include <CAssert.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// adds syntax token colors to line annotations
+class CVEditFileSyntaxNotifier : public CSyntaxNotifier {
+ public:
+  CVEditFileSyntaxNotifier(CSyntaxBrackets *brackets=nullptr) :
+   brackets_(brackets) {
+    bg_ = CRGBA(0, 0, 0);
+
+    fg_[int(CSyntaxToken::PREPRO )] = CRGBA(1.0, 0.5, 1.0);
+    fg_[int(CSyntaxToken::KEYWORD)] = CRGBA(1.0, 1.0, 0.5);
+    fg_[int(CSyntaxToken::STRING )] = CRGBA(1.0, 0.5, 0.0);
+    fg_[int(CSyntaxToken::COMMENT)] = CRGBA(0.5, 0.5, 1.0);
+  }
+
+  void setLine(CVEditLine *line) {
+    line_ = line;
+  }
+
+  void addToken(uint, uint word_start, const std::string &word, CSyntaxToken token) override {
+    addSpan(word_start, uint(word.size()), token);
+  }
+
+  void addSpans(uint line_num, const std::string_view &str, const CSyntaxSpans &spans) override {
+    for (const auto &span : spans)
+      addSpan(span.start, span.len, span.token);
+
+    if (brackets_)
+      brackets_->setLine(line_num, str, spans);
+  }
+
+  void addSpan(uint start, uint len, CSyntaxToken token) {
+    line_->addAnnotation(start, start + len - 1, bg_, fg_[int(token)]);
+  }
+
+ private:
+  CSyntaxBrackets *brackets_ { nullptr };
+  CVEditLine      *line_     { nullptr };
+  CRGBA            bg_;
+  CRGBA            fg_[10];
+};
+
+CVEditLine *
+editLine(const CVEditFile *file, int line_num)
+{
+  return const_cast<CVEditLine *>(dynamic_cast<const CVEditLine *>(file->getEditLine(line_num)));
+}
+
+// lines to re-lex from line_num to before line_end (views of line text). The
+// end state of each line is stored when the next line is requested and once it
+// matches the previously stored state, valid lines are skipped (restoring
+// their state) up to line_num2. If the start state is a guess (not exact)
+// results are shown but never stored : a valid line's stored state may be
+// stale too so it only improves the guess.
+class CVEditFileSyntaxLines : public CSyntaxLineIterator {
+ public:
+  CVEditFileSyntaxLines(CVEditFile *file, CSyntax *syntax, CVEditFileSyntaxNotifier &notifier,
+                        int line_num, int line_num2, int line_end, bool exact=true) :
+   file_(file), syntax_(syntax), notifier_(notifier), line_num_(line_num),
+   line_num2_(line_num2), line_end_(line_end), exact_(exact) {
+  }
+
+  int lineNum() const { return line_num_; }
+
+  bool isExact() const { return exact_; }
+  bool isCarry() const { return carry_; }
+
+  bool nextLine(uint &line_num, std::string_view &str) override {
+    // store end state of last line (guessed results are not stored so later
+    // lines still compare against states they were lexed with)
+    if (line_) {
+      if (exact_) {
+        int state = int(syntax_->getState());
+
+        carry_ = (state != line_->getSyntaxState());
+
+        line_->setSyntaxState(state);
+        line_->setSyntaxValid(true);
+      }
+
+      line_->setChanged(true);
+
+      line_ = nullptr;
+
+      ++line_num_;
+    }
+
+    for ( ; line_num_ < line_end_; ++line_num_) {
+      auto *line = editLine(file_, line_num_);
+
+      if (line->getSyntaxValid() && (! exact_ || ! carry_)) {
+        if (line_num_ > line_num2_)
+          return false;
+
+        syntax_->setState(uint(line->getSyntaxState()));
+
+        carry_ = false;
+
+        continue;
+      }
+
+      notifier_.setLine(line);
+
+      line->clearAnnotations();
+
+      line_ = line;
+
+      // line text in shared buffer (valid until next line)
+      line_num = uint(line_num_);
+      str      = std::string_view(line->getCString(), line->getLength());
+
+      return true;
+    }
+
+    return false;
+  }
+
+ private:
+  CVEditFile               *file_      { nullptr };
+  CSyntax                  *syntax_    { nullptr };
+  CVEditFileSyntaxNotifier &notifier_;
+  int                       line_num_  { 0 };
+  int                       line_num2_ { 0 };
+  int                       line_end_  { 0 };
+  bool                      exact_     { true };
+  bool                      carry_     { true };
+  CVEditLine               *line_      { nullptr };
+};
+
+}
 
 CVEditFileMgr::
 CVEditFileMgr() :
@@ -130,6 +268,28 @@ initFont()
   setFont(font);
 }
 
+void
+CVEditFile::
+setTabStop(uint tab_stop)
+{
+  if (tab_stop == tab_stop_)
+    return;
+
+  tab_stop_ = tab_stop;
+
+  // line display columns depend on tab stop
+  uint num_lines = wrap_index_.numLines();
+
+  for (uint line_num = 0; line_num < num_lines; ++line_num)
+    updateLineCols(line_num);
+
+  wrap_index_.invalidateAll();
+
+  setIgnoreChanged(true);
+
+  notifyUpdate();
+}
+
 void
 CVEditFile::
 setXOffset(int x_offset)
@@ -144,6 +304,61 @@ setYOffset(int y_offset)
   y_offset_ = y_offset;
 }
 
+void
+CVEditFile::
+scrollYOffset(int y_offset)
+{
+  // window always starts at a row so contents move by whole rows
+  int ch = int(char_height_);
+
+  int row1 = -y_offset_/ch;
+  int row2 = -y_offset /ch;
+
+  y_offset_ = y_offset;
+
+  int drows = row1 - row2; // rows contents move down by
+
+  if (drows == 0 || getIgnoreChanged())
+    return;
+
+  int nrows = int(num_rows_);
+
+  if (std::abs(drows) >= nrows - 1) {
+    setIgnoreChanged(true);
+    return;
+  }
+
+  int dy = drows*ch;
+
+  // damaged rows are those exposed and, moving up, those the status line moved over
+  int y1, y2;
+
+  if (dy > 0) {
+    y1 = 0;
+    y2 = dy;
+  }
+  else {
+    y1 = std::max(int(height_) + dy - ch, 0);
+    y2 = int(height_);
+  }
+
+  if (! scrollWindow(dy, CIBBox2D(0, y1, int(width_), y2))) {
+    setIgnoreChanged(true);
+    return;
+  }
+
+  uint num_lines = getNumLines();
+
+  for (int row = y1/ch; row <= (y2 - 1)/ch; ++row) {
+    uint line_num = fold_tree_.rowToLine(uint(row2 + row));
+
+    if (line_num >= num_lines)
+      break;
+
+    editLine(this, line_num)->setChanged(true);
+  }
+}
+
 CVEditVi *
 CVEditFile::
 getVi() const
@@ -186,7 +401,7 @@ loadLines(const std::string &filename)
   if (! CEditFile::loadLines(filename))
     return false;
 
-  update();
+  notifyUpdate();
 
   return true;
 }
@@ -198,7 +413,7 @@ saveLines(const std::string &filename)
   if (! CEditFile::saveLines(filename))
     return false;
 
-  update();
+  notifyUpdate();
 
   return true;
 }
@@ -226,7 +441,7 @@ setBg(const CRGBA &bg)
 
   style.bg.setValue(bg);
 
-  update();
+  notifyUpdate();
 }
 
 const CRGBA &
@@ -252,7 +467,7 @@ setFg(const CRGBA &fg)
 
   style.fg.setValue(fg);
 
-  update();
+  notifyUpdate();
 }
 
 CFontPtr
@@ -308,7 +523,24 @@ setFont(CFontPtr font)
   char_width_  = uint(font->getStringWidth("X"));
   char_height_ = uint(font->getCharHeight());
 
-  update();
+  // gutter width depends on char width
+  gutter_digits_ = -1;
+
+  notifyUpdate();
+}
+
+void
+CVEditFile::
+setCharSize(uint char_width, uint char_height)
+{
+  char_width_  = std::max(char_width , 1U);
+  char_height_ = std::max(char_height, 1U);
+
+  gutter_digits_ = -1;
+
+  setIgnoreChanged(true);
+
+  notifyUpdate();
 }
 
 const CRGBA &
@@ -329,7 +561,7 @@ setCursorBg(const CRGBA &bg)
   if (cursor)
     cursor->setBg(bg);
 
-  update();
+  notifyUpdate();
 }
 
 const CRGBA &
@@ -349,7 +581,7 @@ setCursorFg(const CRGBA &fg)
 
   cursor->setFg(fg);
 
-  update();
+  notifyUpdate();
 }
 
 void
@@ -363,7 +595,7 @@ setMode(Mode mode)
   else
     setExtraLineChar(true);
 
-  stateChanged();
+  notifyStateChanged();
 }
 
 void
@@ -375,7 +607,7 @@ setOverwriteMode(bool overwrite_mode)
 
   overwrite_mode_ = overwrite_mode;
 
-  stateChanged();
+  notifyStateChanged();
 }
 
 bool
@@ -419,6 +651,22 @@ draw(uint width, uint height)
 
   //------
 
+  bool number = getOptions().number;
+
+  uint num_lines = getNumLines();
+
+  // gutter width only changes with digit count of line count (all lines are
+  // redrawn at the new indent when it does)
+  int gutter_digits = (number ? CDigits::numDigits(num_lines) : 0);
+
+  if (gutter_digits != gutter_digits_) {
+    gutter_digits_ = gutter_digits;
+
+    indent_ = (gutter_digits_ > 0 ? char_width_*uint(gutter_digits_ + 1) : 0);
+
+    setIgnoreChanged(true);
+  }
+
   bool filled = false;
 
   if (getIgnoreChanged()) {
@@ -427,93 +675,135 @@ draw(uint width, uint height)
     filled = true;
   }
 
-  bool number = getOptions().number;
-
-  uint num_lines = getNumLines();
+  // wrapped rows fill window columns right of line numbers (no x scroll)
+  bool wrap = getOptions().wrap;
 
-  indent_ = 0;
+  wrap_index_.setWidth(uint(std::max((w - int(indent_))/int(char_width_), 1)));
 
-  if (number)
-    indent_ = char_width_*(int(log10(num_lines)) + 2);
+  if (wrap)
+    x_offset_ = 0;
 
   CIPoint2D p(indent_ - x_offset_, -y_offset_);
 
-  line_num1_ = p.y/int(char_height_);
-  line_num2_ = line_num1_ + num_rows_ - 1;
+  // screen rows in window and their line range
+  int row1 = p.y/int(char_height_);
+  int row2 = row1 + num_rows_ - 1;
 
-  int dy = p.y - char_height_*line_num1_;
+  uint sub_row1, sub_row2;
 
-  CIBBox2D bbox(p.x, p.y, p.x + w, p.y + h);
+  line_num1_ = int(screenRowToLine(uint(std::max(row1, 0)), sub_row1));
+  line_num2_ = int(screenRowToLine(uint(std::max(row2, 0)), sub_row2));
 
-  setBBox(bbox);
+  // bring highlight up to date for visible lines (plus a page either side),
+  // remaining changed lines are processed in background
+  updateSyntax(line_num1_ - int(num_rows_), line_num2_ + int(num_rows_));
 
-  LineList::const_iterator pline1 = beginLine();
-  LineList::const_iterator pline2 = endLine  ();
+  // line at row is at y = layout_dy_ + row*char_height_ (first window row at window top)
+  layout_dy_ = p.y - char_height_*row1;
 
-  uint max_x = indent_;
+  CIBBox2D bbox(p.x, p.y, p.x + w, p.y + h);
+
+  setBBox(bbox);
 
   auto *cursor = dynamic_cast<CVEditCursor *>(getCursor());
 
   const CIPoint2D &cpos = cursor->getPos();
 
-  CIPoint2D pos;
+  // first line may start above window (wrapped)
+  int row = std::max(row1, 0) - int(sub_row1);
 
-  pos.x = indent_;
-  pos.y = dy;
+  for (uint line_num = uint(std::max(line_num1_, 0));
+       line_num < num_lines && row <= row2;
+       line_num = fold_tree_.nextVisibleLine(line_num)) {
+    CVEditLine *line = editLine(this, line_num);
 
-  for (uint line_num = 0; pline1 != pline2; ++pline1, ++line_num) {
-    CVEditLine *line = dynamic_cast<CVEditLine *>(*pline1);
+    uint rows = getWrapRows(line_num);
 
-    line->setBBox(pos);
+    CIPoint2D pos(indent_, layout_dy_ + row*int(char_height_));
 
-    if (int(line_num) >= line_num1_ && int(line_num) <= line_num2_) {
-      const CIBBox2D &lbbox = line->getBBox();
+    row += int(rows);
 
-      bool line_filled = filled;
+    line_num2_ = int(line_num);
 
-      if (! line_filled && line->getChanged()) {
-        CIBBox2D flbbox = lbbox;
+    line->setBBox(pos, getLineCols(line_num), rows);
 
-        flbbox.setXMax(w);
+    const CIBBox2D &lbbox = line->getBBox();
 
-        applyOffset(flbbox);
+    bool line_filled = filled;
 
-        CVEditMgrInst->fillRectangle(flbbox, getBg());
+    if (! line_filled && line->getChanged()) {
+      CIBBox2D flbbox = lbbox;
 
-        line_filled = true;
-      }
+      flbbox.setXMax(w);
 
-      if (number && (getIgnoreChanged() || line->getChanged())) {
-        CVEditMgrInst->setForeground(CRGBA(1,0,1));
+      applyOffset(flbbox);
 
-        CIPoint2D p1(0, pos.y);
+      CVEditMgrInst->fillRectangle(flbbox, getBg());
 
-        applyOffset(p1);
+      line_filled = true;
+    }
 
-        CVEditMgrInst->drawString(p1, CStrUtil::toString(line_num));
-      }
+    if (number && (getIgnoreChanged() || line->getChanged())) {
+      CIPoint2D p1(0, pos.y);
+
+      applyOffset(p1);
+
+      // clear previous number (line numbers change when lines added/removed)
+      if (! filled) {
+        CIBBox2D nbbox(p1.x, p1.y, p1.x + int(indent_), p1.y + int(char_height_));
 
-      if (cpos.y == int(line_num)) {
-        if (! cmd_line)
-          line->draw(lbbox, cursor, line_filled);
-        else
-          line->draw(lbbox, NULL, line_filled);
+        CVEditMgrInst->fillRectangle(nbbox, getBg());
       }
+
+      CVEditMgrInst->drawNumber(p1, line_num, CRGBA(1,0,1));
+    }
+
+    if (cpos.y == int(line_num)) {
+      if (! cmd_line)
+        line->draw(lbbox, line_num, cursor, line_filled);
       else
-        line->draw(lbbox, NULL, line_filled);
+        line->draw(lbbox, line_num, NULL, line_filled);
+    }
+    else
+      line->draw(lbbox, line_num, NULL, line_filled);
 
-      line->setChanged(false);
+    line->setChanged(false);
 
-      max_x = std::max(max_x, indent_ + lbbox.getWidth());
+    // closed fold header shows hidden line count
+    uint fold_lines;
+
+    if (fold_tree_.isClosedFold(line_num, fold_lines)) {
+      CVEditMgrInst->setForeground(CRGBA(0,0,1));
+
+      CIPoint2D p1(lbbox.getXMax() + char_width_, pos.y);
+
+      applyOffset(p1);
+
+      CVEditMgrInst->drawString(p1, "... " + CStrUtil::toString(fold_lines) + " lines");
     }
+  }
+
+  // shown matching bracket (in cursor colors)
+  if (match_row_ >= line_num1_ && match_row_ <= line_num2_ && match_row_ < int(num_lines) &&
+      ! fold_tree_.isHidden(match_row_)) {
+    CIBBox2D rect;
 
-    pos.y += char_height_;
+    if (posToRect(match_row_, match_col_, rect))
+      drawFilledChar(rect, getChar(match_row_, match_col_), getCursorBg(), getCursorFg());
   }
 
-  vsize_ = CISize2D(max_x, (num_lines + 1)*char_height_);
+  int num_rows = getNumScreenRows();
+
+  if (! wrap)
+    vsize_ = CISize2D(indent_ + (getMaxLineCols() + 1)*char_width_, (num_rows + 1)*char_height_);
+  else
+    vsize_ = CISize2D(w, (num_rows + 1)*char_height_);
 
   if (getIgnoreChanged() || getChanged()) {
-    CIBBox2D bbox1(indent_, pos.y, w, pos.y + h);
+    // clear below last line
+    int y = layout_dy_ + num_rows*char_height_;
+
+    CIBBox2D bbox1(indent_, y, w, y + h);
 
     applyOffset(bbox1);
 
@@ -551,14 +841,14 @@ void
 CVEditFile::
 clearSelection()
 {
-  LineList::const_iterator pline1 = beginLine();
-  LineList::const_iterator pline2 = endLine  ();
+  if (selection_.isEmpty())
+    return;
 
-  for ( ; pline1 != pline2; ++pline1) {
-    CVEditLine *line = dynamic_cast<CVEditLine *>(*pline1);
+  CVEditSelection old_selection = selection_;
 
-    line->clearSelection();
-  }
+  selection_.clear();
+
+  selectionRedraw(old_selection);
 }
 
 void
@@ -570,24 +860,28 @@ selectBBox(const CIBBox2D &bbox, bool clear)
   else
     rangeSelect(bbox, clear);
 
-  update();
+  notifyUpdate();
 }
 
 void
 CVEditFile::
 selectInside(const CIBBox2D &bbox, bool clear)
 {
+  CVEditSelection old_selection = selection_;
+
   if (clear)
-    clearSelection();
+    selection_.clear();
 
-  LineList::const_iterator pline1 = beginLine();
-  LineList::const_iterator pline2 = endLine  ();
+  // only window lines are selected
+  CIBBox2D bbox1 = bbox;
 
-  for ( ; pline1 != pline2; ++pline1) {
-    CVEditLine *line = dynamic_cast<CVEditLine *>(*pline1);
+  bbox1.setYMin(std::max(bbox1.getYMin(), bbox_.getYMin()));
+  bbox1.setYMax(std::min(bbox1.getYMax(), bbox_.getYMax()));
 
-    line->selectInside(bbox);
-  }
+  if (bbox1.getYMin() <= bbox1.getYMax())
+    selection_.addBlock(bbox1);
+
+  selectionRedraw(old_selection);
 }
 
 void
@@ -614,42 +908,19 @@ void
 CVEditFile::
 rangeSelect(const CIPoint2D &start, const CIPoint2D &end, bool clear)
 {
-  if (clear)
-    clearSelection();
+  CVEditSelection old_selection = selection_;
 
-  if      (end.y > start.y) {
-    for (int col = start.x; col < int(lineLength(start.y)); ++col)
-      selectChar(start.y, col);
-
-    for (int row = start.y + 1; row < end.y; ++row)
-      selectLine(row);
-
-    for (int col = 0; col <= end.x; ++col)
-      selectChar(end.y, col);
-  }
-  else if (start.y > end.y) {
-    for (int col = start.x; col >= 0; --col)
-      selectChar(start.y, col);
-
-    for (int row = start.y - 1; row > end.y; --row)
-      selectLine(row);
-
-    for (int col = int(lineLength(end.y)) - 1; col >= end.x; --col)
-      selectChar(end.y, col);
-  }
-  else if (end.y == start.y) {
-    int x1 = std::min(start.x, end.x);
-    int x2 = std::max(start.x, end.x);
+  if (clear)
+    selection_.clear();
 
-    for (int col = x1; col <= x2; ++col)
-      selectChar(start.y, col);
-  }
+  // chars from start to end inclusive (either order)
+  selection_.addRange(start, end);
 
-  std::string str = getSelectedText();
+  selectionRedraw(old_selection);
 
-  selectionChanged(str);
+  notifySelectionChanged();
 
-  update();
+  notifyUpdate();
 }
 
 void
@@ -658,10 +929,11 @@ selectChar(int row, int col)
 {
   CASSERT(row >= 0 && row <= int(getNumLines()), "Invalid Line Num");
 
-  CVEditLine *line = const_cast<CVEditLine *>(
-    dynamic_cast<const CVEditLine *>(getEditLine(row)));
+  CVEditSelection old_selection = selection_;
 
-  line->selectChar(col);
+  selection_.addRange(CIPoint2D(col, row), CIPoint2D(col, row));
+
+  selectionRedraw(old_selection);
 }
 
 void
@@ -670,26 +942,57 @@ selectLine(int row)
 {
   CASSERT(row >= 0 && row <= int(getNumLines()), "Invalid Line Num");
 
-  CVEditLine *line = const_cast<CVEditLine *>(
-    dynamic_cast<const CVEditLine *>(getEditLine(row)));
+  CVEditSelection old_selection = selection_;
+
+  int len = (row < int(getNumLines()) ? int(lineLength(row)) : 0);
 
-  line->selectAllChars();
+  selection_.addRange(CIPoint2D(0, row), CIPoint2D(std::max(len - 1, 0), row));
+
+  selectionRedraw(old_selection);
 }
 
 void
 CVEditFile::
 setSelectionColor(const CRGBA &color)
 {
-  LineList::const_iterator pline1 = beginLine();
-  LineList::const_iterator pline2 = endLine  ();
+  int num_lines = int(getNumLines());
+
+  for (const auto &range : selection_.ranges()) {
+    for (int line_num = std::max(range.start.y, 0);
+         line_num <= std::min(range.end.y, num_lines - 1); ++line_num) {
+      CVEditLine *line = editLine(this, line_num);
+
+      uint char1 = uint(line_num == range.start.y ? std::max(range.start.x, 0) : 0);
+      // end before first char of line (end line removed)
+      if (line_num == range.end.y && range.end.x < 0)
+        continue;
+
+      uint char2 = (line_num == range.end.y ? uint(range.end.x) : line->getLength());
+
+      line->setCharsFg(char1, char2, color);
+    }
+  }
+
+  if (selection_.hasBlocks()) {
+    std::vector<uint> chars;
+
+    for (uint line_num = uint(std::max(line_num1_, 0));
+         line_num < uint(num_lines) && int(line_num) <= line_num2_;
+         line_num = fold_tree_.nextVisibleLine(line_num)) {
+      CVEditLine *line = editLine(this, line_num);
+
+      for (const auto &bbox : selection_.blocks()) {
+        chars.clear();
 
-  for ( ; pline1 != pline2; ++pline1) {
-    CVEditLine *line = dynamic_cast<CVEditLine *>(*pline1);
+        line->getBlockChars(bbox, chars);
 
-    line->setSelectedCharColor(color);
+        for (auto c : chars)
+          line->setCharsFg(c, c, color);
+      }
+    }
   }
 
-  update();
+  notifyUpdate();
 }
 
 void
@@ -720,28 +1023,118 @@ getSelectedText() const
 {
   std::string text;
 
-  LineList::const_iterator pline1 = beginLine();
-  LineList::const_iterator pline2 = endLine  ();
+  int num_lines = int(getNumLines());
+
+  // copy span of each selected line
+  for (const auto &range : selection_.ranges()) {
+    for (int line_num = std::max(range.start.y, 0);
+         line_num <= std::min(range.end.y, num_lines - 1); ++line_num) {
+      const CEditLine *line = getEditLine(line_num);
+
+      int len = int(line->getLength());
 
-  for ( ; pline1 != pline2; ++pline1) {
-    CVEditLine *line = dynamic_cast<CVEditLine *>(*pline1);
+      int char1 = (line_num == range.start.y ? std::max(range.start.x, 0) : 0);
+      int char2 = (line_num == range.end.y ? std::min(range.end.x, len - 1) : len - 1);
 
-    text += line->getSelectedText();
+      if (char1 <= char2)
+        text += line->getSubString(char1, char2);
+    }
+  }
+
+  if (selection_.hasBlocks()) {
+    std::vector<uint> chars;
+
+    for (uint line_num = uint(std::max(line_num1_, 0));
+         line_num < uint(num_lines) && int(line_num) <= line_num2_;
+         line_num = fold_tree_.nextVisibleLine(line_num)) {
+      const CVEditLine *line = editLine(this, line_num);
+
+      chars.clear();
+
+      for (const auto &bbox : selection_.blocks())
+        line->getBlockChars(bbox, chars);
+
+      std::sort(chars.begin(), chars.end());
+
+      chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+
+      for (auto c : chars)
+        text += line->getChar(c);
+    }
   }
 
   return text;
 }
 
+bool
+CVEditFile::
+isCharSelected(uint line_num, uint char_num, const CIBBox2D &cbbox) const
+{
+  return (selection_.isRangeSelected(int(line_num), int(char_num)) ||
+          selection_.isBlockSelected(cbbox));
+}
+
+void
+CVEditFile::
+selectionRedraw(const CVEditSelection &old_selection)
+{
+  // only window lines are drawn (others are drawn when scrolled into window)
+  bool blocks = (old_selection.hasBlocks() || selection_.hasBlocks());
+
+  uint num_lines = getNumLines();
+
+  for (uint line_num = uint(std::max(line_num1_, 0));
+       line_num < num_lines && int(line_num) <= line_num2_;
+       line_num = fold_tree_.nextVisibleLine(line_num)) {
+    int l = int(line_num);
+
+    // lines inside both old and new ranges are unchanged
+    if (! blocks &&
+        ! old_selection.isRangeEndLine(l) && ! selection_.isRangeEndLine(l) &&
+        old_selection.isRangeLine(l) == selection_.isRangeLine(l))
+      continue;
+
+    editLine(this, line_num)->setChanged(true);
+  }
+}
+
+void
+CVEditFile::
+shiftSelection(uint line_num, int n)
+{
+  if (selection_.isEmpty())
+    return;
+
+  if (n > 0)
+    selection_.linesAdded(int(line_num), n);
+  else
+    selection_.linesDeleted(int(line_num), -n);
+
+  if (selection_.isEmpty())
+    notifySelectionChanged();
+}
+
 void
 CVEditFile::
 keyPress(const CKeyEvent &event)
 {
+  // remove shown matching bracket
+  if (match_row_ >= 0) {
+    auto *line = editLine(this, match_row_);
+
+    if (line)
+      line->setChanged(true);
+
+    match_row_ = -1;
+    match_col_ = -1;
+  }
+
   if      (mode_ == ModeNormal)
     gen_->processChar(event);
   else if (mode_ == ModeVi)
     vi_->processChar(event);
 
-  update();
+  notifyUpdate();
 }
 
 void
@@ -763,7 +1156,7 @@ mousePress(const CMouseEvent &event)
     press_row_ = row;
     press_col_ = col;
 
-    update();
+    notifyUpdate();
   }
 }
 
@@ -782,7 +1175,7 @@ mouseMotion(const CMouseEvent &event)
 
     rangeSelect(press_row_, press_col_, release_row_, release_col_, true);
 
-    update();
+    notifyUpdate();
   }
 }
 
@@ -824,7 +1217,7 @@ mouseRelease(const CMouseEvent &event)
         rangeSelect(end, end, true);
     }
 
-    update();
+    notifyUpdate();
   }
 }
 
@@ -882,13 +1275,11 @@ scrollTo(const CIBBox2D &bbox, CScrollType type)
 
     //std::cerr << "Line Num: " << line_num << std::endl;
 
-    y_offset_ = -line_num*char_height_ - 1;
+    scrollYOffset(-line_num*char_height_ - 1);
 
     //std::cerr << "Y Offset: " <<  y_offset_ << std::endl;
 
-    setIgnoreChanged(true);
-
-    update();
+    notifyUpdate();
   }
   else if (type == CSCROLL_TYPE_BOTTOM) {
     int py = bbox.getYMax();
@@ -900,15 +1291,13 @@ scrollTo(const CIBBox2D &bbox, CScrollType type)
 
     //std::cerr << "Line Num: " << line_num << std::endl;
 
-    y_offset_ = (num_rows_ - 1 - line_num)*char_height_ - 1;
+    int y_offset = (num_rows_ - 1 - line_num)*char_height_ - 1;
 
-    if (y_offset_ > 0) y_offset_ = 0;
+    scrollYOffset(std::min(y_offset, 0));
 
     //std::cerr << "Y Offset: " <<  y_offset_ << std::endl;
 
-    setIgnoreChanged(true);
-
-    update();
+    notifyUpdate();
   }
   else if (type == CSCROLL_TYPE_VISIBLE) {
     int py = bbox.getYMid();
@@ -920,25 +1309,25 @@ scrollTo(const CIBBox2D &bbox, CScrollType type)
 
     //std::cerr << "Line Num: " << line_num << std::endl;
 
-    if      (line_num < line_num1_) {
-      y_offset_ = -line_num*char_height_ - 1;
+    // bbox y is screen row based (compare with window rows)
+    int row1 = -y_offset_/int(char_height_);
+    int row2 = row1 + int(num_rows_) - 1;
 
-      //std::cerr << "Y Offset: " << y_offset_ << std::endl;
+    if      (line_num < row1) {
+      scrollYOffset(-line_num*char_height_ - 1);
 
-      setIgnoreChanged(true);
+      //std::cerr << "Y Offset: " << y_offset_ << std::endl;
 
-      update();
+      notifyUpdate();
     }
-    else if (line_num > line_num2_) {
-      y_offset_ = (num_rows_ - 1 - line_num)*char_height_ - 1;
+    else if (line_num > row2) {
+      int y_offset = (num_rows_ - 1 - line_num)*char_height_ - 1;
 
-      if (y_offset_ > 0) y_offset_ = 0;
+      scrollYOffset(std::min(y_offset, 0));
 
       //std::cerr << "Y Offset: " << y_offset_ << std::endl;
 
-      setIgnoreChanged(true);
-
-      update();
+      notifyUpdate();
     }
   }
 }
@@ -1001,21 +1390,26 @@ pointToPos(const CIPoint2D &point, int *row, int *col) const
     return false;
   }
 
-  LineList::const_iterator pline1 = beginLine();
-  LineList::const_iterator pline2 = endLine  ();
+  // line at screen row (line y is layout_dy_ + row*char_height_)
+  int srow = (point.y - layout_dy_)/int(char_height_);
 
-  for (uint line_num = 0; pline1 != pline2; ++pline1, ++line_num) {
-    if (int(line_num) >= line_num1_ && int(line_num) <= line_num2_) {
-      CVEditLine *line = dynamic_cast<CVEditLine *>(*pline1);
+  uint sub_row;
 
-      if (line->pointToCol(point, col)) {
-        *row = line_num;
-        return true;
-      }
-    }
-  }
+  uint line_num = screenRowToLine(uint(std::max(srow, 0)), sub_row);
 
-  return false;
+  if (line_num >= getNumLines())
+    return false;
+
+  auto *line = dynamic_cast<const CVEditLine *>(getEditLine(line_num));
+
+  layoutLine(line_num);
+
+  if (! line->pointToCol(point, col))
+    return false;
+
+  *row = line_num;
+
+  return true;
 }
 
 bool
@@ -1037,11 +1431,17 @@ bool
 CVEditFile::
 posToRect(int row, int col, CIBBox2D &rect) const
 {
+  if (row < 0 || row >= int(getNumLines()))
+    return false;
+
   const CVEditLine *line = dynamic_cast<const CVEditLine *>(getEditLine(row));
 
   if (line == NULL)
     return false;
 
+  // line may be outside window so lay out from its row
+  layoutLine(row);
+
   if (! line->colToRect(col, rect))
     rect = line->getBBox();
 
@@ -1068,173 +1468,1183 @@ positionChanged()
 
 void
 CVEditFile::
-undo()
-{
-  CEditFile::undo();
-
-  update();
-}
-
-void
-CVEditFile::
-redo()
+startBatch()
 {
-  CEditFile::redo();
-
-  update();
+  ++batch_depth_;
 }
 
 void
 CVEditFile::
-replayFile(const std::string &fileName)
+endBatch()
 {
-  CFile file(fileName);
+  CASSERT(batch_depth_ > 0, "Not in batch");
 
-  if (file.exists() && ! file.isRegular())
+  if (--batch_depth_ > 0)
     return;
 
-  CKeyEvent event;
-
-  event.setPosition(CIPoint2D(0,0));
+  uint flags = batch_flags_;
 
-  std::string str;
+  batch_flags_ = 0;
 
-  while (file.readLine(str)) {
-    uint len = uint(str.size());
+  // selected text is only built once for all batch selection changes
+  if (flags & BATCH_SELECTION)
+    selectionChanged(getSelectedText());
 
-    if (len <= 0) continue;
+  if (flags & BATCH_STATE)
+    stateChanged();
 
-    if (str[0] == ':') {
-      bool quit1;
+  if (flags & BATCH_UPDATE)
+    update();
+}
 
-      runEdCmd(str.substr(1), quit1);
+void
+CVEditFile::
+notifyUpdate()
+{
+  if (inBatch())
+    batch_flags_ |= BATCH_UPDATE;
+  else
+    update();
+}
 
-      if (quit1)
-        quit();
+void
+CVEditFile::
+notifyStateChanged()
+{
+  if (inBatch())
+    batch_flags_ |= BATCH_STATE;
+  else
+    stateChanged();
+}
 
+void
+CVEditFile::
+notifySelectionChanged()
+{
+  if (inBatch())
+    batch_flags_ |= BATCH_SELECTION;
+  else
+    selectionChanged(getSelectedText());
+}
+
+void
+CVEditFile::
+undo()
+{
+  CEditFile::undo();
+
+  notifyUpdate();
+}
+
+void
+CVEditFile::
+redo()
+{
+  CEditFile::redo();
+
+  notifyUpdate();
+}
+
+bool
+CVEditFile::
+replayFile(const std::string &fileName)
+{
+  bool rc = CEditFile::replayFile(fileName);
+
+  if (replayQuit_ && replayDepth_ == 0)
+    quit();
+
+  return rc;
+}
+
+bool
+CVEditFile::
+replayKey(char c, bool escape)
+{
+  CKeyEvent event;
+
+  event.setPosition(CIPoint2D(0,0));
+
+  event.setType(CEvent::charKeyType(c));
+  event.setText(std::string(&c, 1));
+
+  if (escape) {
+    switch (c) {
+      case 'h': event.setType(CKEY_TYPE_BackSpace); event.setText("\b"  ); break;
+      case 'i': event.setType(CKEY_TYPE_TAB      ); event.setText("\t"  ); break;
+      case 'l': event.setType(CKEY_TYPE_FF       ); event.setText("\f"  ); break;
+      case 'n': event.setType(CKEY_TYPE_Return   ); event.setText("\r"  ); break;
+      case '@': event.setType(CKEY_TYPE_Escape   ); event.setText("\033"); break;
+      default : break;
+    }
+  }
+
+  keyPress(event);
+
+  return true;
+}
+
+void
+CVEditFile::
+quit()
+{
+  exit(0);
+}
+
+void
+CVEditFile::
+setSyntax(CSyntax *syntax)
+{
+  if (syntax_worker_)
+    syntax_worker_->cancel();
+
+  syntax_ = std::unique_ptr<CSyntax>(syntax);
+
+  if (syntax_) {
+    if (! syntax_brackets_)
+      syntax_brackets_ = std::make_unique<CSyntaxBrackets>();
+
+    syntax_brackets_->reset(getNumLines());
+  }
+  else
+    syntax_brackets_.reset();
+
+  invalidateSyntax();
+
+  // visible lines are highlighted on next draw, the rest in background
+  notifyUpdate();
+}
+
+std::string
+CVEditFile::
+syntaxFileName(const std::string &name) const
+{
+  // syntaxdir defaults to $CVI_SYNTAX_DIR
+  std::string dir;
+
+  if (! getOptionString("syntaxdir", dir) && getenv("CVI_SYNTAX_DIR"))
+    dir = getenv("CVI_SYNTAX_DIR");
+
+  return (dir != "" ? dir + "/" : "") + name + ".syn";
+}
+
+void
+CVEditFile::
+invalidateSyntax()
+{
+  ++syntax_gen_;
+
+  uint num_lines = getNumLines();
+
+  for (uint i = 0; i < num_lines; ++i)
+    invalidateSyntaxLine(i);
+}
+
+void
+CVEditFile::
+updateSyntax()
+{
+  if (! syntax_ || syntax_line1_ < 0) return;
+
+  // synchronous update supersedes any background one
+  if (syntax_worker_)
+    syntax_worker_->cancel();
+
+  CVEditFileSyntaxNotifier notifier(syntax_brackets_.get());
+
+  int num_lines = getNumLines();
+
+  int line_num1 = std::min(syntax_line1_, num_lines);
+  int line_num2 = std::min(syntax_line2_, num_lines - 1);
+
+  syntax_line1_ = -1;
+  syntax_line2_ = -1;
+
+  syntax_->setNotifier(&notifier);
+
+  // restart lexer from end state of the line before the first changed line
+  if (line_num1 > 0) {
+    auto *line = editLine(this, line_num1 - 1);
+
+    syntax_->setState(uint(std::max(line->getSyntaxState(), 0)));
+  }
+  else {
+    syntax_->init();
+
+    syntax_->setState(0);
+  }
+
+  // re-lex changed lines, continuing past the changed range until the new
+  // end state matches the stored one (later lines are then unaffected)
+  CVEditFileSyntaxLines lines(this, syntax_.get(), notifier, line_num1, line_num2, num_lines);
+
+  syntax_->parse(lines);
+
+  if (lines.lineNum() >= num_lines)
+    syntax_->term();
+
+  syntax_->setNotifier(nullptr);
+}
+
+void
+CVEditFile::
+updateSyntax(int line_num1, int line_num2)
+{
+  if (! syntax_) return;
+
+  applySyntaxResults();
+
+  int num_lines = getNumLines();
+
+  // pending range may end past lines since deleted
+  if (syntax_line2_ >= num_lines) {
+    syntax_line2_ = num_lines - 1;
+
+    if (syntax_line1_ > syntax_line2_) {
+      syntax_line1_ = -1;
+      syntax_line2_ = -1;
+    }
+  }
+
+  if (syntax_line1_ < 0) {
+    // worker (same generation) may still be carrying a changed state past
+    // the pending range
+    if (syntax_worker_ && syntax_worker_->isBusy())
+      syntaxPending();
+
+    return;
+  }
+
+  line_num1 = std::max(line_num1, 0);
+  line_num2 = std::min(line_num2, num_lines - 1);
+
+  // lex pending lines in window (priority over background)
+  int line_num = std::max(line_num1, syntax_line1_);
+
+  if (line_num <= line_num2) {
+    CVEditFileSyntaxNotifier notifier(syntax_brackets_.get());
+
+    syntax_->setNotifier(&notifier);
+
+    // start state is exact if previous line is before pending range (valid
+    // lines inside it may be stale), otherwise guess from its old state and
+    // only show result until background catches up
+    bool exact = (line_num == syntax_line1_);
+
+    if (line_num > 0) {
+      auto *line = editLine(this, line_num - 1);
+
+      syntax_->setState(uint(std::max(line->getSyntaxState(), 0)));
+    }
+    else {
+      syntax_->init();
+
+      syntax_->setState(0);
+    }
+
+    CVEditFileSyntaxLines lines(this, syntax_.get(), notifier, line_num, line_num2,
+                                line_num2 + 1, exact);
+
+    syntax_->parse(lines);
+
+    syntax_->setNotifier(nullptr);
+
+    // changed end state must propagate past window
+    if (lines.isExact() && lines.isCarry() && lines.lineNum() < num_lines)
+      invalidateSyntaxLine(lines.lineNum());
+
+    // drop leading lines now up to date from pending range
+    while (syntax_line1_ >= 0 && syntax_line1_ <= syntax_line2_ &&
+           editLine(this, syntax_line1_)->getSyntaxValid())
+      ++syntax_line1_;
+
+    if (syntax_line1_ > syntax_line2_) {
+      syntax_line1_ = -1;
+      syntax_line2_ = -1;
+    }
+  }
+
+  if (syntax_line1_ < 0) {
+    // worker (same generation) may still be carrying a changed state past
+    // the pending range
+    if (syntax_worker_ && syntax_worker_->isBusy())
+      syntaxPending();
+
+    return;
+  }
+
+  // lex remaining lines in background (restart if lines changed since start)
+  if (! syntax_worker_ || ! syntax_worker_->isBusy() ||
+      syntax_worker_->generation() != syntax_gen_)
+    startSyntaxWorker();
+
+  if (syntax_worker_ && syntax_worker_->isBusy())
+    syntaxPending();
+}
+
+bool
+CVEditFile::
+findMatchingBracket(uint line_num, uint char_num, uint &line_num1, uint &char_num1)
+{
+  if (! syntax_ || ! syntax_brackets_)
+    return false;
+
+  int num_lines = getNumLines();
+
+  if (int(line_num) >= num_lines)
+    return false;
+
+  // lines before pending range are lexed (and indexed) exactly
+  auto lexedLines = [&]() { return (syntax_line1_ < 0 ? num_lines : syntax_line1_); };
+
+  // lex up to bracket's line only
+  if (lexedLines() <= int(line_num))
+    updateSyntax(syntax_line1_, int(line_num));
+
+  // bracket in string or comment is not indexed so has no match
+  const auto &brackets = syntax_brackets_->lineBrackets(line_num);
+
+  auto p = std::find_if(brackets.begin(), brackets.end(),
+                        [&](const CSyntaxBrackets::Bracket &bracket) {
+                          return bracket.col == char_num;
+                        });
+
+  if (p == brackets.end())
+    return false;
+
+  // close bracket's match is before it (in lexed lines)
+  if (! strchr("([{", p->c))
+    return syntax_brackets_->findMatch(line_num, char_num, line_num1, char_num1);
+
+  // open bracket's match is after it : lex increasing regions after the
+  // bracket until the match is in lexed lines (or all lines are lexed)
+  int line_num2 = int(line_num);
+  int region   = 256;
+
+  while (true) {
+    bool found = syntax_brackets_->findMatch(line_num, char_num, line_num1, char_num1);
+
+    if (found && int(line_num1) < lexedLines())
+      return true;
+
+    if (lexedLines() >= num_lines)
+      return false;
+
+    line_num2 = std::min(line_num2 + region, num_lines - 1);
+
+    region *= 2;
+
+    updateSyntax(syntax_line1_, line_num2);
+  }
+}
+
+void
+CVEditFile::
+showMatchingBracket()
+{
+  int col = getCol() - 1;
+
+  if (col < 0)
+    return;
+
+  uint line_num1, char_num1;
+
+  if (! findMatchingBracket(getRow(), uint(col), line_num1, char_num1))
+    return;
+
+  match_row_ = int(line_num1);
+  match_col_ = int(char_num1);
+}
+
+bool
+CVEditFile::
+createFold(uint line_num, bool closed)
+{
+  uint line_num2;
+
+  if (! getFoldRange(line_num, line_num2))
+    return false;
+
+  return fold_tree_.addFold(line_num, line_num2, closed);
+}
+
+void
+CVEditFile::
+createAllFolds()
+{
+  uint num_lines = getNumLines();
+
+  std::string method;
+
+  if (getOptionString("foldmethod", method) && method == "syntax") {
+    for (uint i = 0; i < num_lines; ++i) {
+      uint line_num2;
+
+      if (getFoldRange(i, line_num2))
+        (void) fold_tree_.addFold(i, line_num2);
+    }
+
+    return;
+  }
+
+  // indent : single pass with stack of fold headers. Header's fold ends at
+  // last non blank line before next line indented no more than it
+  struct Header {
+    uint line_num;
+    int  indent;
+  };
+
+  std::vector<Header> headers;
+
+  uint last_line = 0;
+
+  for (uint i = 0; i < num_lines; ++i) {
+    int indent;
+
+    if (! lineIndent(i, indent))
+      continue;
+
+    while (! headers.empty() && headers.back().indent >= indent) {
+      if (last_line > headers.back().line_num)
+        (void) fold_tree_.addFold(headers.back().line_num, last_line);
+
+      headers.pop_back();
+    }
+
+    headers.push_back({i, indent});
+
+    last_line = i;
+  }
+
+  for ( ; ! headers.empty(); headers.pop_back()) {
+    if (last_line > headers.back().line_num)
+      (void) fold_tree_.addFold(headers.back().line_num, last_line);
+  }
+}
+
+bool
+CVEditFile::
+getFoldRange(uint line_num, uint &line_num2)
+{
+  if (line_num >= getNumLines())
+    return false;
+
+  // syntax : first open bracket on line closed on later line
+  std::string method;
+
+  if (getOptionString("foldmethod", method) && method == "syntax") {
+    if (! syntax_ || ! syntax_brackets_)
+      return false;
+
+    // lex up to line only (match lexes on to its close bracket)
+    if (syntax_line1_ >= 0 && syntax_line1_ <= int(line_num))
+      updateSyntax(syntax_line1_, int(line_num));
+
+    // copy as matching may update line's brackets
+    auto brackets = syntax_brackets_->lineBrackets(line_num);
+
+    for (const auto &bracket : brackets) {
+      if (bracket.c != '(' && bracket.c != '[' && bracket.c != '{') continue;
+
+      uint match_line, match_col;
+
+      if (findMatchingBracket(line_num, bracket.col, match_line, match_col) &&
+          match_line > line_num) {
+        line_num2 = match_line;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // indent : following lines indented more than line (ignoring blank lines)
+  int indent;
+
+  if (! lineIndent(line_num, indent))
+    return false;
+
+  uint num_lines = getNumLines();
+
+  line_num2 = line_num;
+
+  for (uint i = line_num + 1; i < num_lines; ++i) {
+    int indent1;
+
+    if (! lineIndent(i, indent1))
       continue;
+
+    if (indent1 <= indent)
+      break;
+
+    line_num2 = i;
+  }
+
+  return (line_num2 > line_num);
+}
+
+bool
+CVEditFile::
+lineIndent(uint line_num, int &indent) const
+{
+  const auto &str = getEditLine(line_num)->getString();
+
+  indent = 0;
+
+  for (auto c : str) {
+    if      (c == ' ' ) ++indent;
+    else if (c == '\t') indent += tab_stop_ - (indent % tab_stop_);
+    else                return true;
+  }
+
+  return false; // blank
+}
+
+bool
+CVEditFile::
+openFold(uint line_num)
+{
+  // lines shown by fold are in hidden lines after closed fold header
+  uint line_num1 = fold_tree_.rowToLine(fold_tree_.lineToRow(line_num));
+  uint line_num2 = fold_tree_.nextVisibleLine(line_num1);
+
+  if (! fold_tree_.openFold(line_num))
+    return false;
+
+  updateWrapLines(line_num1 + 1, line_num2 - 1);
+
+  foldsChanged();
+
+  return true;
+}
+
+bool
+CVEditFile::
+closeFold(uint line_num)
+{
+  // create fold for line's region if no fold starts at line
+  uint line_num1, line_num2;
+  bool closed;
+
+  if (! fold_tree_.foldAt(line_num, line_num1, line_num2, closed) || line_num1 != line_num)
+    (void) createFold(line_num, false);
+
+  if (! fold_tree_.closeFold(line_num))
+    return false;
+
+  // lines hidden by fold follow its header
+  uint header = fold_tree_.rowToLine(fold_tree_.lineToRow(line_num));
+
+  updateWrapLines(header + 1, fold_tree_.nextVisibleLine(header) - 1);
+
+  foldsChanged();
+
+  return true;
+}
+
+bool
+CVEditFile::
+toggleFold(uint line_num)
+{
+  uint lines;
+
+  if (fold_tree_.isClosedFold(line_num, lines))
+    return openFold(line_num);
+  else
+    return closeFold(line_num);
+}
+
+void
+CVEditFile::
+openAllFolds()
+{
+  // lines hidden by closed folds are shown
+  CFoldTree::Ranges ranges;
+
+  fold_tree_.foldBodies(ranges, true);
+
+  fold_tree_.openAllFolds();
+
+  for (const auto &range : ranges)
+    updateWrapLines(range.first, range.second);
+
+  foldsChanged();
+}
+
+void
+CVEditFile::
+closeAllFolds()
+{
+  // lines in fold bodies may be hidden
+  CFoldTree::Ranges ranges;
+
+  fold_tree_.foldBodies(ranges);
+
+  fold_tree_.closeAllFolds();
+
+  for (const auto &range : ranges)
+    updateWrapLines(range.first, range.second);
+
+  foldsChanged();
+}
+
+void
+CVEditFile::
+removeAllFolds()
+{
+  // lines hidden by closed folds are shown
+  CFoldTree::Ranges ranges;
+
+  fold_tree_.foldBodies(ranges, true);
+
+  fold_tree_.removeAllFolds();
+
+  for (const auto &range : ranges)
+    updateWrapLines(range.first, range.second);
+
+  foldsChanged();
+}
+
+void
+CVEditFile::
+foldsChanged()
+{
+  // move cursor from hidden line to its closed fold header
+  const CIPoint2D &pos = getPos();
+
+  if (fold_tree_.isHidden(pos.y)) {
+    setPos(CIPoint2D(pos.x, fold_tree_.rowToLine(fold_tree_.lineToRow(pos.y))));
+
+    fixPos();
+  }
+
+  setIgnoreChanged(true);
+
+  notifyUpdate();
+}
+
+void
+CVEditFile::
+updateWrapLines(uint line_num1, uint line_num2)
+{
+  uint num_lines = getNumLines();
+
+  for (uint i = line_num1; i <= line_num2 && i < num_lines; ++i) {
+    if (fold_tree_.isHidden(i))
+      wrap_index_.setRows(i, 0);
+    else {
+      // shown line has at least one row (actual rows set when next used)
+      if (wrap_index_.rows(i) == 0)
+        wrap_index_.setRows(i, 1);
+
+      wrap_index_.invalidate(i);
     }
+  }
+}
+
+uint
+CVEditFile::
+getWrapCols() const
+{
+  return (getOptions().wrap ? wrap_index_.width() : 0);
+}
+
+uint
+CVEditFile::
+getWrapRows(uint line_num) const
+{
+  if (! getOptions().wrap)
+    return 1;
 
-    if (str[0] == '/') {
-      bool quit1;
+  if (line_num >= getNumLines())
+    return 0;
 
-      runEdCmd(str, quit1);
+  if (! wrap_index_.isValid(line_num)) {
+    uint rows = 0;
 
-      continue;
+    if (! fold_tree_.isHidden(line_num)) {
+      // room for list mode $
+      uint cols = getLineCols(line_num) + (getOptions().list ? 1 : 0);
+
+      rows = CWrapIndex::colsToRows(cols, wrap_index_.width());
     }
 
-    for (uint i = 0; i < len; ++i) {
-      char c = str[i];
+    wrap_index_.setRows(line_num, rows);
+  }
+
+  return wrap_index_.rows(line_num);
+}
+
+uint
+CVEditFile::
+getNumScreenRows() const
+{
+  if (! getOptions().wrap)
+    return fold_tree_.numRows();
+
+  return wrap_index_.numRows();
+}
+
+uint
+CVEditFile::
+lineToScreenRow(uint line_num) const
+{
+  if (! getOptions().wrap)
+    return fold_tree_.lineToRow(line_num);
+
+  // hidden line is shown as its closed fold header
+  if (fold_tree_.isHidden(line_num))
+    line_num = fold_tree_.rowToLine(fold_tree_.lineToRow(line_num));
+
+  return wrap_index_.lineToRow(line_num);
+}
 
-      event.setType(CEvent::charKeyType(c));
-      event.setText(str.substr(i, 1));
+uint
+CVEditFile::
+screenRowToLine(uint row, uint &sub_row) const
+{
+  if (! getOptions().wrap) {
+    sub_row = 0;
 
-      if (c == '\\') {
-        ++i;
+    return fold_tree_.rowToLine(row);
+  }
 
-        char c1 = '\0';
+  return wrap_index_.rowToLine(row, sub_row);
+}
 
-        if (i < len)
-          c1 = str[i];
+bool
+CVEditFile::
+cursorScreenUp(uint n)
+{
+  uint wrap_cols = getWrapCols();
 
-        switch (c1) {
-          case 'h': event.setType(CKEY_TYPE_BackSpace); break;
-          case 'i': event.setType(CKEY_TYPE_TAB      ); break;
-          case 'l': event.setType(CKEY_TYPE_FF       ); break;
-          case 'n': event.setType(CKEY_TYPE_Return   ); break;
-          case '@': event.setType(CKEY_TYPE_Escape   ); break;
-          default : break;
-        }
-      }
+  if (wrap_cols == 0)
+    return cursorUp(n);
+
+  // move by screen rows keeping column in row
+  const CIPoint2D &pos = getPos();
+
+  uint col = editLine(this, pos.y)->getTabMap().charToCol(pos.x);
+
+  uint sub_row = std::min(col/wrap_cols, std::max(getWrapRows(pos.y), 1U) - 1);
+
+  uint row = lineToScreenRow(pos.y) + sub_row;
+
+  col -= sub_row*wrap_cols;
+
+  bool rc = (row >= n);
+
+  row = (rc ? row - n : 0);
+
+  uint line_num = screenRowToLine(row, sub_row);
+
+  uint char_num = editLine(this, line_num)->getTabMap().colToChar(sub_row*wrap_cols + col);
+
+  setPos(CIPoint2D(std::min(char_num, getLineEnd(line_num)), line_num));
+
+  return rc;
+}
+
+bool
+CVEditFile::
+cursorScreenDown(uint n)
+{
+  uint wrap_cols = getWrapCols();
+
+  if (wrap_cols == 0)
+    return cursorDown(n);
+
+  if (n > 0 && isLinesEmpty())
+    return false;
+
+  // move by screen rows keeping column in row
+  const CIPoint2D &pos = getPos();
+
+  uint col = editLine(this, pos.y)->getTabMap().charToCol(pos.x);
+
+  uint sub_row = std::min(col/wrap_cols, std::max(getWrapRows(pos.y), 1U) - 1);
+
+  uint row      = lineToScreenRow(pos.y) + sub_row;
+  uint num_rows = getNumScreenRows();
+
+  col -= sub_row*wrap_cols;
+
+  bool rc = (row + n < num_rows);
+
+  row = (rc ? row + n : num_rows - 1);
+
+  uint line_num = screenRowToLine(row, sub_row);
+
+  uint char_num = editLine(this, line_num)->getTabMap().colToChar(sub_row*wrap_cols + col);
+
+  setPos(CIPoint2D(std::min(char_num, getLineEnd(line_num)), line_num));
+
+  return rc;
+}
+
+uint
+CVEditFile::
+prevVisibleLine(uint line_num) const
+{
+  return fold_tree_.rowToLine(fold_tree_.lineToRow(line_num) - 1);
+}
+
+uint
+CVEditFile::
+nextVisibleLine(uint line_num) const
+{
+  return fold_tree_.nextVisibleLine(line_num);
+}
+
+void
+CVEditFile::
+startSyntaxWorker()
+{
+  if (! syntax_worker_)
+    syntax_worker_ = std::make_unique<CSyntaxWorker>();
+
+  int num_lines = getNumLines();
+
+  int line_num1 = std::min(syntax_line1_, num_lines);
+  int line_num2 = std::min(syntax_line2_, num_lines - 1);
+
+  // lines before pending range are up to date so state is exact
+  uint state = 0;
+
+  if (line_num1 > 0)
+    state = uint(std::max(editLine(this, line_num1 - 1)->getSyntaxState(), 0));
+
+  // snapshot bounded batch of lines from start of pending range (worker is
+  // continued with next batch if state still carries at its end)
+  int num_snapshot = std::min(num_lines - line_num1,
+                              int(syntax_worker_->snapshotLines(syntax_gen_)));
+
+  CSyntaxWorker::Lines lines;
+
+  lines.resize(num_snapshot);
+
+  for (int i = line_num1; i < line_num1 + num_snapshot; ++i) {
+    auto *line = editLine(this, i);
+
+    auto &line1 = lines[i - line_num1];
+
+    line1.str   = line->getString();
+    line1.state = line->getSyntaxState();
+    line1.valid = line->getSyntaxValid();
+  }
+
+  // fall back to synchronous update if lexer can't be run in background
+  if (! syntax_worker_->start(*syntax_, syntax_gen_, line_num1, state,
+                              std::move(lines), line_num2, num_lines))
+    updateSyntax();
+}
+
+void
+CVEditFile::
+applySyntaxResults()
+{
+  if (! syntax_worker_ || ! syntax_worker_->isBusy())
+    return;
+
+  // results for old line contents are discarded
+  if (syntax_worker_->generation() != syntax_gen_) {
+    syntax_worker_->cancel();
+    return;
+  }
+
+  CSyntaxWorker::Results results;
+
+  uint end_line = 0;
+  bool carry    = false;
+
+  bool done = syntax_worker_->takeResults(results, end_line, carry);
+
+  CVEditFileSyntaxNotifier notifier(syntax_brackets_.get());
+
+  for (const auto &result : results) {
+    auto *line = editLine(this, result.line_num);
+
+    line->clearAnnotations();
+
+    notifier.setLine(line);
+
+    for (const auto &span : result.spans)
+      notifier.addSpan(span.start, span.len, span.token);
+
+    syntax_brackets_->setLine(result.line_num, line->getString(), result.spans);
+
+    line->setSyntaxState(int(result.state));
+    line->setSyntaxValid(true);
 
-      keyPress(event);
+    line->setChanged(true);
+  }
+
+  // lines before end line are now up to date
+  if (done && syntax_line1_ >= 0) {
+    syntax_line1_ = std::max(syntax_line1_, int(end_line));
+
+    if (syntax_line1_ > syntax_line2_) {
+      syntax_line1_ = -1;
+      syntax_line2_ = -1;
     }
   }
+
+  // end of batch not converged so continue from it
+  if (done && carry && int(end_line) < getNumLines())
+    invalidateSyntaxLine(end_line);
 }
 
 void
 CVEditFile::
-quit()
+lineAdded(uint line_num)
 {
-  exit(0);
+  ++syntax_gen_;
+
+  // shift pending range for inserted line
+  if (syntax_line1_ >= int(line_num)) ++syntax_line1_;
+  if (syntax_line2_ >= int(line_num)) ++syntax_line2_;
+
+  if (syntax_brackets_)
+    syntax_brackets_->addLine(line_num);
+
+  fold_tree_.addLine(line_num);
+
+  // new line in closed fold body has no rows
+  wrap_index_.addLine(line_num, fold_tree_.isHidden(line_num) ? 0 : 1, calcLineCols(line_num));
+
+  shiftSelection(line_num, 1);
+
+  invalidateSyntaxLine(line_num);
 }
 
 void
 CVEditFile::
-setSyntax(CSyntax *syntax)
+lineDeleted(uint line_num)
 {
-  syntax_ = std::unique_ptr<CSyntax>(syntax);
+  ++syntax_gen_;
+
+  // shift pending range for removed line
+  if (syntax_line1_ > int(line_num)) --syntax_line1_;
+  if (syntax_line2_ > int(line_num)) --syntax_line2_;
+
+  if (syntax_brackets_)
+    syntax_brackets_->deleteLine(line_num);
 
-  updateSyntax();
+  uint fold_line1, fold_line2;
+
+  bool shown = fold_tree_.deleteLine(line_num, fold_line1, fold_line2);
+
+  wrap_index_.deleteLine(line_num);
+
+  // body of removed closed fold is shown
+  if (shown)
+    updateWrapLines(fold_line1, fold_line2);
+
+  shiftSelection(line_num, -1);
+
+  // next line now follows a different line so its start state may change
+  if (line_num < getNumLines())
+    invalidateSyntaxLine(line_num);
 }
 
 void
 CVEditFile::
-updateSyntax()
+linesAdded(uint line_num, uint n)
 {
-  if (! syntax_) return;
+  if (n == 0)
+    return;
 
-  class Notifier : public CSyntaxNotifier {
-   private:
-    CVEditFile *file_;
-    CVEditLine *line_;
-    CRGBA       bg_;
-    CRGBA       fg_[10];
+  ++syntax_gen_;
 
-   public:
-    Notifier(CVEditFile *file) :
-     file_(file) {
-      assert(file_);
+  // shift pending range for inserted lines
+  if (syntax_line1_ >= int(line_num)) syntax_line1_ += n;
+  if (syntax_line2_ >= int(line_num)) syntax_line2_ += n;
 
-      bg_ = CRGBA(0, 0, 0);
+  for (uint i = 0; i < n; ++i) {
+    uint line_num1 = line_num + i;
 
-      fg_[int(CSyntaxToken::PREPRO )] = CRGBA(1.0, 0.5, 1.0);
-      fg_[int(CSyntaxToken::KEYWORD)] = CRGBA(1.0, 1.0, 0.5);
-      fg_[int(CSyntaxToken::STRING )] = CRGBA(1.0, 0.5, 0.0);
-      fg_[int(CSyntaxToken::COMMENT)] = CRGBA(0.5, 0.5, 1.0);
-    }
+    if (syntax_brackets_)
+      syntax_brackets_->addLine(line_num1);
 
-    void setLine(CVEditLine *line) {
-      line_ = line;
-    }
+    fold_tree_.addLine(line_num1);
 
-    void addToken(uint, uint word_start, const std::string &word, CSyntaxToken token) override {
-      line_->addAnnotation(word_start, word_start + uint(word.size()) - 1, bg_, fg_[int(token)]);
-    }
-  };
+    wrap_index_.addLine(line_num1, fold_tree_.isHidden(line_num1) ? 0 : 1,
+                        calcLineCols(line_num1));
+  }
 
-  Notifier notifier(this);
+  shiftSelection(line_num, int(n));
 
-  syntax_->init();
+  invalidateSyntaxLine(line_num);
+  invalidateSyntaxLine(line_num + n - 1);
+}
 
-  syntax_->setNotifier(&notifier);
+void
+CVEditFile::
+linesDeleted(uint line_num, uint n)
+{
+  if (n == 0)
+    return;
 
-  LineList::const_iterator pline1 = beginLine();
-  LineList::const_iterator pline2 = endLine  ();
+  ++syntax_gen_;
 
-  for ( ; pline1 != pline2; ++pline1) {
-    CVEditLine *line = dynamic_cast<CVEditLine *>(*pline1);
+  // shift pending range for removed lines (range in removed lines moves to line_num)
+  int line_num1 = int(line_num);
+  int line_num2 = int(line_num + n);
 
-    notifier.setLine(line);
+  if      (syntax_line1_ >= line_num2) syntax_line1_ -= n;
+  else if (syntax_line1_ >  line_num1) syntax_line1_  = line_num1;
 
-    line->clearAnnotations();
+  if      (syntax_line2_ >= line_num2) syntax_line2_ -= n;
+  else if (syntax_line2_ >  line_num1) syntax_line2_  = line_num1;
+
+  // body lines of removed closed folds (line_num to shown_line2) are shown
+  int shown_line2 = -1;
+
+  for (uint i = 0; i < n; ++i) {
+    if (syntax_brackets_)
+      syntax_brackets_->deleteLine(line_num);
 
-    syntax_->processLine(line->getString());
+    if (shown_line2 >= line_num1)
+      --shown_line2;
+
+    uint fold_line1, fold_line2;
+
+    if (fold_tree_.deleteLine(line_num, fold_line1, fold_line2))
+      shown_line2 = std::max(shown_line2, int(fold_line2));
+
+    wrap_index_.deleteLine(line_num);
   }
 
-  syntax_->term();
+  if (shown_line2 >= line_num1)
+    updateWrapLines(line_num, uint(shown_line2));
 
-  syntax_->setNotifier(nullptr);
+  shiftSelection(line_num, -int(n));
+
+  if (line_num < getNumLines())
+    invalidateSyntaxLine(line_num);
+}
+
+void
+CVEditFile::
+lineChanged(uint line_num)
+{
+  ++syntax_gen_;
+
+  updateLineCols(line_num);
+
+  wrap_index_.invalidate(line_num);
+
+  invalidateSyntaxLine(line_num);
+}
+
+uint
+CVEditFile::
+getLineCols(uint line_num) const
+{
+  if (line_num < wrap_index_.numLines())
+    return wrap_index_.cols(line_num);
+
+  auto *line = editLine(this, line_num);
+
+  return (line ? line->getNumCols() : 0);
+}
+
+uint
+CVEditFile::
+calcLineCols(uint line_num) const
+{
+  auto *line = editLine(this, line_num);
+
+  if (! line)
+    return 0;
+
+  line->resetTabMap();
+
+  return line->getNumCols();
+}
+
+void
+CVEditFile::
+updateLineCols(uint line_num)
+{
+  wrap_index_.setCols(line_num, calcLineCols(line_num));
+}
+
+uint
+CVEditFile::
+getMaxLineCols() const
+{
+  return wrap_index_.maxCols();
+}
+
+void
+CVEditFile::
+layoutLine(uint line_num) const
+{
+  auto *line = editLine(this, line_num);
+
+  if (! line)
+    return;
+
+  CIPoint2D pos(indent_, layout_dy_ + int(lineToScreenRow(line_num)*char_height_));
+
+  line->setBBox(pos, getLineCols(line_num), getWrapRows(line_num));
+}
+
+void
+CVEditFile::
+invalidateSyntaxLine(uint line_num)
+{
+  auto *line = editLine(this, line_num);
+
+  if (line)
+    line->setSyntaxValid(false);
+
+  if (syntax_line1_ < 0 || int(line_num) < syntax_line1_) syntax_line1_ = line_num;
+  if (syntax_line2_ < 0 || int(line_num) > syntax_line2_) syntax_line2_ = line_num;
 }
 
 void
 CVEditFile::
 optionChanged(const std::string &name)
 {
-  if (name == "number" || name == "list") {
+  if      (name == "number" || name == "list" || name == "wrap") {
+    // list mode changes line display width
+    if (name == "list")
+      wrap_index_.invalidateAll();
+
     setIgnoreChanged(true);
 
-    update();
+    notifyUpdate();
+  }
+  else if (name == "tabstop") {
+    std::string value;
+
+    if (getOptionString(name, value) && CStrUtil::toInteger(value) > 0)
+      setTabStop(uint(CStrUtil::toInteger(value)));
+  }
+  else if (name == "syntax") {
+    std::string value;
+
+    (void) getOptionString(name, value);
+
+    if      (value == "c")
+      setSyntax(new CSyntaxC);
+    else if (value == "cpp")
+      setSyntax(new CSyntaxCPP);
+    else if (value == "0")
+      setSyntax(nullptr);
+    else if (value != "1") {
+      // language definition file
+      std::string msg;
+
+      auto *syntax = CSyntaxGeneric::load(syntaxFileName(value), msg);
+
+      if (! syntax)
+        displayError(StringList({msg}));
+
+      setSyntax(syntax);
+    }
   }
 }
 
@@ -1261,6 +2671,18 @@ drawFilledChar(const CIBBox2D &bbox, char c, const CRGBA &bg, const CRGBA &fg, b
   }
 }
 
+void
+CVEditFile::
+drawFilledString(const CIBBox2D &bbox, const std::string &str, const CRGBA &bg,
+                 const CRGBA &fg, bool filled) const
+{
+  CIBBox2D bbox1 = bbox;
+
+  applyOffset(bbox1);
+
+  CVEditMgrInst->drawRun(bbox1, str, bg, fg, filled);
+}
+
 void
 CVEditFile::
 applyOffset(CIBBox2D &bbox) const
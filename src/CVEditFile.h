@@ -7,6 +7,8 @@ class CVEditCursor;
 
 class CMouseEvent;
 class CSyntax;
+class CSyntaxWorker;
+class CSyntaxBrackets;
 
 #include <accessor.h>
 
@@ -18,6 +20,9 @@ class CSyntax;
 #include <CScrollType.h>
 #include <CConfig.h>
 #include <CFont.h>
+#include <CFoldTree.h>
+#include <CWrapIndex.h>
+#include <CVEditSelection.h>
 #include <memory>
 
 class CVEditVi;
@@ -91,9 +96,19 @@ class CVEditFile : public CEditFile {
   void setXOffset(int x_offset);
   void setYOffset(int y_offset);
 
+  // set y offset moving drawn window contents (scrollWindow) so only exposed
+  // rows are redrawn (full redraw if contents can't be moved)
+  void scrollYOffset(int y_offset);
+
+  // move drawn window contents by dy pixels and clear damage rect (window
+  // coords). Returns false if not supported
+  virtual bool scrollWindow(int /*dy*/, const CIBBox2D & /*damage*/) { return false; }
+
   ACCESSOR(IgnoreChanged, bool  , ignore_changed)
   ACCESSOR(Visual       , bool  , visual        )
-  ACCESSOR(TabStop      , uint  , tab_stop      )
+
+  uint getTabStop() const { return tab_stop_; }
+  void setTabStop(uint tab_stop);
 
   CVEditVi *getVi() const;
 
@@ -121,6 +136,9 @@ class CVEditFile : public CEditFile {
   CFontPtr getFont() const;
   void setFont(CFontPtr font);
 
+  // set char size without font metrics (headless drawing)
+  void setCharSize(uint char_width, uint char_height);
+
   const CRGBA &getCursorBg() const;
   void setCursorBg(const CRGBA &bg);
 
@@ -162,6 +180,11 @@ class CVEditFile : public CEditFile {
 
   virtual std::string getSelectedText() const;
 
+  const CVEditSelection &getSelection() const { return selection_; }
+
+  // is char (with cell cbbox in file coords) selected
+  bool isCharSelected(uint line_num, uint char_num, const CIBBox2D &cbbox) const;
+
   virtual bool pointToPos(const CIPoint2D &point, int *row, int *col) const;
   virtual bool posToPoint(int row, int col, CIPoint2D &point) const;
   virtual bool posToRect (int row, int col, CIBBox2D  &rect ) const;
@@ -169,7 +192,7 @@ class CVEditFile : public CEditFile {
   void undo() override;
   void redo() override;
 
-  void replayFile(const std::string &fileName) override;
+  bool replayFile(const std::string &fileName) override;
 
   virtual void keyPress  (const CKeyEvent &event);
   virtual void keyRelease(const CKeyEvent &event);
@@ -209,6 +232,17 @@ class CVEditFile : public CEditFile {
   // redraw required
   virtual void update() { }
 
+  // batch (macro playback) : redraw and state/selection notifications are
+  // deferred until end
+  void startBatch();
+  void endBatch();
+  bool inBatch() const { return batch_depth_ > 0; }
+
+  // notify update, state or selection change (deferred in batch)
+  void notifyUpdate();
+  void notifyStateChanged();
+  void notifySelectionChanged();
+
   // quit
   virtual void quit();
 
@@ -218,28 +252,145 @@ class CVEditFile : public CEditFile {
   // display marks
   virtual void displayRegisters() { }
 
+  CSyntax *getSyntax() const { return syntax_.get(); }
+
   virtual void setSyntax(CSyntax *syntax);
 
+  // language definition file for syntax name (<syntaxdir>/<name>.syn)
+  std::string syntaxFileName(const std::string &name) const;
+
+  // mark all lines for re-highlight
+  virtual void invalidateSyntax();
+
+  // re-highlight changed lines
   virtual void updateSyntax();
 
+  // re-highlight changed lines in window now and remaining lines in background
+  virtual void updateSyntax(int line_num1, int line_num2);
+
+  // background highlight in progress (redraw later to apply results)
+  virtual void syntaxPending() { }
+
+  // find bracket matching bracket at position using syntax bracket index (false
+  // if no syntax, bracket is in string or comment or is unmatched)
+  bool findMatchingBracket(uint line_num, uint char_num, uint &line_num1, uint &char_num1);
+
+  // show bracket matching closing bracket before cursor (showmatch) until next key
+  void showMatchingBracket();
+
+  // folds (closed fold is drawn as its header line)
+  const CFoldTree &getFoldTree() const { return fold_tree_; }
+
+  // create fold at line from bracket (foldmethod=syntax) or indent structure
+  bool createFold(uint line_num, bool closed);
+
+  // create folds for all lines
+  void createAllFolds();
+
+  bool openFold  (uint line_num);
+  bool closeFold (uint line_num);
+  bool toggleFold(uint line_num);
+
+  void openAllFolds();
+  void closeAllFolds();
+  void removeAllFolds();
+
+  // soft wrap (wrap option) : screen rows are the wrapped rows of visible lines
+  // (same as fold rows when not wrapping)
+
+  // display columns per wrapped row (0 if not wrapping)
+  uint getWrapCols() const;
+
+  // screen rows of line (updated if stale)
+  uint getWrapRows(uint line_num) const;
+
+  uint getNumScreenRows() const;
+
+  uint lineToScreenRow(uint line_num) const;
+  uint screenRowToLine(uint row, uint &sub_row) const;
+
+  bool cursorScreenUp  (uint n) override;
+  bool cursorScreenDown(uint n) override;
+
   void optionChanged(const std::string &name) override;
 
   // draw char
   virtual void drawFilledChar(const CIBBox2D &bbox, char c, const CRGBA &bg,
                               const CRGBA &fg, bool filled=false) const;
 
+  // draw run of chars with same colors
+  virtual void drawFilledString(const CIBBox2D &bbox, const std::string &str, const CRGBA &bg,
+                                const CRGBA &fg, bool filled=false) const;
+
   virtual void applyOffset(CIBBox2D &bbox) const;
   virtual void applyOffset(CIPoint2D &p) const;
 
+ protected:
+  void lineAdded  (uint line_num) override;
+  void lineDeleted(uint line_num) override;
+  void lineChanged(uint line_num) override;
+
+  void linesAdded  (uint line_num, uint n) override;
+  void linesDeleted(uint line_num, uint n) override;
+
+  uint prevVisibleLine(uint line_num) const override;
+  uint nextVisibleLine(uint line_num) const override;
+
+  // replay key as key press
+  bool replayKey(char c, bool escape) override;
+
+  // end of fold region starting at line (false if none)
+  bool getFoldRange(uint line_num, uint &line_num2);
+
+  // indent of line (false if blank)
+  bool lineIndent(uint line_num, int &indent) const;
+
+  void foldsChanged();
+
+  // set wrap rows of lines after their fold hidden state changed
+  void updateWrapLines(uint line_num1, uint line_num2);
+
+  // display columns of line (cached in wrap index, updated on line add/change)
+  uint getLineCols(uint line_num) const;
+
+  uint calcLineCols  (uint line_num) const;
+  void updateLineCols(uint line_num);
+
+  // widest line display columns
+  uint getMaxLineCols() const;
+
+  // set line bbox from its row and cached columns
+  void layoutLine(uint line_num) const;
+
+  // mark window lines whose selected chars differ from old selection as changed
+  void selectionRedraw(const CVEditSelection &old_selection);
+
+  // move selection for n lines added (n > 0) or removed (n < 0) at line_num
+  void shiftSelection(uint line_num, int n);
+
+  void invalidateSyntaxLine(uint line_num);
+
+  void startSyntaxWorker();
+  void applySyntaxResults();
+
  protected:
   using EditViP  = std::unique_ptr<CVEditVi>;
   using EditGenP = std::unique_ptr<CVEditGen>;
   using SyntaxP  = std::unique_ptr<CSyntax>;
+  using WorkerP  = std::unique_ptr<CSyntaxWorker>;
+  using BracketsP = std::unique_ptr<CSyntaxBrackets>;
 
   using StyleP = CPOptValT<CVEditFileStyle>;
 
+  enum BatchFlags {
+    BATCH_UPDATE    = (1<<0),
+    BATCH_STATE     = (1<<1),
+    BATCH_SELECTION = (1<<2)
+  };
+
   CIBBox2D  bbox_;
   uint      indent_         { 0 };
+  int       gutter_digits_  { -1 };
   int       line_num1_      { -1 };
   int       line_num2_      { -1 };
   StyleP    style_;
@@ -267,6 +418,25 @@ class CVEditFile : public CEditFile {
   uint      release_row_    { 0 };
   uint      release_col_    { 0 };
   bool      ignore_changed_ { false };
+  int       syntax_line1_   { -1 };
+  int       syntax_line2_   { -1 };
+  WorkerP   syntax_worker_;
+  uint      syntax_gen_     { 0 };
+  BracketsP syntax_brackets_;
+  int       match_row_      { -1 };
+  int       match_col_      { -1 };
+  CFoldTree fold_tree_;
+  int       layout_dy_      { 0 };
+
+  // screen rows of lines when wrapping (hidden lines have no rows)
+  mutable CWrapIndex wrap_index_;
+
+  // selected ranges/blocks
+  CVEditSelection selection_;
+
+  // batch depth and deferred notifications
+  uint batch_depth_ { 0 };
+  uint batch_flags_ { 0 };
 };
 
 #endif
@@ -2,7 +2,7 @@
 #include <CVEditFile.h>
 #include <CVEditChar.h>
 #include <CVEditCursor.h>
-#include <CAssert.h>
+#include <algorithm>
 
 CVEditLine::
 CVEditLine(CVEditFile *vfile) :
@@ -56,49 +56,99 @@ setFg(const CRGBA &fg)
   style_.fg.setValue(fg);
 }
 
+const CTabMap &
+CVEditLine::
+getTabMap() const
+{
+  uint tab_stop = vfile_->getTabStop();
+
+  if (! tab_map_.isValid(tab_stop))
+    tab_map_.build(getString(), tab_stop);
+
+  return tab_map_;
+}
+
+uint
+CVEditLine::
+getNumCols() const
+{
+  return getTabMap().numCols();
+}
+
 void
 CVEditLine::
-setBBox(const CIPoint2D &pos)
+setBBox(const CIPoint2D &pos, uint cols, uint rows)
 {
   int cw = vfile_->getCharWidth();
   int ch = vfile_->getCharHeight();
 
-  //CIPoint2D pos1 = pos;
+  if (rows > 1)
+    cols = vfile_->getWrapCols();
 
-  int n = 0;
-  int x = pos.x;
-
-  CEditLineChars::const_iterator pchar1 = beginChar();
-  CEditLineChars::const_iterator pchar2 = endChar  ();
+  bbox_.set(pos.x, pos.y, pos.x + (cols + 1)*cw, pos.y + std::max(rows, 1U)*ch);
+}
 
-  for ( ; pchar1 != pchar2; ++pchar1) {
-    CVEditChar *vchar = dynamic_cast<CVEditChar *>(*pchar1);
+uint
+CVEditLine::
+wrapRow(uint &col) const
+{
+  uint wrap_cols = vfile_->getWrapCols();
 
-    int num = 1;
+  if (wrap_cols == 0)
+    return 0;
 
-    if (vchar->getChar() == '\t')
-      num = 8 - (n % 8);
+  // column past end of full last row stays on last row
+  uint rows = std::max(getHeight()/vfile_->getCharHeight(), 1U);
 
-    n += num;
-    x += num*cw;
-  }
+  uint row = std::min(col/wrap_cols, rows - 1);
 
-  x += cw;
+  col -= row*wrap_cols;
 
-  bbox_.set(pos.x, pos.y, x, pos.y + ch);
+  return row;
 }
 
 void
 CVEditLine::
-draw(const CIBBox2D &bbox, CVEditCursor *cursor, bool filled)
+draw(const CIBBox2D &bbox, uint line_num, CVEditCursor *cursor, bool filled)
 {
   int cw = vfile_->getCharWidth();
+  int ch = vfile_->getCharHeight();
+
+  const CTabMap &tab_map = getTabMap();
+
+  // only chars in visible window columns (rows if wrapped) are drawn (offsets
+  // are <= 0)
+  int wxmin = -vfile_->getXOffset();
+  int wxmax = wxmin + int(vfile_->getWidth());
+  int wymin = -vfile_->getYOffset();
+  int wymax = wymin + int(vfile_->getHeight());
+
+  uint wrap_cols = vfile_->getWrapCols();
+
+  uint start_col = 0;
+
+  if      (wrap_cols == 0) {
+    if (wxmin > bbox.getXMin() && cw > 0)
+      start_col = (wxmin - bbox.getXMin())/cw;
+  }
+  else {
+    if (wymin > bbox.getYMin() && ch > 0)
+      start_col = ((wymin - bbox.getYMin())/ch)*wrap_cols;
+  }
+
+  uint col1 = std::min(tab_map.colToChar(start_col), tab_map.length());
+
+  uint n = tab_map.charToCol(col1);
+
+  // bbox of num columns at display column (on its wrapped row)
+  auto colBBox = [&](uint col, uint num) {
+    uint row = wrapRow(col);
 
-  uint n  = 0;
-  uint x1 = bbox.getXMin();
-  uint x2 = 0;
+    int x = bbox.getXMin() + int(col*cw);
+    int y = bbox.getYMin() + int(row*ch);
 
-  uint xmax = bbox.getXMax();
+    return CIBBox2D(x, y, x + int(num*cw), y + ch);
+  };
 
   bool changed = getChanged();
 
@@ -110,53 +160,92 @@ draw(const CIBBox2D &bbox, CVEditCursor *cursor, bool filled)
   if (cursor)
     cx = cursor->getPos().x;
 
-  CEditLineChars::const_iterator pchar1 = beginChar();
+  // consecutive chars on a row to draw with the same colors are drawn as one
+  // string (tabs expanded to spaces)
+  std::string run_str;
+  CIBBox2D    run_bbox;
+  CRGBA       run_bg, run_fg;
+  bool        run_filled = false;
+
+  auto flushRun = [&]() {
+    if (run_str.empty())
+      return;
+
+    vfile_->drawFilledString(run_bbox, run_str, run_bg, run_fg, run_filled);
+
+    run_str.clear();
+  };
+
+  CEditLineChars::const_iterator pchar1 = beginChar() + col1;
   CEditLineChars::const_iterator pchar2 = endChar  ();
 
-  for (uint col = 0; pchar1 != pchar2; ++pchar1, ++col) {
+  for (uint col = col1; pchar1 != pchar2; ++pchar1, ++col) {
     CVEditChar *vchar = dynamic_cast<CVEditChar *>(*pchar1);
 
     //-----
 
     char c = vchar->getChar();
 
-    uint num = 1;
-
-    if (c == '\t')
-      num = 8 - (n % 8);
+    uint num = (c == '\t' ? tab_map.charCols(col) : 1);
 
-    n  += num;
-    x2  = x1 + num*cw;
+    CIBBox2D cbbox = colBBox(n, num);
 
-    //-----
+    n += num;
 
-    if (x1 > xmax)
-      continue;
+    // rest of line is right of (below) window (left changed so drawn when
+    // scrolled to)
+    if (cbbox.getXMin() > wxmax || cbbox.getYMin() > wymax)
+      break;
 
     bool is_cursor = (cursor && cx == int(col));
 
-    if (changed || vchar->getChanged() || is_cursor) {
-      CIBBox2D cbbox(x1, bbox.getYMin(), x2, bbox.getYMax());
+    if      (is_cursor) {
+      flushRun();
 
-      vchar->draw(vfile_, this, cbbox, filled);
+      vchar->draw(vfile_, this, cbbox, vfile_->isCharSelected(line_num, col, cbbox), filled);
 
-      if (is_cursor)
-        cursor->draw(cbbox);
+      cursor->draw(cbbox);
     }
+    else if (changed || vchar->getChanged()) {
+      CRGBA bg1, fg1;
+      bool  filled1;
 
-    vchar->setChanged(false);
+      bool selected = vfile_->isCharSelected(line_num, col, cbbox);
 
-    //------
+      vchar->getDrawColors(this, selected, filled, bg1, fg1, filled1);
 
-    x1 = x2;
+      if (! run_str.empty() && (bg1 != run_bg || fg1 != run_fg || filled1 != run_filled ||
+                                cbbox.getYMin() != run_bbox.getYMin()))
+        flushRun();
+
+      if (run_str.empty()) {
+        run_bbox   = cbbox;
+        run_bg     = bg1;
+        run_fg     = fg1;
+        run_filled = filled1;
+      }
+      else
+        run_bbox.setXMax(cbbox.getXMax());
+
+      if (c == '\t' || c == '\0')
+        run_str.append(num, ' ');
+      else
+        run_str += c;
+    }
+    else
+      flushRun();
+
+    vchar->setChanged(false);
   }
 
+  flushRun();
+
+  n = tab_map.numCols();
+
   bool is_cursor = (cursor && cx == int(n));
 
   if (changed || extraCharChanged_ || is_cursor) {
-    x2 = x1 + cw;
-
-    CIBBox2D cbbox(x1, bbox.getYMin(), x2, bbox.getYMax());
+    CIBBox2D cbbox = colBBox(n, 1);
 
     if (vfile_->getOptions().list) {
       // draw $ at end
@@ -167,7 +256,7 @@ draw(const CIBBox2D &bbox, CVEditCursor *cursor, bool filled)
         CRGBA bg1 = vfile_->getBg();
         CRGBA fg1 = CRGBA(1,0,0);
 
-        vfile_->drawFilledChar(bbox, '$', bg1, fg1, filled);
+        vfile_->drawFilledChar(cbbox, '$', bg1, fg1, filled);
       }
     }
     else {
@@ -181,116 +270,62 @@ draw(const CIBBox2D &bbox, CVEditCursor *cursor, bool filled)
 
 void
 CVEditLine::
-clearSelection()
-{
-  CEditLineChars::const_iterator pchar1 = beginChar();
-  CEditLineChars::const_iterator pchar2 = endChar  ();
-
-  for ( ; pchar1 != pchar2; ++pchar1) {
-    CVEditChar *vchar = dynamic_cast<CVEditChar *>(*pchar1);
-
-    vchar->setSelected(false);
-  }
-}
-
-void
-CVEditLine::
-selectInside(const CIBBox2D &bbox)
+getBlockChars(const CIBBox2D &bbox, std::vector<uint> &chars) const
 {
   if (! bbox.overlaps(getBBox()))
     return;
 
   int cw = vfile_->getCharWidth();
+  int ch = vfile_->getCharHeight();
 
-  uint n  = 0;
-  uint x1 = 0;
-  uint x2 = 0;
-
-  CEditLineChars::const_iterator pchar1 = beginChar();
-  CEditLineChars::const_iterator pchar2 = endChar  ();
+  const CTabMap &tab_map = getTabMap();
 
-  for ( ; pchar1 != pchar2; ++pchar1) {
-    CVEditChar *vchar = dynamic_cast<CVEditChar *>(*pchar1);
+  uint wrap_cols = vfile_->getWrapCols();
 
-    char c = vchar->getChar();
+  int x0 = getBBox().getXMin();
+  int y0 = getBBox().getYMin();
 
-    uint num = 1;
+  // start at first char in box columns (chars of wrapped line are on many rows)
+  uint col1 = 0;
 
-    if (c == '\t')
-      num = 8 - (n % 8);
+  if (wrap_cols == 0 && bbox.getXMin() > x0 && cw > 0)
+    col1 = std::min(tab_map.colToChar((bbox.getXMin() - x0)/cw), tab_map.length());
 
-    n  += num;
-    x2  = x1 + num*cw;
+  uint len = getLength();
 
-    if (int(x1) > bbox.getXMax() || int(x2) < bbox.getXMin())
-      continue;
+  for (uint col = col1; col < len; ++col) {
+    uint c   = tab_map.charToCol(col);
+    uint row = wrapRow(c);
 
-    vchar->setSelected(true);
+    int x1 = x0 + c*cw;
+    int x2 = x1 + tab_map.charCols(col)*cw;
+    int y1 = y0 + row*ch;
 
-    x1 = x2;
-  }
-}
+    if ((wrap_cols == 0 && x1 > bbox.getXMax()) || y1 > bbox.getYMax())
+      break;
 
-void
-CVEditLine::
-selectAllChars()
-{
-  CEditLineChars::const_iterator pchar1 = beginChar();
-  CEditLineChars::const_iterator pchar2 = endChar  ();
-
-  for ( ; pchar1 != pchar2; ++pchar1) {
-    CVEditChar *vchar = dynamic_cast<CVEditChar *>(*pchar1);
-
-    vchar->setSelected(true);
-  }
-}
-
-void
-CVEditLine::
-selectChar(int row)
-{
-  CASSERT(row >= 0 && row <= int(getLength()), "Invalid Char Num");
-
-  if (row < int(getLength())) {
-    CVEditChar *vchar = const_cast<CVEditChar *>(
-      dynamic_cast<const CVEditChar *>(getCharP(row)));
+    if (x2 < bbox.getXMin() || x1 > bbox.getXMax() || y1 + ch < bbox.getYMin())
+      continue;
 
-    vchar->setSelected(true);
+    chars.push_back(col);
   }
 }
 
 void
 CVEditLine::
-setSelectedCharColor(const CRGBA &color)
-{
-  CEditLineChars::const_iterator pchar1 = beginChar();
-  CEditLineChars::const_iterator pchar2 = endChar  ();
-
-  for ( ; pchar1 != pchar2; ++pchar1) {
-    CVEditChar *vchar = dynamic_cast<CVEditChar *>(*pchar1);
-
-    if (vchar->getSelected())
-      vchar->setFg(this, color);
-  }
-}
-
-std::string
-CVEditLine::
-getSelectedText() const
+setCharsFg(uint char1, uint char2, const CRGBA &fg)
 {
-  std::string text;
+  uint len = getLength();
 
-  CEditLineChars::const_iterator pchar1 = beginChar();
-  CEditLineChars::const_iterator pchar2 = endChar  ();
+  CEditLineChars::const_iterator pchar1 = beginChar() + std::min(char1, len);
+  CEditLineChars::const_iterator pchar2 = beginChar() + std::min(char2 + 1, len);
 
-  for ( ; pchar1 != pchar2; ++pchar1) {
+  for ( ; pchar1 < pchar2; ++pchar1) {
     CVEditChar *vchar = dynamic_cast<CVEditChar *>(*pchar1);
 
-    if (vchar->getSelected())
-      text += vchar->getChar();
+    vchar->setFg(this, fg);
+    vchar->setChanged(true);
   }
-
-  return text;
 }
 
 bool
@@ -301,34 +336,20 @@ pointToCol(const CIPoint2D &point, int *col) const
     return false;
 
   int cw = vfile_->getCharWidth();
+  int ch = vfile_->getCharHeight();
 
-  uint n  = 0;
-  uint x1 = 0;
-  uint x2 = 0;
-
-  CEditLineChars::const_iterator pchar1 = beginChar();
-  CEditLineChars::const_iterator pchar2 = endChar  ();
-
-  for (uint col1 = 0; pchar1 != pchar2; ++pchar1, ++col1) {
-    char c = (*pchar1)->getChar();
-
-    uint num = 1;
-
-    if (c == '\t')
-      num = 8 - (n % 8);
+  uint pcol = (point.x > 0 ? uint(point.x/cw) : 0);
 
-    n  += num;
-    x2  = x1 + num*cw;
+  // wrapped row under point starts at multiple of wrap columns
+  uint wrap_cols = vfile_->getWrapCols();
 
-    if (point.x >= int(x1) && point.x <= int(x2)) {
-      *col = col1;
-      return true;
-    }
+  if (wrap_cols > 0)
+    pcol = std::min(pcol, wrap_cols - 1) + ((point.y - bbox_.getYMin())/ch)*wrap_cols;
 
-    x1 = x2;
-  }
+  // char at display column (after end of line is column 0)
+  uint col1 = getTabMap().colToChar(pcol);
 
-  *col = 0;
+  *col = (col1 < getLength() ? int(col1) : 0);
 
   return true;
 }
@@ -357,33 +378,20 @@ colToRect(int col, CIBBox2D &rect) const
 
   int cw = vfile_->getCharWidth();
 
-  uint n  = 0;
-  uint x1 = 0;
-  uint x2 = 0;
+  const CTabMap &tab_map = getTabMap();
 
-  CEditLineChars::const_iterator pchar1 = beginChar();
-  CEditLineChars::const_iterator pchar2 = endChar  ();
-
-  for (uint col1 = 0; pchar1 != pchar2; ++pchar1, ++col1) {
-    char c = (*pchar1)->getChar();
-
-    uint num = 1;
+  int ch = vfile_->getCharHeight();
 
-    if (c == '\t')
-      num = 8 - (n % 8);
+  uint c   = tab_map.charToCol(col);
+  uint row = wrapRow(c);
 
-    n  += num;
-    x2  = x1 + num*cw;
+  int x1 = c*cw;
+  int x2 = x1 + tab_map.charCols(col)*cw;
+  int y1 = getBBox().getYMin() + row*ch;
 
-    if (col == int(col1)) {
-      rect = CIBBox2D(x1, getBBox().getYMin(), x2, getBBox().getYMax());
-      return true;
-    }
+  rect = CIBBox2D(x1, y1, x2, y1 + ch);
 
-    x1 = x2;
-  }
-
-  return false;
+  return true;
 }
 
 bool
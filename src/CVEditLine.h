@@ -4,7 +4,9 @@
 #include <CEditLine.h>
 #include <CRGBA.h>
 #include <CIBBox2D.h>
+#include <CTabMap.h>
 #include <accessor.h>
+#include <vector>
 
 class CVEditChar;
 class CVEditFile;
@@ -25,28 +27,39 @@ class CVEditLine : public CEditLine {
 
   ACCESSOR(ExtraCharChanged, bool, extraCharChanged)
 
+  // syntax lexer state at end of line (-1 if never lexed)
+  ACCESSOR(SyntaxState, int , syntaxState)
+  ACCESSOR(SyntaxValid, bool, syntaxValid)
+
   const CRGBA &getBg() const;
   virtual void setBg(const CRGBA &bg);
 
   const CRGBA &getFg() const;
   virtual void setFg(const CRGBA &fg);
 
-  void setBBox(const CIPoint2D &pos);
+  // char index <-> display column map (built on demand for file tab stop)
+  const CTabMap &getTabMap() const;
 
-  const CIBBox2D &getBBox() const { return bbox_; }
+  // line text changed (tab map rebuilt on next use)
+  void resetTabMap() { tab_map_.reset(); }
 
-  virtual void draw(const CIBBox2D &bbox, CVEditCursor *cursor, bool fill);
+  // number of display columns (tabs expanded)
+  uint getNumCols() const;
 
-  virtual void clearSelection();
+  // set bbox at pos for line of cols display columns (plus end char) on rows
+  // screen rows (wrapped line is wrap columns wide)
+  void setBBox(const CIPoint2D &pos, uint cols, uint rows=1);
 
-  virtual void selectInside(const CIBBox2D &bbox);
+  const CIBBox2D &getBBox() const { return bbox_; }
 
-  virtual void selectAllChars();
-  virtual void selectChar(int row);
+  // draw line (line_num is used to test selected chars)
+  virtual void draw(const CIBBox2D &bbox, uint line_num, CVEditCursor *cursor, bool fill);
 
-  virtual void setSelectedCharColor(const CRGBA &color);
+  // chars whose cells overlap bbox (file coords, line must be laid out)
+  void getBlockChars(const CIBBox2D &bbox, std::vector<uint> &chars) const;
 
-  virtual std::string getSelectedText() const;
+  // set fg of chars char1 to char2 (inclusive)
+  void setCharsFg(uint char1, uint char2, const CRGBA &fg);
 
   virtual bool pointToCol(const CIPoint2D &point, int *col) const;
 
@@ -62,11 +75,18 @@ class CVEditLine : public CEditLine {
   void addAnnotation(uint word_start, uint word_end,
                      const CRGBA &bg, const CRGBA &fg);
 
+ private:
+  // wrapped row of display column (col is updated to column in row)
+  uint wrapRow(uint &col) const;
+
  private:
   CVEditFile      *vfile_;
   CIBBox2D         bbox_;
   CVEditLineStyle  style_;
   bool             extraCharChanged_;
+  int              syntaxState_ { -1 };
+  bool             syntaxValid_ { false };
+  mutable CTabMap  tab_map_;
 };
 
 #endif
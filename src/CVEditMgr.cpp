@@ -1,4 +1,5 @@
 #include <CVEditMgr.h>
+#include <CStrUtil.h>
 
 CVEditMgr *
 CVEditMgr::
@@ -78,3 +79,42 @@ drawString(const CIPoint2D &p, const std::string &str)
 {
   renderer_->drawString(p, str);
 }
+
+void
+CVEditMgr::
+drawRun(const CIBBox2D &bbox, const std::string &str, const CRGBA &bg,
+        const CRGBA &fg, bool filled)
+{
+  renderer_->drawRun(bbox, str, bg, fg, filled);
+}
+
+void
+CVEditMgr::
+drawNumber(const CIPoint2D &p, uint num, const CRGBA &fg)
+{
+  renderer_->drawNumber(p, num, fg);
+}
+
+//------
+
+void
+CVEditRenderer::
+drawRun(const CIBBox2D &bbox, const std::string &str, const CRGBA &bg,
+        const CRGBA &fg, bool filled)
+{
+  if (! filled)
+    fillRectangle(bbox, bg);
+
+  setForeground(fg);
+
+  drawString(CIPoint2D(bbox.getXMin(), bbox.getYMin()), str);
+}
+
+void
+CVEditRenderer::
+drawNumber(const CIPoint2D &p, uint num, const CRGBA &fg)
+{
+  setForeground(fg);
+
+  drawString(p, CStrUtil::toString(num));
+}
@@ -52,6 +52,13 @@ class CVEditRenderer {
   virtual void drawChar(const CIPoint2D &p, char c) = 0;
 
   virtual void drawString(const CIPoint2D &p, const std::string &str) = 0;
+
+  // draw run of chars with same style at top left of bbox (bg not filled if filled)
+  virtual void drawRun(const CIBBox2D &bbox, const std::string &str, const CRGBA &bg,
+                       const CRGBA &fg, bool filled);
+
+  // draw decimal number at top left (line number gutter)
+  virtual void drawNumber(const CIPoint2D &p, uint num, const CRGBA &fg);
 };
 
 //---
@@ -80,6 +87,11 @@ class CVEditMgr {
 
   void drawString(const CIPoint2D &p, const std::string &str);
 
+  void drawRun(const CIBBox2D &bbox, const std::string &str, const CRGBA &bg,
+               const CRGBA &fg, bool filled);
+
+  void drawNumber(const CIPoint2D &p, uint num, const CRGBA &fg);
+
  private:
   CVEditMgr();
 
@@ -0,0 +1,138 @@
+#include <CVEditRecordRenderer.h>
+#include <CStrUtil.h>
+
+CVEditRecordRenderer::
+CVEditRecordRenderer(bool record) :
+ record_(record)
+{
+  reset();
+}
+
+void
+CVEditRecordRenderer::
+reset()
+{
+  for (int i = 0; i < NUM_OP_TYPES; ++i)
+    counts_[i] = 0;
+
+  numChars_ = 0;
+
+  ops_.clear();
+}
+
+uint
+CVEditRecordRenderer::
+numCalls() const
+{
+  uint n = 0;
+
+  for (int i = 0; i < NUM_OP_TYPES; ++i) {
+    if (OpType(i) == OpType::SET_FONT || OpType(i) == OpType::SET_FOREGROUND)
+      continue;
+
+    n += counts_[i];
+  }
+
+  return n;
+}
+
+void
+CVEditRecordRenderer::
+fill(const CRGBA &bg)
+{
+  addOp(OpType::FILL, CIBBox2D(), "", bg);
+}
+
+void
+CVEditRecordRenderer::
+setFont(CFontPtr)
+{
+  addOp(OpType::SET_FONT, CIBBox2D());
+}
+
+void
+CVEditRecordRenderer::
+setForeground(const CRGBA &fg)
+{
+  fg_ = fg;
+
+  addOp(OpType::SET_FOREGROUND, CIBBox2D());
+}
+
+void
+CVEditRecordRenderer::
+fillRectangle(const CIBBox2D &rect, const CRGBA &rgba)
+{
+  addOp(OpType::FILL_RECTANGLE, rect, "", rgba);
+}
+
+void
+CVEditRecordRenderer::
+drawChar(const CIPoint2D &p, char c)
+{
+  ++numChars_;
+
+  addOp(OpType::DRAW_CHAR, CIBBox2D(p, p), std::string(1, c));
+}
+
+void
+CVEditRecordRenderer::
+drawString(const CIPoint2D &p, const std::string &str)
+{
+  numChars_ += uint(str.size());
+
+  addOp(OpType::DRAW_STRING, CIBBox2D(p, p), str);
+}
+
+void
+CVEditRecordRenderer::
+drawRun(const CIBBox2D &bbox, const std::string &str, const CRGBA &bg,
+        const CRGBA &fg, bool filled)
+{
+  // counted as one call (as a real renderer would draw it)
+  fg_ = fg;
+
+  numChars_ += uint(str.size());
+
+  // bg only drawn if not already filled
+  if (! filled)
+    ++counts_[int(OpType::FILL_RECTANGLE)];
+
+  addOp(OpType::DRAW_RUN, bbox, str, bg);
+}
+
+void
+CVEditRecordRenderer::
+drawNumber(const CIPoint2D &p, uint num, const CRGBA &fg)
+{
+  fg_ = fg;
+
+  for (uint n = num; ; n /= 10) {
+    ++numChars_;
+
+    if (n < 10)
+      break;
+  }
+
+  addOp(OpType::DRAW_NUMBER, CIBBox2D(p, p), (record_ ? CStrUtil::toString(num) : ""));
+}
+
+void
+CVEditRecordRenderer::
+addOp(OpType type, const CIBBox2D &bbox, const std::string &str, const CRGBA &bg)
+{
+  ++counts_[int(type)];
+
+  if (! record_)
+    return;
+
+  Op op;
+
+  op.type = type;
+  op.bbox = bbox;
+  op.str  = str;
+  op.fg   = fg_;
+  op.bg   = bg;
+
+  ops_.push_back(op);
+}
@@ -0,0 +1,87 @@
+#ifndef CVEDIT_RECORD_RENDERER_H
+#define CVEDIT_RECORD_RENDERER_H
+
+#include <CVEditMgr.h>
+#include <vector>
+
+// Headless renderer which counts (and optionally records) draw calls.
+//
+// Used to measure paint work of CVEditFile::draw without a display (e.g. draw
+// calls per frame for scroll/edit scenarios) and to check what was drawn.
+class CVEditRecordRenderer : public CVEditRenderer {
+ public:
+  enum class OpType {
+    FILL,
+    SET_FONT,
+    SET_FOREGROUND,
+    FILL_RECTANGLE,
+    DRAW_CHAR,
+    DRAW_STRING,
+    DRAW_RUN,
+    DRAW_NUMBER
+  };
+
+  static const int NUM_OP_TYPES = int(OpType::DRAW_NUMBER) + 1;
+
+  struct Op {
+    OpType      type { OpType::FILL };
+    CIBBox2D    bbox;
+    std::string str;
+    CRGBA       fg;
+    CRGBA       bg;
+  };
+
+  using Ops = std::vector<Op>;
+
+ public:
+  CVEditRecordRenderer(bool record=false);
+
+  // record ops as well as counting them
+  bool isRecord() const { return record_; }
+  void setRecord(bool record) { record_ = record; }
+
+  // clear counts and recorded ops
+  void reset();
+
+  // number of draw calls (excluding font/color state changes)
+  uint numCalls() const;
+
+  uint numCalls(OpType type) const { return counts_[int(type)]; }
+
+  // number of chars drawn
+  uint numChars() const { return numChars_; }
+
+  const Ops &ops() const { return ops_; }
+
+  //---
+
+  void fill(const CRGBA &bg) override;
+
+  void setFont(CFontPtr font) override;
+
+  void setForeground(const CRGBA &fg) override;
+
+  void fillRectangle(const CIBBox2D &rect, const CRGBA &rgba) override;
+
+  void drawChar(const CIPoint2D &p, char c) override;
+
+  void drawString(const CIPoint2D &p, const std::string &str) override;
+
+  void drawRun(const CIBBox2D &bbox, const std::string &str, const CRGBA &bg,
+               const CRGBA &fg, bool filled) override;
+
+  void drawNumber(const CIPoint2D &p, uint num, const CRGBA &fg) override;
+
+ private:
+  void addOp(OpType type, const CIBBox2D &bbox, const std::string &str=std::string(),
+             const CRGBA &bg=CRGBA());
+
+ private:
+  bool  record_   { false };
+  uint  counts_[NUM_OP_TYPES];
+  uint  numChars_ { 0 };
+  CRGBA fg_;
+  Ops   ops_;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include <CVEditSelection.h>
+
+namespace {
+
+bool
+posLess(const CIPoint2D &p1, const CIPoint2D &p2)
+{
+  return (p1.y < p2.y || (p1.y == p2.y && p1.x < p2.x));
+}
+
+}
+
+CVEditSelection::
+CVEditSelection()
+{
+}
+
+void
+CVEditSelection::
+clear()
+{
+  ranges_.clear();
+  blocks_.clear();
+}
+
+void
+CVEditSelection::
+addRange(const CIPoint2D &start, const CIPoint2D &end)
+{
+  Range range;
+
+  if (posLess(end, start)) {
+    range.start = end;
+    range.end   = start;
+  }
+  else {
+    range.start = start;
+    range.end   = end;
+  }
+
+  ranges_.push_back(range);
+}
+
+void
+CVEditSelection::
+addBlock(const CIBBox2D &bbox)
+{
+  blocks_.push_back(bbox);
+}
+
+void
+CVEditSelection::
+linesAdded(int line_num, int n)
+{
+  for (auto &range : ranges_) {
+    if (range.start.y >= line_num) range.start.y += n;
+    if (range.end  .y >= line_num) range.end  .y += n;
+  }
+
+  blocks_.clear();
+}
+
+void
+CVEditSelection::
+linesDeleted(int line_num, int n)
+{
+  int line_num2 = line_num + n;
+
+  uint i = 0;
+
+  for (auto &range : ranges_) {
+    // start in removed lines moves to start of next line, end to before it
+    if      (range.start.y >= line_num2) range.start.y -= n;
+    else if (range.start.y >= line_num ) range.start = CIPoint2D(0, line_num);
+
+    if      (range.end.y >= line_num2) range.end.y -= n;
+    else if (range.end.y >= line_num ) range.end = CIPoint2D(-1, line_num);
+
+    if (! posLess(range.end, range.start))
+      ranges_[i++] = range;
+  }
+
+  ranges_.resize(i);
+
+  blocks_.clear();
+}
+
+//---
+
+bool
+CVEditSelection::
+isRangeSelected(int line_num, int char_num) const
+{
+  CIPoint2D pos(char_num, line_num);
+
+  for (const auto &range : ranges_) {
+    if (! posLess(pos, range.start) && ! posLess(range.end, pos))
+      return true;
+  }
+
+  return false;
+}
+
+bool
+CVEditSelection::
+isBlockSelected(const CIBBox2D &cbbox) const
+{
+  for (const auto &bbox : blocks_) {
+    if (cbbox.getXMax() < bbox.getXMin() || cbbox.getXMin() > bbox.getXMax() ||
+        cbbox.getYMax() < bbox.getYMin() || cbbox.getYMin() > bbox.getYMax())
+      continue;
+
+    return true;
+  }
+
+  return false;
+}
+
+bool
+CVEditSelection::
+isRangeEndLine(int line_num) const
+{
+  for (const auto &range : ranges_) {
+    if (range.start.y == line_num || range.end.y == line_num)
+      return true;
+  }
+
+  return false;
+}
+
+bool
+CVEditSelection::
+isRangeLine(int line_num) const
+{
+  for (const auto &range : ranges_) {
+    if (line_num >= range.start.y && line_num <= range.end.y)
+      return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,71 @@
+#ifndef CVEDIT_SELECTION_H
+#define CVEDIT_SELECTION_H
+
+#include <CIPoint2D.h>
+#include <CIBBox2D.h>
+#include <vector>
+
+// Selected chars of a file as position ranges and/or blocks.
+//
+// A range is all chars from one position to another (inclusive, x is char and
+// y is line, either order) and a block is the chars whose cells overlap a box
+// (file coords, box select). Selecting or clearing is O(1) and a char is
+// tested in O(number of ranges) (usually one) while drawing instead of each
+// char holding a selected flag.
+class CVEditSelection {
+ public:
+  CVEditSelection();
+
+  void clear();
+
+  bool isEmpty() const { return ranges_.empty() && blocks_.empty(); }
+
+  // add range from start to end (inclusive)
+  void addRange(const CIPoint2D &start, const CIPoint2D &end);
+
+  // add chars in box
+  void addBlock(const CIBBox2D &bbox);
+
+  // n lines inserted or removed at line_num : ranges move with their lines
+  // and are clipped to the lines left (dropped if all removed). Blocks are
+  // cell boxes, not lines, so are dropped.
+  void linesAdded  (int line_num, int n);
+  void linesDeleted(int line_num, int n);
+
+  //---
+
+  // is char of line selected by a range
+  bool isRangeSelected(int line_num, int char_num) const;
+
+  // is char cell selected by a block
+  bool isBlockSelected(const CIBBox2D &cbbox) const;
+
+  bool hasBlocks() const { return ! blocks_.empty(); }
+
+  // does line contain start/end of a range
+  bool isRangeEndLine(int line_num) const;
+
+  // is line (partly) selected by a range
+  bool isRangeLine(int line_num) const;
+
+  //---
+
+  struct Range {
+    CIPoint2D start; // first selected char
+    CIPoint2D end;   // last selected char
+  };
+
+  using Ranges = std::vector<Range>;
+  using Blocks = std::vector<CIBBox2D>;
+
+  // ranges in order added (start <= end)
+  const Ranges &ranges() const { return ranges_; }
+
+  const Blocks &blocks() const { return blocks_; }
+
+ private:
+  Ranges ranges_;
+  Blocks blocks_;
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <CStrUtil.h>
 #include <CVLineEdit.h>
 #include <cstring>
+#include <chrono>
 
 class LineEditRenderer : public CVLineEditRenderer {
   void setForeground(const CRGBA &rgba) override {
@@ -37,6 +38,10 @@ void
 CVEditVi::
 processChar(const CKeyEvent &event)
 {
+  // record typed keys (not keys replayed by '.' or '@')
+  if (isRecording() && playDepth_ == 0)
+    recordKeys_.push_back(event);
+
   if      (getInsertMode())
     processInsertChar(event);
   else if (getCmdLineMode())
@@ -80,6 +85,34 @@ processCommandChar(const CKeyEvent &event)
 
         goto done;
       }
+      case CKEY_TYPE_q: { // start recording keys to register
+        if (isalnum(c))
+          startRecording(c);
+        else
+          error("Invalid register name '" + std::string(&c, 1) + "'");
+
+        goto done;
+      }
+      case CKEY_TYPE_At: { // play keys in register
+        uint n = std::max(count_, 1U);
+
+        count_   = 0;
+        lastKey_ = CKEY_TYPE_NUL;
+
+        // @@ repeats last played register
+        if (key == CKEY_TYPE_At) {
+          if (playRegister_ == '\0') {
+            error("No previous register");
+            return;
+          }
+
+          c = playRegister_;
+        }
+
+        playRegister(c, n);
+
+        return;
+      }
       case CKEY_TYPE_QuoteDbl: { // set register
         if      (key == CKEY_TYPE_TAB || key == CKEY_TYPE_Tab || key == CKEY_TYPE_KP_Tab) {
           file_->displayRegisters();
@@ -120,8 +153,7 @@ processCommandChar(const CKeyEvent &event)
         else if (key == CKEY_TYPE_l) {
           setInsertMode(true);
 
-          for (uint i = 0; i < std::max(count_, 1U); ++i)
-            file_->deleteChar();
+          file_->deleteCharsRight(std::max(count_, 1U));
         }
         else {
           auto start = file_->getPos();
@@ -145,11 +177,11 @@ processCommandChar(const CKeyEvent &event)
       }
       case CKEY_TYPE_d: { // delete
         if      (key == CKEY_TYPE_d)
-          file_->deleteLine();
+          file_->deleteLines(file_->getRow(), std::max(count_, 1U));
         else if (key == CKEY_TYPE_w)
           file_->deleteWord();
         else if (key == CKEY_TYPE_l)
-          file_->deleteChar();
+          file_->deleteCharsRight(std::max(count_, 1U));
         else {
           auto start = file_->getPos();
           auto end   = start;
@@ -161,6 +193,7 @@ processCommandChar(const CKeyEvent &event)
         }
 
         lastCommand_.clear();
+        lastCommand_.addCount(count_);
         lastCommand_.addKey(lastKey_);
         lastCommand_.addKey(key);
 
@@ -177,6 +210,16 @@ processCommandChar(const CKeyEvent &event)
         break;
       }
       case CKEY_TYPE_g: { // test code !!!
+        // move by screen rows (differs from j/k for wrapped lines)
+        if      (key == CKEY_TYPE_j) {
+          file_->cursorScreenDown(std::max(count_, 1U));
+          break;
+        }
+        else if (key == CKEY_TYPE_k) {
+          file_->cursorScreenUp(std::max(count_, 1U));
+          break;
+        }
+
         file_->setSelectRange(file_->getPos(), file_->getPos());
 
         auto select_end = file_->getSelectEnd();
@@ -242,6 +285,22 @@ processCommandChar(const CKeyEvent &event)
           file_->scrollBottom();
         else if (key == CKEY_TYPE_t)
           file_->scrollTop();
+        else if (key == CKEY_TYPE_c) // fold close
+          file_->closeFold(file_->getRow());
+        else if (key == CKEY_TYPE_o) // fold open
+          file_->openFold(file_->getRow());
+        else if (key == CKEY_TYPE_a) // fold toggle
+          file_->toggleFold(file_->getRow());
+        else if (key == CKEY_TYPE_R) // open all folds
+          file_->openAllFolds();
+        else if (key == CKEY_TYPE_M) { // close all folds
+          if (file_->getFoldTree().numFolds() == 0)
+            file_->createAllFolds();
+
+          file_->closeAllFolds();
+        }
+        else if (key == CKEY_TYPE_E) // remove all folds
+          file_->removeAllFolds();
 
         break;
       }
@@ -290,12 +349,12 @@ processCommandChar(const CKeyEvent &event)
         auto end   = start;
 
         if      (key == CKEY_TYPE_Less)
-          file_->shiftLeft(start.y, end.y);
+          file_->shiftLeft(start.y, countEndLine(start.y));
         else {
           bool rc = processMoveChar(event, end);
 
           if (rc)
-            file_->shiftRight(start.y, end.y);
+            file_->shiftLeft(start.y, end.y);
         }
 
         break;
@@ -305,7 +364,7 @@ processCommandChar(const CKeyEvent &event)
         auto end   = start;
 
         if      (key == CKEY_TYPE_Greater)
-          file_->shiftRight(start.y, end.y);
+          file_->shiftRight(start.y, countEndLine(start.y));
         else {
           bool rc = processMoveChar(event, end);
 
@@ -382,7 +441,8 @@ processNormalChar(const CKeyEvent &event)
     // cursor movement
     case CKEY_TYPE_h:
     case CKEY_TYPE_BackSpace: {
-      file_->cursorLeft(std::max(count_, 1U));
+      if (! file_->cursorLeft(std::max(count_, 1U)))
+        bell();
 
       break;
     }
@@ -397,7 +457,8 @@ processNormalChar(const CKeyEvent &event)
       break;
     }
     case CKEY_TYPE_j: {
-      file_->cursorDown(std::max(count_, 1U));
+      if (! file_->cursorDown(std::max(count_, 1U)))
+        bell();
 
       break;
     }
@@ -415,7 +476,8 @@ processNormalChar(const CKeyEvent &event)
       break;
     }
     case CKEY_TYPE_k: {
-      file_->cursorUp(std::max(count_, 1U));
+      if (! file_->cursorUp(std::max(count_, 1U)))
+        bell();
 
       break;
     }
@@ -435,7 +497,8 @@ processNormalChar(const CKeyEvent &event)
     case CKEY_TYPE_l:
     case CKEY_TYPE_Space:
     case CKEY_TYPE_FF: {
-      file_->cursorRight(std::max(count_, 1U));
+      if (! file_->cursorRight(std::max(count_, 1U)))
+        bell();
 
       break;
     }
@@ -695,7 +758,15 @@ processNormalChar(const CKeyEvent &event)
             break;
         }
 
-        if      (c == '(')
+        uint line_num1, char_num1;
+
+        // with syntax an unmatched bracket or one in a string or comment
+        // has no match, otherwise scan for the bracket
+        if      (file_->getSyntax()) {
+          if (file_->findMatchingBracket(file_->getRow(), file_->getCol(), line_num1, char_num1))
+            file_->cursorTo(line_num1, char_num1);
+        }
+        else if (c == '(')
           file_->findNextChar(')', true);
         else if (c == '[')
           file_->findNextChar(']', true);
@@ -730,8 +801,8 @@ processNormalChar(const CKeyEvent &event)
       break;
 
     case CKEY_TYPE_At: // execute command in buffer
-      error("Unimplemented");
-      break;
+      lastKey_ = key;
+      return;
 
     case CKEY_TYPE_Equal: // filter through format command
       error("Unimplemented");
@@ -846,9 +917,11 @@ processNormalChar(const CKeyEvent &event)
     }
 
     case CKEY_TYPE_J:
-      file_->joinLine();
+      // count is number of lines to join (at least two)
+      file_->joinLines(file_->getRow(), std::max(count_, 2U) - 1);
 
       lastCommand_.clear();
+      lastCommand_.addCount(count_);
       lastCommand_.addKey(key);
 
       break;
@@ -891,9 +964,14 @@ processNormalChar(const CKeyEvent &event)
 
       break;
 
-    case CKEY_TYPE_q:
-      error("Unimplemented");
-      break;
+    case CKEY_TYPE_q: // start/stop recording
+      if (isRecording()) {
+        stopRecording();
+        break;
+      }
+
+      lastKey_ = key;
+      return;
 
     case CKEY_TYPE_u: // undo last change
       file_->undo();
@@ -975,12 +1053,7 @@ processNormalChar(const CKeyEvent &event)
 
     case CKEY_TYPE_x:
     case CKEY_TYPE_DEL: {
-      file_->startGroup();
-
-      for (uint i = 0; i < std::max(count_, 1U); ++i)
-        file_->deleteChar();
-
-      file_->endGroup();
+      file_->deleteCharsRight(std::max(count_, 1U));
 
       lastCommand_.clear();
       lastCommand_.addCount(count_);
@@ -989,14 +1062,7 @@ processNormalChar(const CKeyEvent &event)
       break;
     }
     case CKEY_TYPE_X: {
-      file_->startGroup();
-
-      for (uint i = 0; i < std::max(count_, 1U); ++i) {
-        file_->cursorLeft(1);
-        file_->deleteChar();
-      }
-
-      file_->endGroup();
+      file_->deleteCharsLeft(std::max(count_, 1U));
 
       lastCommand_.clear();
       lastCommand_.addCount(count_);
@@ -1017,8 +1083,12 @@ processNormalChar(const CKeyEvent &event)
       break;
 
     case CKEY_TYPE_Period: {
+      ++playDepth_;
+
       lastCommand_.exec();
 
+      --playDepth_;
+
       break;
     }
 
@@ -1363,10 +1433,15 @@ void
 CVEditVi::
 normalInsertChar(const CKeyEvent &event)
 {
+  char c = event.getText()[0];
+
   if (file_->getOverwriteMode())
-    file_->replaceChar(event.getText()[0]);
+    file_->replaceChar(c);
   else
-    file_->insertChar(event.getText()[0]);
+    file_->insertChar(c);
+
+  if (file_->getOptions().showmatch && c != '\0' && strchr(")]}", c))
+    file_->showMatchingBracket();
 
   count_    = 0;
   lastKey_  = CKEY_TYPE_NUL;
@@ -1457,6 +1532,15 @@ processMoveChar(const CKeyEvent &event, CIPoint2D &new_pos)
 
 //---
 
+uint
+CVEditVi::
+countEndLine(uint line_num) const
+{
+  uint line_num2 = line_num + std::max(count_, 1U) - 1;
+
+  return std::min(line_num2, file_->getNumLines() - 1);
+}
+
 bool
 CVEditVi::
 doFindChar(char c, uint count, bool forward, bool till)
@@ -1500,7 +1584,7 @@ setInsertMode(bool insertMode)
 
   file_->setOverwriteMode(false);
 
-  file_->stateChanged();
+  file_->notifyStateChanged();
 
   if (insertMode) {
     file_->startGroup();
@@ -1559,9 +1643,137 @@ void
 CVEditVi::
 error(const std::string &msg) const
 {
+  bell();
+
   std::cerr << msg << std::endl;
 }
 
+void
+CVEditVi::
+bell() const
+{
+  // stops macro playback
+  ++numErrors_;
+}
+
+//---
+
+void
+CVEditVi::
+startRecording(char c)
+{
+  // upper case register appends to lower case one
+  char id = char(tolower(c));
+
+  if (isupper(c))
+    recordKeys_ = macros_[id];
+  else
+    recordKeys_.clear();
+
+  recordRegister_ = id;
+
+  file_->notifyStateChanged();
+}
+
+void
+CVEditVi::
+stopRecording()
+{
+  if (! isRecording())
+    return;
+
+  // remove terminating 'q'
+  if (! recordKeys_.empty())
+    recordKeys_.pop_back();
+
+  macros_[recordRegister_] = recordKeys_;
+
+  recordKeys_.clear();
+
+  recordRegister_ = '\0';
+
+  file_->notifyStateChanged();
+}
+
+bool
+CVEditVi::
+playRegister(char c, uint n)
+{
+  // guard against register playing itself forever
+  static const uint MAX_PLAY_DEPTH = 100;
+
+  char id = char(tolower(c));
+
+  auto p = macros_.find(id);
+
+  if (p == macros_.end() || (*p).second.empty()) {
+    error("Register '" + std::string(&c, 1) + "' is empty");
+    return false;
+  }
+
+  if (playDepth_ >= MAX_PLAY_DEPTH) {
+    error("Recursive register");
+    return false;
+  }
+
+  playRegister_ = id;
+
+  // copy keys as register can be re-recorded while playing
+  auto keys = (*p).second;
+
+  auto t1 = std::chrono::steady_clock::now();
+
+  uint numErrors = numErrors_;
+  uint numKeys   = 0;
+
+  ++playDepth_;
+
+  file_->startBatch();
+
+  // one undo step for whole playback
+  file_->startUndoGroup();
+
+  // stop on first error (like vim)
+  for (uint i = 0; i < n && numErrors_ == numErrors; ++i) {
+    for (const auto &event : keys) {
+      processChar(event);
+
+      ++numKeys;
+
+      if (numErrors_ != numErrors)
+        break;
+    }
+  }
+
+  file_->endUndoGroup();
+
+  --playDepth_;
+
+  // only report outermost playback (state notify is sent with batch ones)
+  if (playDepth_ == 0) {
+    auto t2 = std::chrono::steady_clock::now();
+
+    playKeys_ = numKeys;
+    playSecs_ = std::chrono::duration<double>(t2 - t1).count();
+
+    file_->notifyStateChanged();
+  }
+
+  file_->endBatch();
+
+  return (numErrors_ == numErrors);
+}
+
+double
+CVEditVi::
+getPlayRate() const
+{
+  if (playSecs_ <= 0.0)
+    return 0.0;
+
+  return playKeys_/playSecs_;
+}
+
 //-------
 
 CVEditLastCommand::
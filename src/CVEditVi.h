@@ -2,15 +2,16 @@
 #define CVEDIT_VI_H
 
 #include <CKeyType.h>
+#include <CEvent.h>
 #include <CIPoint2D.h>
 #include <CIBBox2D.h>
 
 #include <string>
 #include <vector>
+#include <map>
 #include <sys/types.h>
 
 class CVEditFile;
-class CKeyEvent;
 
 class CVEditLastCommand {
  public:
@@ -59,10 +60,38 @@ class CVEditVi {
 
   bool doFindChar(char c, uint count, bool forward, bool till);
 
+  // last line of count lines from line_num (clamped to file)
+  uint countEndLine(uint line_num) const;
+
   void drawCmdLine(const CIBBox2D &bbox);
 
   void error(const std::string &mgs) const;
 
+  // command failed (stops macro playback)
+  void bell() const;
+
+  //---
+
+  // macros (q{reg} records keys to register, @{reg} plays them back)
+  bool isRecording() const { return recordRegister_ != '\0'; }
+  char getRecordRegister() const { return recordRegister_; }
+
+  void startRecording(char c);
+  void stopRecording();
+
+  bool playRegister(char c, uint n=1);
+
+  // keys and seconds of last playback
+  uint   getPlayKeys() const { return playKeys_; }
+  double getPlaySecs() const { return playSecs_; }
+
+  // keys per second of last playback
+  double getPlayRate() const;
+
+ private:
+  using KeyEvents = std::vector<CKeyEvent>;
+  using Macros    = std::map<char, KeyEvents>;
+
  private:
   CVEditFile        *file_        { nullptr };
   CKeyType           lastKey_     { CKEY_TYPE_NUL };
@@ -75,6 +104,17 @@ class CVEditVi {
   char               findChar_    { '\0' };
   bool               findForward_ { true };
   bool               findTill_    { false };
+
+  // macros
+  Macros    macros_;
+  KeyEvents recordKeys_;
+  char      recordRegister_ { '\0' };
+  char      playRegister_   { '\0' };
+  uint      playDepth_      { 0 };
+  uint      playKeys_       { 0 };
+  double    playSecs_       { 0.0 };
+
+  mutable uint numErrors_ { 0 };
 };
 
 #endif
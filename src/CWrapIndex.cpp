@@ -0,0 +1,449 @@
+#include <CWrapIndex.h>
+#include <algorithm>
+
+CWrapIndex::
+CWrapIndex()
+{
+}
+
+void
+CWrapIndex::
+reset(uint num_lines)
+{
+  nodes_.clear();
+  free_ .clear();
+
+  root_ = NIL;
+
+  if (num_lines == 0)
+    return;
+
+  nodes_.reserve(num_lines);
+
+  // build treap of lines in O(n) (see CFoldTree::reset)
+  Inds stack;
+
+  for (uint i = 0; i < num_lines; ++i) {
+    uint t = newNode();
+
+    uint last = NIL;
+
+    while (! stack.empty() && nodes_[stack.back()].prio < nodes_[t].prio) {
+      last = stack.back();
+
+      stack.pop_back();
+    }
+
+    nodes_[t].left = last;
+
+    if (! stack.empty())
+      nodes_[stack.back()].right = t;
+
+    stack.push_back(t);
+  }
+
+  root_ = stack[0];
+
+  // update sizes and sums bottom up
+  Inds order;
+
+  order.reserve(num_lines);
+
+  stack.clear();
+
+  stack.push_back(root_);
+
+  while (! stack.empty()) {
+    uint t = stack.back();
+
+    stack.pop_back();
+
+    order.push_back(t);
+
+    if (nodes_[t].left  != NIL) stack.push_back(nodes_[t].left );
+    if (nodes_[t].right != NIL) stack.push_back(nodes_[t].right);
+  }
+
+  for (auto p = order.rbegin(); p != order.rend(); ++p)
+    pull(*p);
+}
+
+uint
+CWrapIndex::
+numRows() const
+{
+  return sum(root_);
+}
+
+void
+CWrapIndex::
+setWidth(uint width)
+{
+  width = std::max(width, 1U);
+
+  if (width == width_)
+    return;
+
+  width_ = width;
+
+  // all lines are now stale
+  invalidateAll();
+}
+
+uint
+CWrapIndex::
+colsToRows(uint cols, uint width)
+{
+  if (width == 0)
+    return 1;
+
+  return std::max((cols + width - 1)/width, 1U);
+}
+
+//---
+
+void
+CWrapIndex::
+addLine(uint line_num, uint rows, uint cols)
+{
+  line_num = std::min(line_num, numLines());
+
+  uint t = newNode();
+
+  nodes_[t].rows = rows;
+  nodes_[t].sum  = rows;
+  nodes_[t].cols = cols;
+  nodes_[t].max  = cols;
+
+  uint l, r;
+
+  split(root_, line_num, l, r);
+
+  root_ = merge(merge(l, t), r);
+}
+
+void
+CWrapIndex::
+deleteLine(uint line_num)
+{
+  if (line_num >= numLines())
+    return;
+
+  uint l, m, r;
+
+  split(root_, line_num, l, r);
+  split(r, 1, m, r);
+
+  free_.push_back(m);
+
+  root_ = merge(l, r);
+}
+
+uint
+CWrapIndex::
+rows(uint line_num) const
+{
+  uint t = nodeAt(line_num);
+
+  return (t != NIL ? nodes_[t].rows : 0);
+}
+
+void
+CWrapIndex::
+setRows(uint line_num, uint rows)
+{
+  Inds path;
+
+  pathTo(line_num, path);
+
+  if (path.empty())
+    return;
+
+  auto &node = nodes_[path.back()];
+
+  node.gen = gen_;
+
+  if (node.rows == rows)
+    return;
+
+  node.rows = rows;
+
+  // update sums from line up to root
+  for (auto p = path.rbegin(); p != path.rend(); ++p)
+    pull(*p);
+}
+
+bool
+CWrapIndex::
+isValid(uint line_num) const
+{
+  uint t = nodeAt(line_num);
+
+  return (t != NIL && nodes_[t].gen == gen_);
+}
+
+void
+CWrapIndex::
+invalidate(uint line_num)
+{
+  uint t = nodeAt(line_num);
+
+  if (t != NIL)
+    nodes_[t].gen = 0;
+}
+
+uint
+CWrapIndex::
+cols(uint line_num) const
+{
+  uint t = nodeAt(line_num);
+
+  return (t != NIL ? nodes_[t].cols : 0);
+}
+
+void
+CWrapIndex::
+setCols(uint line_num, uint cols)
+{
+  Inds path;
+
+  pathTo(line_num, path);
+
+  if (path.empty() || nodes_[path.back()].cols == cols)
+    return;
+
+  nodes_[path.back()].cols = cols;
+
+  // update maximums from line up to root
+  for (auto p = path.rbegin(); p != path.rend(); ++p)
+    pull(*p);
+}
+
+uint
+CWrapIndex::
+maxCols() const
+{
+  return max(root_);
+}
+
+//---
+
+uint
+CWrapIndex::
+lineToRow(uint line_num) const
+{
+  // rows of lines in [0, line_num)
+  uint t   = root_;
+  uint row = 0;
+
+  while (t != NIL) {
+    const auto &node = nodes_[t];
+
+    uint lsize = size(node.left);
+
+    if (line_num <= lsize)
+      t = node.left;
+    else {
+      row += sum(node.left) + node.rows;
+
+      line_num -= lsize + 1;
+
+      t = node.right;
+    }
+  }
+
+  return row;
+}
+
+uint
+CWrapIndex::
+rowToLine(uint row, uint &sub_row) const
+{
+  sub_row = 0;
+
+  if (row >= numRows())
+    return numLines();
+
+  uint t    = root_;
+  uint line = 0;
+
+  while (t != NIL) {
+    const auto &node = nodes_[t];
+
+    uint lsum = sum(node.left);
+
+    if      (row < lsum)
+      t = node.left;
+    else if (row < lsum + node.rows) {
+      sub_row = row - lsum;
+
+      return line + size(node.left);
+    }
+    else {
+      row  -= lsum + node.rows;
+      line += size(node.left) + 1;
+
+      t = node.right;
+    }
+  }
+
+  return numLines();
+}
+
+//---
+
+uint
+CWrapIndex::
+newNode()
+{
+  uint t;
+
+  if (! free_.empty()) {
+    t = free_.back();
+
+    free_.pop_back();
+
+    nodes_[t] = Node();
+  }
+  else {
+    t = uint(nodes_.size());
+
+    nodes_.emplace_back();
+  }
+
+  nodes_[t].prio = random();
+
+  return t;
+}
+
+void
+CWrapIndex::
+pull(uint t)
+{
+  auto &node = nodes_[t];
+
+  node.size = 1 + size(node.left) + size(node.right);
+  node.sum  = node.rows + sum(node.left) + sum(node.right);
+  node.max  = std::max({node.cols, max(node.left), max(node.right)});
+}
+
+void
+CWrapIndex::
+split(uint t, uint pos, uint &l, uint &r)
+{
+  // first pos lines to l, rest to r
+  if (t == NIL) {
+    l = r = NIL;
+    return;
+  }
+
+  uint lsize = size(nodes_[t].left);
+
+  if (pos <= lsize) {
+    uint l1;
+
+    split(nodes_[t].left, pos, l, l1);
+
+    nodes_[t].left = l1;
+
+    r = t;
+  }
+  else {
+    uint r1;
+
+    split(nodes_[t].right, pos - lsize - 1, r1, r);
+
+    nodes_[t].right = r1;
+
+    l = t;
+  }
+
+  pull(t);
+}
+
+uint
+CWrapIndex::
+merge(uint l, uint r)
+{
+  if (l == NIL) return r;
+  if (r == NIL) return l;
+
+  if (nodes_[l].prio > nodes_[r].prio) {
+    uint r1 = merge(nodes_[l].right, r);
+
+    nodes_[l].right = r1;
+
+    pull(l);
+
+    return l;
+  }
+  else {
+    uint l1 = merge(l, nodes_[r].left);
+
+    nodes_[r].left = l1;
+
+    pull(r);
+
+    return r;
+  }
+}
+
+uint
+CWrapIndex::
+nodeAt(uint pos) const
+{
+  uint t = root_;
+
+  while (t != NIL) {
+    uint lsize = size(nodes_[t].left);
+
+    if      (pos < lsize)
+      t = nodes_[t].left;
+    else if (pos > lsize) {
+      pos -= lsize + 1;
+
+      t = nodes_[t].right;
+    }
+    else
+      break;
+  }
+
+  return t;
+}
+
+void
+CWrapIndex::
+pathTo(uint pos, Inds &path) const
+{
+  uint t = root_;
+
+  while (t != NIL) {
+    path.push_back(t);
+
+    uint lsize = size(nodes_[t].left);
+
+    if      (pos < lsize)
+      t = nodes_[t].left;
+    else if (pos > lsize) {
+      pos -= lsize + 1;
+
+      t = nodes_[t].right;
+    }
+    else
+      return;
+  }
+
+  path.clear();
+}
+
+uint
+CWrapIndex::
+random()
+{
+  // xorshift
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 17;
+  seed_ ^= seed_ << 5;
+
+  return seed_;
+}
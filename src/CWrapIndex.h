@@ -0,0 +1,121 @@
+#ifndef CWRAP_INDEX_H
+#define CWRAP_INDEX_H
+
+#include <sys/types.h>
+#include <vector>
+
+// Visual rows of each document line when long lines are soft wrapped.
+//
+// Lines are held in a treap keyed by line position with subtree row sums so
+// row <-> line mapping, inserting or deleting a line and changing a line's
+// row count are O(log n). Row counts are set by the owner (which knows the
+// line's display width). Changing the wrap width only bumps a generation so
+// lines keep their old count (stale) until the owner next asks for them,
+// i.e. lines off screen are updated lazily. Lines also hold their display
+// columns (set by the owner) with subtree maximums for the widest line.
+class CWrapIndex {
+ public:
+  CWrapIndex();
+
+  // reset to num_lines lines of one (stale) row
+  void reset(uint num_lines=0);
+
+  uint numLines() const { return size(root_); }
+
+  // total rows of all lines
+  uint numRows() const;
+
+  // display columns per row (lines are stale when changed)
+  uint width() const { return width_; }
+
+  void setWidth(uint width);
+
+  // mark all lines stale (e.g. tab stop changed)
+  void invalidateAll() { ++gen_; }
+
+  // rows for line with cols display columns at width (at least one)
+  static uint colsToRows(uint cols, uint width);
+
+  //---
+
+  // line inserted at line_num (stale) with cols display columns
+  void addLine(uint line_num, uint rows=1, uint cols=0);
+
+  // line at line_num removed
+  void deleteLine(uint line_num);
+
+  // rows of line (may be stale)
+  uint rows(uint line_num) const;
+
+  // set rows of line for current width
+  void setRows(uint line_num, uint rows);
+
+  // rows of line are for current width
+  bool isValid(uint line_num) const;
+
+  // mark line stale (e.g. line text changed)
+  void invalidate(uint line_num);
+
+  // display columns of line
+  uint cols(uint line_num) const;
+
+  void setCols(uint line_num, uint cols);
+
+  // display columns of widest line
+  uint maxCols() const;
+
+  //---
+
+  // first row of line
+  uint lineToRow(uint line_num) const;
+
+  // line at row and row within line (numLines if past end)
+  uint rowToLine(uint row, uint &sub_row) const;
+
+ private:
+  static const uint NIL = uint(-1);
+
+  struct Node {
+    uint left  { NIL };
+    uint right { NIL };
+    uint prio  { 0 };
+    uint size  { 1 };
+    uint rows  { 1 }; // rows of line
+    uint sum   { 1 }; // rows of subtree
+    uint gen   { 0 }; // width generation rows are for
+    uint cols  { 0 }; // display columns of line
+    uint max   { 0 }; // max cols of subtree
+  };
+
+  using Nodes = std::vector<Node>;
+  using Inds  = std::vector<uint>;
+
+ private:
+  uint size(uint t) const { return (t != NIL ? nodes_[t].size : 0); }
+  uint sum (uint t) const { return (t != NIL ? nodes_[t].sum  : 0); }
+  uint max (uint t) const { return (t != NIL ? nodes_[t].max  : 0); }
+
+  uint newNode();
+
+  void pull(uint t);
+
+  void split(uint t, uint pos, uint &l, uint &r);
+  uint merge(uint l, uint r);
+
+  uint nodeAt(uint pos) const;
+
+  // nodes from root to line (line node last)
+  void pathTo(uint pos, Inds &path) const;
+
+  uint random();
+
+ private:
+  Nodes nodes_;
+  Inds  free_;
+  uint  root_  { NIL };
+  uint  width_ { 80 };
+  uint  gen_   { 1 };
+  uint  seed_  { 12345 };
+};
+
+#endif
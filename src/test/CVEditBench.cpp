@@ -0,0 +1,376 @@
+// Headless frame time benchmark for CVEditFile::draw.
+//
+// Usage: CVEditBench [-lines <n>] [-frames <n>] [-size <w>x<h>] [-number] [-wrap]
+//                    [-max_p99 <ms>] [-max_calls <ratio>] [-replay <session> [-draw]]
+//                    [<file>]
+//
+// Loads a file (generated C text if none) and draws frames into a counting
+// renderer (CVEditRecordRenderer) for full redraw, scrolling, typing and
+// selection scenarios, reporting p50/p99 frame time and draw calls per frame.
+// Fails (exit status 1) if any p99 frame time exceeds max_p99 (default 16ms)
+// or an incremental scenario averages more than max_calls times the draw calls
+// of a full redraw (default 0.25).
+//
+// With -replay the session file (see CEditFile::replayFile) is replayed instead
+// and per phase event latencies reported (including a frame draw per event with
+// -draw). Fails if any phase p99 latency exceeds max_p99.
+
+#include <CVEditMgr.h>
+#include <CVEditRecordRenderer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+const uint CHAR_WIDTH  = 8;
+const uint CHAR_HEIGHT = 12;
+
+// file whose drawn contents can always be moved (as CQEditFile's back buffer)
+class BenchFile : public CVEditFile {
+ public:
+  uint numScrolls() const { return numScrolls_; }
+
+  bool scrollWindow(int, const CIBBox2D &) override {
+    ++numScrolls_;
+
+    return true;
+  }
+
+  // draw frame after each replayed event
+  void setReplayDraw(uint width, uint height) {
+    drawWidth_  = width;
+    drawHeight_ = height;
+  }
+
+  // replay stats and command output to stdout with other results
+  void displayMessage(const StringList &lines) override {
+    for (const auto &line : lines)
+      printf("%s\n", line.c_str());
+  }
+
+  // replayed quit command only ends replay
+  void quit() override { }
+
+ protected:
+  void replayEvent() override {
+    if (drawWidth_ > 0)
+      draw(drawWidth_, drawHeight_);
+  }
+
+ private:
+  uint numScrolls_ { 0 };
+  uint drawWidth_  { 0 };
+  uint drawHeight_ { 0 };
+};
+
+struct FrameStats {
+  std::string name;
+  double      p50       { 0.0 };
+  double      p99       { 0.0 };
+  double      meanCalls { 0.0 };
+  uint        maxCalls  { 0 };
+};
+
+// write generated C text (with tabs and some long lines) to temp file
+bool
+writeSampleFile(uint numLines, std::string &fileName)
+{
+  static const char *lines[] = {
+    "#include <stdio.h>",
+    "static int count_chars(const char *str, char c) {",
+    "\tint n = 0;",
+    "\tfor (int i = 0; str[i] != '\\0'; ++i) {",
+    "\t\tif (str[i] == c) ++n; /* count */",
+    "\t}",
+    "\treturn n; // done",
+    "}",
+    "",
+    "/* multi-line",
+    "   comment */ typedef struct { unsigned long id; double value; } Item;",
+    "  printf(\"%d items\\n\", count_chars(\"hello world\", 'o')); /* a long line "
+      "which runs well past the right edge of the window so it is clipped when "
+      "drawn or wrapped over several rows when wrap is enabled */",
+  };
+
+  uint n = sizeof(lines)/sizeof(char *);
+
+  char tmpName[] = "/tmp/CVEditBenchXXXXXX.c";
+
+  int fd = mkstemps(tmpName, 2);
+
+  if (fd < 0)
+    return false;
+
+  FILE *fp = fdopen(fd, "w");
+
+  if (! fp) {
+    close(fd);
+    return false;
+  }
+
+  for (uint i = 0; i < numLines; ++i)
+    fprintf(fp, "%s\n", lines[i % n]);
+
+  fclose(fp);
+
+  fileName = tmpName;
+
+  return true;
+}
+
+// run frames of scenario (step changes file before each frame is drawn)
+FrameStats
+runFrames(const std::string &name, BenchFile &file, CVEditRecordRenderer &renderer,
+          uint width, uint height, uint numFrames, const std::function<void (uint)> &step)
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::vector<double> times;
+  std::vector<uint>   calls;
+
+  times.reserve(numFrames);
+  calls.reserve(numFrames);
+
+  // start from up to date window
+  file.draw(width, height);
+
+  for (uint i = 0; i < numFrames; ++i) {
+    step(i);
+
+    renderer.reset();
+
+    auto t1 = Clock::now();
+
+    file.draw(width, height);
+
+    auto t2 = Clock::now();
+
+    times.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+    calls.push_back(renderer.numCalls());
+  }
+
+  FrameStats stats;
+
+  stats.name = name;
+
+  std::sort(times.begin(), times.end());
+
+  // same nearest rank percentiles as replay phases
+  stats.p50 = CEditReplayPhase::percentile(times, 0.5 );
+  stats.p99 = CEditReplayPhase::percentile(times, 0.99);
+
+  double sum = 0.0;
+
+  for (auto n : calls) {
+    sum += n;
+
+    stats.maxCalls = std::max(stats.maxCalls, n);
+  }
+
+  stats.meanCalls = sum/double(calls.size());
+
+  return stats;
+}
+
+void
+printStats(const FrameStats &stats)
+{
+  printf("%-10s p50 %8.3f ms  p99 %8.3f ms  calls mean %8.1f max %6u\n",
+         stats.name.c_str(), stats.p50, stats.p99, stats.meanCalls, stats.maxCalls);
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+  uint   numLines  = 100000;
+  uint   numFrames = 500;
+  uint   width     = 800;
+  uint   height    = 600;
+  bool   number    = false;
+  bool   wrap      = false;
+  double maxP99    = 16.0;
+  double maxCalls  = 0.25;
+  bool   draw      = false;
+
+  std::string fileName;
+  std::string replayName;
+
+  for (int i = 1; i < argc; ++i) {
+    if      (strcmp(argv[i], "-lines") == 0 && i < argc - 1)
+      numLines = uint(atoi(argv[++i]));
+    else if (strcmp(argv[i], "-frames") == 0 && i < argc - 1)
+      numFrames = std::max(uint(atoi(argv[++i])), 1U);
+    else if (strcmp(argv[i], "-size") == 0 && i < argc - 1) {
+      if (sscanf(argv[++i], "%ux%u", &width, &height) != 2) {
+        std::cerr << "Invalid size '" << argv[i] << "'\n";
+        exit(1);
+      }
+    }
+    else if (strcmp(argv[i], "-number") == 0)
+      number = true;
+    else if (strcmp(argv[i], "-wrap") == 0)
+      wrap = true;
+    else if (strcmp(argv[i], "-max_p99") == 0 && i < argc - 1)
+      maxP99 = atof(argv[++i]);
+    else if (strcmp(argv[i], "-max_calls") == 0 && i < argc - 1)
+      maxCalls = atof(argv[++i]);
+    else if (strcmp(argv[i], "-replay") == 0 && i < argc - 1)
+      replayName = argv[++i];
+    else if (strcmp(argv[i], "-draw") == 0)
+      draw = true;
+    else if (argv[i][0] == '-') {
+      std::cerr << "Usage: CVEditBench [-lines <n>] [-frames <n>] [-size <w>x<h>] "
+                   "[-number] [-wrap] [-max_p99 <ms>] [-max_calls <ratio>] "
+                   "[-replay <session> [-draw]] [<file>]\n";
+      exit(1);
+    }
+    else
+      fileName = argv[i];
+  }
+
+  bool tempFile = false;
+
+  if (fileName == "") {
+    if (! writeSampleFile(numLines, fileName)) {
+      std::cerr << "Failed to write sample file\n";
+      exit(1);
+    }
+
+    tempFile = true;
+  }
+
+  //---
+
+  CEditMgrInst->setFactory(new CVEditFactory);
+
+  CVEditRecordRenderer renderer;
+
+  CVEditMgrInst->setRenderer(&renderer);
+
+  BenchFile file;
+
+  file.init();
+
+  file.setCharSize(CHAR_WIDTH, CHAR_HEIGHT);
+
+  if (! file.loadLines(fileName)) {
+    std::cerr << "Failed to read '" << fileName << "'\n";
+    exit(1);
+  }
+
+  if (tempFile)
+    unlink(fileName.c_str());
+
+  if (number) file.setOptionString("number", "");
+  if (wrap  ) file.setOptionString("wrap"  , "");
+
+  uint lines = file.getNumLines();
+  uint rows  = height/CHAR_HEIGHT;
+
+  //---
+
+  if (replayName != "") {
+    printf("%u lines, %ux%u (%u rows), replay %s%s%s%s\n", lines, width, height, rows,
+           replayName.c_str(), (draw ? ", draw" : ""), (number ? ", number" : ""),
+           (wrap ? ", wrap" : ""));
+
+    if (draw) {
+      file.draw(width, height);
+
+      file.setReplayDraw(width, height);
+    }
+
+    if (! file.replayFile(replayName))
+      exit(1);
+
+    bool failed = false;
+
+    for (const auto &phase : file.getReplayPhases()) {
+      double p99 = CEditReplayPhase::percentile(phase.sortedTimes(), 0.99);
+
+      if (! phase.times.empty() && p99 > maxP99) {
+        printf("FAIL: %s p99 %.3f ms > %.3f ms\n", phase.name.c_str(), p99, maxP99);
+        failed = true;
+      }
+    }
+
+    return (failed ? 1 : 0);
+  }
+
+  //---
+
+  printf("%u lines, %ux%u (%u rows), %u frames%s%s\n", lines, width, height, rows,
+         numFrames, (number ? ", number" : ""), (wrap ? ", wrap" : ""));
+
+  //---
+
+  std::vector<FrameStats> stats;
+
+  // everything redrawn each frame
+  stats.push_back(runFrames("full", file, renderer, width, height, numFrames, [&](uint) {
+    file.setIgnoreChanged(true);
+  }));
+
+  // scroll down a row per frame (contents moved, exposed row drawn)
+  file.cursorTo(0, 0);
+
+  stats.push_back(runFrames("scroll", file, renderer, width, height, numFrames, [&](uint) {
+    file.scrollYOffset(file.getYOffset() - int(CHAR_HEIGHT));
+  }));
+
+  // type a char per frame in middle of window
+  uint typeRow = std::min(uint(-file.getYOffset())/CHAR_HEIGHT + rows/2, lines - 1);
+
+  file.cursorTo(typeRow, 0);
+
+  stats.push_back(runFrames("type", file, renderer, width, height, numFrames, [&](uint) {
+    file.insertChar('x');
+  }));
+
+  // extend selection a line/char per frame
+  uint selRow = uint(-file.getYOffset())/CHAR_HEIGHT;
+
+  stats.push_back(runFrames("select", file, renderer, width, height, numFrames, [&](uint i) {
+    uint n = i % std::max(rows/2, 1U);
+
+    file.rangeSelect(int(selRow), 0, int(std::min(selRow + n, lines - 1)), int(n), true);
+  }));
+
+  file.clearSelection();
+
+  printf("%u window scrolls\n", file.numScrolls());
+
+  //---
+
+  bool failed = false;
+
+  double fullCalls = stats[0].meanCalls;
+
+  for (const auto &s : stats) {
+    printStats(s);
+
+    if (s.p99 > maxP99) {
+      printf("FAIL: %s p99 %.3f ms > %.3f ms\n", s.name.c_str(), s.p99, maxP99);
+      failed = true;
+    }
+
+    if (&s != &stats[0] && s.meanCalls > maxCalls*fullCalls) {
+      printf("FAIL: %s calls %.1f > %.2f of full redraw (%.1f)\n", s.name.c_str(),
+             s.meanCalls, maxCalls, fullCalls);
+      failed = true;
+    }
+  }
+
+  return (failed ? 1 : 0);
+}
@@ -0,0 +1,95 @@
+TEMPLATE = app
+
+QT -= core gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = CVEditBench
+
+DEPENDPATH += .
+
+QMAKE_CXXFLAGS += -std=c++17
+
+CONFIG += release
+
+# Input
+SOURCES += \
+CVEditBench.cpp \
+\
+../CVEditRecordRenderer.cpp \
+\
+../CVEditChar.cpp \
+../CVEditCursor.cpp \
+../CVEditFile.cpp \
+../CVEditGen.cpp \
+../CVEditLine.cpp \
+../CVEditMgr.cpp \
+../CVEditVi.cpp \
+../CVLineEdit.cpp \
+../CVEditSelection.cpp \
+\
+../CEditChar.cpp \
+../CEditCmd.cpp \
+../CEditCursor.cpp \
+../CEditEd.cpp \
+../CEditFile.cpp \
+../CEditFileUtil.cpp \
+../CEditLine.cpp \
+../CEditMgr.cpp \
+\
+../CTextFile.cpp \
+../CLineEdit.cpp \
+\
+../CEd.cpp \
+\
+../CSyntax.cpp \
+../CSyntaxCPP.cpp \
+../CSyntaxC.cpp \
+../CSyntaxTable.cpp \
+../CSyntaxWorker.cpp \
+../CSyntaxDef.cpp \
+../CSyntaxGeneric.cpp \
+../CSyntaxBrackets.cpp \
+../CFoldTree.cpp \
+../CTabMap.cpp \
+../CWrapIndex.cpp \
+
+DESTDIR     = ../../bin
+OBJECTS_DIR = ../../obj/bench
+
+INCLUDEPATH += \
+. \
+.. \
+../../include \
+../../../CCommand/include \
+../../../CUndo/include \
+../../../CFont/include \
+../../../CFile/include \
+../../../CConfig/include \
+../../../COS/include \
+../../../CStrUtil/include \
+../../../CUtil/include \
+../../../CMath/include \
+../../../CReadLine/include \
+../../../CRegExp/include \
+../../../CRGBName/include \
+
+unix:LIBS += \
+-L../../../CCommand/lib \
+-L../../../CImageLib/lib \
+-L../../../CConfig/lib \
+-L../../../CUndo/lib \
+-L../../../CFont/lib \
+-L../../../CReadLine/lib \
+-L../../../CFile/lib \
+-L../../../CFileUtil/lib \
+-L../../../CMath/lib \
+-L../../../CStrUtil/lib \
+-L../../../CUtil/lib \
+-L../../../COS/lib \
+-L../../../CRGBName/lib \
+-L../../../CRegExp/lib \
+-lCCommand -lCImageLib -lCConfig -lCUndo -lCFont -lCReadLine -lCFile \
+-lCFileUtil -lCMath -lCStrUtil -lCRGBName -lCUtil -lCOS -lCRegExp \
+-ljpeg -lpng -lcurses -ltre -lpthread
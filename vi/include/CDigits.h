@@ -0,0 +1,22 @@
+#ifndef CDIGITS_H
+#define CDIGITS_H
+
+#include <sys/types.h>
+
+// Decimal digit count (line number gutter width) shared by the editor core
+// and the Qt glyph drawing.
+namespace CDigits {
+
+// number of decimal digits in num
+inline int numDigits(uint num) {
+  int n = 1;
+
+  for ( ; num >= 10; num /= 10)
+    ++n;
+
+  return n;
+}
+
+}
+
+#endif
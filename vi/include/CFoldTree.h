@@ -0,0 +1,151 @@
+#ifndef CFOLD_TREE_H
+#define CFOLD_TREE_H
+
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+// Fold regions of a document and the resulting visible rows.
+//
+// A fold is a header line (always visible) and the following body lines
+// (hidden when the fold is closed). Lines are held in a treap keyed by line
+// position; fold end points are treap nodes so inserting or deleting lines
+// moves them with no per fold update. Each line holds the number of closed
+// folds hiding it, closing or opening a fold is a lazy range add over its
+// body, and subtrees keep the minimum hidden count and how many lines have
+// it, so row <-> line mapping is O(log n) however many lines are folded.
+// Fold headers and ends are also counted like brackets (header opens, end
+// closes) so the innermost fold containing a line is found in O(log n) for
+// nested folds.
+class CFoldTree {
+ public:
+  using Range  = std::pair<uint, uint>;
+  using Ranges = std::vector<Range>;
+
+ public:
+  CFoldTree();
+
+  // reset to num_lines lines with no folds
+  void reset(uint num_lines=0);
+
+  uint numLines() const { return size(root_); }
+
+  // number of visible lines (rows)
+  uint numRows() const;
+
+  // line inserted at line_num (hidden if inside closed fold body)
+  void addLine(uint line_num);
+
+  // line at line_num removed (fold with header at line is removed). Returns
+  // true if a closed fold was removed, with the body lines it hid (after
+  // removal) in line_num1 to line_num2
+  bool deleteLine(uint line_num, uint &line_num1, uint &line_num2);
+
+  //---
+
+  // add fold with header line_num1 and body to line_num2. Returns false if
+  // range invalid or a fold already starts at line_num1.
+  bool addFold(uint line_num1, uint line_num2, bool closed=false);
+
+  void removeAllFolds();
+
+  int numFolds() const { return int(folds_.size() - free_folds_.size()); }
+
+  // body line ranges of folds (closed folds only if closed) merged in order
+  void foldBodies(Ranges &ranges, bool closed=false) const;
+
+  // innermost fold with header at or body containing line (false if none)
+  bool foldAt(uint line_num, uint &line_num1, uint &line_num2, bool &closed) const;
+
+  // open/close innermost fold at line (false if none)
+  bool openFold (uint line_num);
+  bool closeFold(uint line_num);
+
+  void openAllFolds();
+  void closeAllFolds();
+
+  // fold with header at line is closed (lines is number of hidden body lines)
+  bool isClosedFold(uint line_num, uint &lines) const;
+
+  //---
+
+  bool isHidden(uint line_num) const;
+
+  // row of line (row of its closed fold header if hidden)
+  uint lineToRow(uint line_num) const;
+
+  // line of row (numLines if past end)
+  uint rowToLine(uint row) const;
+
+  // next visible line after line (numLines if none)
+  uint nextVisibleLine(uint line_num) const;
+
+ private:
+  static const uint NIL = uint(-1);
+
+  struct Node {
+    uint left      { NIL };
+    uint right     { NIL };
+    uint parent    { NIL };
+    uint prio      { 0 };
+    uint size      { 1 };
+    int  hidden    { 0 };   // closed folds hiding line
+    int  min_hidden{ 0 };   // min hidden count in subtree
+    uint min_count { 1 };   // lines in subtree with min hidden count
+    int  add       { 0 };   // pending hidden count add for children
+    uint fold      { NIL }; // fold with header at line
+    std::vector<uint> fold_ends; // folds whose body ends at line
+    int  fold_sum  { 0 };   // fold headers minus fold ends in subtree
+    int  fold_max  { 0 };   // max of fold_sum over subtree suffixes
+  };
+
+  struct Fold {
+    uint start  { NIL }; // header node
+    uint end    { NIL }; // last body line node
+    bool closed { false };
+  };
+
+  using Nodes = std::vector<Node>;
+  using Folds = std::vector<Fold>;
+  using Inds  = std::vector<uint>;
+
+ private:
+  uint size(uint t) const { return (t != NIL ? nodes_[t].size : 0); }
+
+  uint newNode();
+
+  void pull(uint t);
+  void pullPath(uint t);
+  void push(uint t);
+
+  void apply(uint t, int add);
+
+  void split(uint t, uint pos, uint &l, uint &r);
+  uint merge(uint l, uint r);
+
+  uint nodeAt(uint pos) const;
+  uint nodePos(uint t) const;
+
+  int  hiddenAt(uint pos) const;
+  uint visibleBefore(uint pos) const;
+
+  void addHidden(uint pos1, uint pos2, int add);
+
+  int  innerFold(uint line_num) const;
+  int  containingFold(uint line_num) const;
+  uint findFoldBackward(uint t, uint offset, uint pos, int &depth) const;
+  void setFoldClosed(uint fold, bool closed);
+  void removeFold(uint fold);
+
+  uint random();
+
+ private:
+  Nodes nodes_;
+  Inds  free_;
+  Folds folds_;
+  Inds  free_folds_;
+  uint  root_ { NIL };
+  uint  seed_ { 12345 };
+};
+
+#endif
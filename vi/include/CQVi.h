@@ -1,4 +1,6 @@
 #include <CVi.h>
+#include <CQGlyphAtlas.h>
+#include <CQFrameScheduler.h>
 
 #include <QLabel>
 #include <memory>
@@ -119,6 +121,8 @@ class Interface : public CVi::Interface {
   void positionChanged () override;
   void selectionChanged() override;
 
+  void syntaxPending() override;
+
  private:
   App* app_ { nullptr };
 };
@@ -141,20 +145,41 @@ class App : public QObject, public CVi::App {
   void scrollMiddle();
   void scrollBottom();
 
-  void scrollCursor();
+  void scrollCursor() const;
 
+  // changes are coalesced and applied once per event loop turn
   void stateChanged();
   void positionChanged();
   void selectionChanged();
 
   void update();
 
+  // apply pending changes now
+  void flushFrame() const;
+
+  const CQFrameScheduler &frameScheduler() const { return frameScheduler_; }
+
   QColor tokenColor(CSyntaxToken) const;
 
   void setNameValue(const std::string &name, const std::string &value) override;
 
  private:
-  Widget *widget_ { nullptr };
+  enum FrameFlags {
+    FRAME_UPDATE    = (1<<0),
+    FRAME_STATE     = (1<<1),
+    FRAME_POSITION  = (1<<2),
+    FRAME_SELECTION = (1<<3)
+  };
+
+  void updateFrame(uint flags);
+
+  // scroll to cursor before page query
+  void applyScroll() const;
+
+ private:
+  Widget* widget_ { nullptr };
+
+  mutable CQFrameScheduler frameScheduler_;
 };
 
 //---
@@ -247,7 +272,11 @@ class Widget : public QWidget {
 
   QSize canvasSizeHint() const;
 
-  void draw(QPainter *painter);
+  // draw rows in rect (update region)
+  void draw(QPainter *painter, const QRect &rect);
+
+  // update line number gutter width for line count
+  void updateGutter();
 
   int pageTop   () const;
   int pageBottom() const;
@@ -276,8 +305,6 @@ class Widget : public QWidget {
   void vscrollSlot(int);
 
  private:
-  using YLineMap = std::map<int, int>;
-
   using AppP = std::unique_ptr<App>;
 
   AppP app_;
@@ -313,9 +340,10 @@ class Widget : public QWidget {
 
   FontData fontData_;
 
+  CQGlyphAtlas glyphAtlas_;
+
   int      xOffset_       { 0 };
   int      yOffset_       { 0 };
-  YLineMap yLineMap_;
   uint     maxLineLength_ { 0 };
   int      y1_            { 0 };
   int      y2_            { 0 };
@@ -324,9 +352,8 @@ class Widget : public QWidget {
 
   QPoint press_pos_;
 
-  int         lineDigits_ { -1 };
-  int         lmargin_    { -1 };
-  std::string numberFormat_;
+  int lineDigits_ { -1 };
+  int lmargin_    { 0 };
 };
 
 }
@@ -0,0 +1,102 @@
+#ifndef CSYNTAX_BRACKETS_H
+#define CSYNTAX_BRACKETS_H
+
+#include <CSyntax.h>
+#include <string_view>
+#include <vector>
+
+// Index of (), [] and {} brackets of a document built from the lexer output
+// (brackets in STRING and COMMENT tokens are ignored).
+//
+// Lines are held in a treap keyed by line position. Each node stores its
+// line's brackets and, per bracket type, the depth change and minimum prefix
+// depth of its line and subtree (their difference is the maximum suffix
+// depth used when searching backwards). Line insert, delete and update and
+// matching bracket lookup are O(log n) (plus the brackets of the start and
+// end lines).
+class CSyntaxBrackets {
+ public:
+  struct Bracket {
+    uint col { 0 };
+    char c   { '\0' };
+  };
+
+  using Brackets = std::vector<Bracket>;
+
+ public:
+  CSyntaxBrackets();
+
+  // reset to num_lines empty lines
+  void reset(uint num_lines=0);
+
+  uint numLines() const { return size(root_); }
+
+  // line inserted or removed at line_num (inserted line has no brackets)
+  void addLine(uint line_num);
+  void deleteLine(uint line_num);
+
+  // set line's brackets from its text and token spans
+  void setLine(uint line_num, const std::string_view &str, const CSyntaxSpans &spans);
+
+  const Brackets &lineBrackets(uint line_num) const;
+
+  // find bracket matching bracket at line_num, col. Returns false if no
+  // indexed bracket at position or no match.
+  bool findMatch(uint line_num, uint col, uint &match_line, uint &match_col) const;
+
+ private:
+  static const uint NIL = uint(-1);
+
+  enum { NUM_TYPES = 3 };
+
+  // bracket depth change of line sequence (opens +1, closes -1)
+  struct Depth {
+    int sum        { 0 };
+    int min_prefix { 0 }; // min over prefixes (including empty)
+
+    int maxSuffix() const { return sum - min_prefix; }
+  };
+
+  struct Node {
+    uint     left  { NIL };
+    uint     right { NIL };
+    uint     prio  { 0 };
+    uint     size  { 1 };
+    Brackets brackets;
+    Depth    line [NUM_TYPES];
+    Depth    total[NUM_TYPES];
+  };
+
+  using Nodes = std::vector<Node>;
+  using Inds  = std::vector<uint>;
+
+ private:
+  static int bracketType(char c);
+  static int bracketDir (char c);
+
+  uint size(uint t) const { return (t != NIL ? nodes_[t].size : 0); }
+
+  uint newNode();
+
+  void pull(uint t);
+
+  void split(uint t, uint pos, uint &l, uint &r);
+  uint merge(uint l, uint r);
+
+  uint nodeAt(uint pos) const;
+
+  void update(uint t, uint pos);
+
+  int findForward (uint t, uint offset, uint pos, int type, int k, int &depth) const;
+  int findBackward(uint t, uint offset, uint pos, int type, int k, int &depth) const;
+
+  uint random();
+
+ private:
+  Nodes nodes_;
+  Inds  free_;
+  uint  root_ { NIL };
+  uint  seed_ { 12345 };
+};
+
+#endif
@@ -1,26 +1,17 @@
 #ifndef CSYNTAX_C_H
 #define CSYNTAX_C_H
 
-#include <CSyntax.h>
+#include <CSyntaxTable.h>
 
-class CFile;
-
-class CSyntaxC : public CSyntax {
+class CSyntaxC : public CSyntaxTable {
  public:
   CSyntaxC();
 
   virtual ~CSyntaxC();
 
-  const char *language() const override { return "C"; }
-
-  void processLine(const std::string &line) override;
+  CSyntax *dup() const override { return new CSyntaxC(*this); }
 
- private:
-  CSyntaxToken findWord(const std::string &str);
-
- private:
-  bool         continued_ { false };
-  CSyntaxToken last_token_;
+  const char *language() const override { return "C"; }
 };
 
 #endif
@@ -1,27 +1,17 @@
 #ifndef CSYNTAX_CPP_H
 #define CSYNTAX_CPP_H
 
-#include <CSyntax.h>
+#include <CSyntaxTable.h>
 
-class CFile;
-
-class CSyntaxCPP : public CSyntax {
+class CSyntaxCPP : public CSyntaxTable {
  public:
   CSyntaxCPP();
 
   virtual ~CSyntaxCPP();
 
-  const char *language() const override { return "C++"; }
-
-  void processLine(const std::string &line) override;
+  CSyntax *dup() const override { return new CSyntaxCPP(*this); }
 
- private:
-  CSyntaxToken findWord(const std::string &str);
-
- private:
-  bool         in_comment_ { false };
-  bool         continued_  { false };
-  CSyntaxToken last_token_;
+  const char *language() const override { return "C++"; }
 };
 
 #endif
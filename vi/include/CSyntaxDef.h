@@ -0,0 +1,73 @@
+#ifndef CSYNTAX_DEF_H
+#define CSYNTAX_DEF_H
+
+#include <CSyntaxTable.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Language definition read from a text file and compiled into a table
+// lexer definition.
+//
+// File format (one setting per line, '#' starts a comment line) :
+//
+//   name          C++
+//   keywords      auto break case ...   (may be repeated)
+//   case          sensitive|insensitive
+//   line_comment  //
+//   block_comment /* */
+//   quotes        "'
+//   prepro        #
+//
+// The compiled definition (keyword perfect hash table and delimiter strings)
+// is a single relocatable image which is cached in the user cache directory
+// ($XDG_CACHE_HOME/csyntax or ~/.cache/csyntax, named from the file's path)
+// and memory mapped on later loads, so the text is only parsed when it
+// changes.
+class CSyntaxDef {
+ public:
+  CSyntaxDef();
+
+ ~CSyntaxDef();
+
+  CSyntaxDef(const CSyntaxDef &) = delete;
+  CSyntaxDef &operator=(const CSyntaxDef &) = delete;
+
+  // load definition file (using and updating cache if enabled)
+  bool load(const std::string &fileName, bool useCache=true);
+
+  const CSyntaxTable::Def &def() const { return def_; }
+
+  // loaded from mapped cache file
+  bool isMapped() const { return map_ != nullptr; }
+
+  const std::string &errorMsg() const { return error_msg_; }
+
+  // name of cache file for definition file ("" if no cache directory)
+  static std::string cacheFileName(const std::string &fileName);
+
+ private:
+  bool compile(const std::string &fileName, int64_t mtime, int64_t size, std::string &image);
+
+  bool mapCache(const std::string &cacheName, int64_t mtime, int64_t size);
+
+  bool writeCache(const std::string &cacheName, const std::string &image) const;
+
+  bool setImage(const char *data, size_t len);
+
+  void reset();
+
+  bool error(const std::string &msg);
+
+ private:
+  using Keywords = std::vector<std::string_view>;
+
+  std::string       image_;               // compiled image (if not mapped)
+  void*             map_      { nullptr }; // mapped cache file
+  size_t            map_size_ { 0 };
+  Keywords          keywords_;            // keyword strings in image
+  CSyntaxTable::Def def_;
+  std::string       error_msg_;
+};
+
+#endif
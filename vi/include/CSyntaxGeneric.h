@@ -0,0 +1,28 @@
+#ifndef CSYNTAX_GENERIC_H
+#define CSYNTAX_GENERIC_H
+
+#include <CSyntaxDef.h>
+#include <memory>
+
+// Table lexer for a language described by a definition file (see CSyntaxDef)
+class CSyntaxGeneric : public CSyntaxTable {
+ public:
+  using DefP = std::shared_ptr<const CSyntaxDef>;
+
+ public:
+  // load lexer from definition file (null on failure with reason in msg)
+  static CSyntaxGeneric *load(const std::string &fileName, std::string &msg);
+
+  CSyntaxGeneric(const DefP &syntaxDef);
+
+  virtual ~CSyntaxGeneric();
+
+  CSyntax *dup() const override { return new CSyntaxGeneric(*this); }
+
+  const char *language() const override { return def().name; }
+
+ private:
+  DefP syntax_def_; // owns definition data referenced by table
+};
+
+#endif
@@ -1,26 +1,17 @@
 #ifndef CSYNTAX_PYTHON_H
 #define CSYNTAX_PYTHON_H
 
-#include <CSyntax.h>
+#include <CSyntaxTable.h>
 
-class CFile;
-
-class CSyntaxPython : public CSyntax {
+class CSyntaxPython : public CSyntaxTable {
  public:
   CSyntaxPython();
 
   virtual ~CSyntaxPython();
 
-  const char *language() const override { return "Python"; }
-
-  void processLine(const std::string &line) override;
+  CSyntax *dup() const override { return new CSyntaxPython(*this); }
 
- private:
-  CSyntaxToken findWord(const std::string &str);
-
- private:
-  bool         continued_ { false };
-  CSyntaxToken last_token_;
+  const char *language() const override { return "Python"; }
 };
 
 #endif
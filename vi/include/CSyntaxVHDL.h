@@ -1,13 +1,11 @@
 #ifndef CSYNTAX_VHDL_H
 #define CSYNTAX_VHDL_H
 
-#include <CSyntax.h>
+#include <CSyntaxTable.h>
 #include <map>
 #include <vector>
 
-class CFile;
-
-class CSyntaxVHDL : public CSyntax {
+class CSyntaxVHDL : public CSyntaxTable {
  public:
   enum class BlockType {
     NONE,
@@ -25,18 +23,20 @@ class CSyntaxVHDL : public CSyntax {
 
   virtual ~CSyntaxVHDL();
 
+  CSyntax *dup() const override { return new CSyntaxVHDL(*this); }
+
   const char *language() const override { return "VHDL"; }
 
   void init() override;
   void term() override;
 
-  void processLine(const std::string &line) override;
-
- private:
-  enum { MAX_TOKEN_LEN = 64 };
+  void processLine(const std::string_view &line) override;
 
-  using TokenHash = std::map<std::string, CSyntaxToken>;
+  // track blocks and print their start/end to stderr
+  bool isDebug() const { return debug_; }
+  void setDebug(bool debug) { debug_ = debug; }
 
+ private:
   struct BlockDef {
     BlockType   type;
     std::string name;
@@ -44,7 +44,7 @@ class CSyntaxVHDL : public CSyntax {
     std::string extraKeyword;
   };
 
-  using NameBlockType = std::map<std::string, BlockType>;
+  using NameBlockType = std::map<std::string, BlockType, std::less<>>;
   using BlockTypeName = std::map<BlockType, BlockDef>;
 
   struct BlockData {
@@ -56,20 +56,32 @@ class CSyntaxVHDL : public CSyntax {
 
   using BlockStack = std::vector<BlockData>;
 
+  // word of line (lowercase, keyword, only space since previous word)
+  struct Word {
+    std::string_view str;
+    std::string_view lower;
+    bool             keyword { false };
+    bool             follows { false };
+  };
+
+  using Words = std::vector<Word>;
+
  private:
-  CSyntaxToken findWord(const std::string &str);
+  void updateBlocks(const std::string_view &line);
 
   void printBlock(const BlockData &blockData) const;
   void printBlockName(const BlockData &blockData) const;
 
  private:
-  TokenHash     tokenHash_[MAX_TOKEN_LEN];
   NameBlockType nameBlockType_;
   BlockTypeName blockTypeName_;
   BlockStack    blockStack_;
   BlockData     blockData_;
   bool          inBlockName_ { false };
   std::string   extraKeyword_;
+  Words         words_;
+  std::string   lowerLine_;
+  bool          debug_ { false };
 };
 
 #endif
@@ -0,0 +1,108 @@
+#ifndef CSYNTAX_WORKER_H
+#define CSYNTAX_WORKER_H
+
+#include <CSyntax.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Lexes a snapshot of lines in document order on a background thread and
+// queues the per line results (token spans and end state) for the owner to
+// apply on its own thread.
+//
+// The snapshot is a bounded batch of lines (see snapshotLines) so restarting
+// after an edit only copies a batch, not the rest of the file. The owner
+// continues with the next batch when one finishes unconverged.
+//
+// An initial (nothing valid) pass over a snapshot is split into chunks (of at
+// least half the first snapshot size, so chunk count grows as snapshots
+// double) lexed in parallel, each from a guessed normal start state. Chunks are
+// published in order as they complete, after a sequential fix-up re-lexes
+// the chunk head (if its true incoming state differs) until the end state
+// converges with the guessed result.
+class CSyntaxWorker {
+ public:
+  using Span  = CSyntaxSpan;
+  using Spans = CSyntaxSpans;
+
+  // snapshot of line text and its stored end state
+  struct Line {
+    std::string str;
+    int         state { -1 };
+    bool        valid { false };
+  };
+
+  using Lines = std::vector<Line>;
+
+  struct Result {
+    uint  line_num { 0 };
+    uint  state    { 0 };
+    Spans spans;
+  };
+
+  using Results = std::vector<Result>;
+
+ public:
+  CSyntaxWorker();
+ ~CSyntaxWorker();
+
+  uint generation() const { return generation_; }
+
+  uint startLine() const { return line_num_; }
+
+  // threads for initial pass (0 is hardware concurrency)
+  uint numThreads() const { return num_threads_; }
+  void setNumThreads(uint n) { num_threads_ = n; }
+
+  // number of lines to snapshot for a start with generation : small after
+  // lines changed (cheap restart per edit), doubling for each continuation
+  // of the same generation
+  uint snapshotLines(uint generation);
+
+  // lex lines (first is line_num, num_lines is lines in file) from start
+  // state, stopping past stop_line once the new end state matches the stored
+  // one. Returns false if the syntax can not be copied for the worker thread.
+  bool start(const CSyntax &syntax, uint generation, uint line_num, uint state,
+             Lines &&lines, uint stop_line, uint num_lines);
+
+  // stop worker and discard results
+  void cancel();
+
+  // is running or has results not yet taken
+  bool isBusy() const { return busy_; }
+
+  // move queued results into results. Returns true when the worker has
+  // finished (end_line is then the first line not processed and carry is
+  // set if its incoming state may have changed)
+  bool takeResults(Results &results, uint &end_line, bool &carry);
+
+ private:
+  void run();
+
+  bool runChunks();
+
+ private:
+  using SyntaxP = std::unique_ptr<CSyntax>;
+
+  SyntaxP            syntax_;
+  uint               generation_ { 0 };
+  uint               line_num_   { 0 };
+  uint               state_      { 0 };
+  Lines              lines_;
+  uint               stop_line_  { 0 };
+  uint               num_lines_  { 0 };
+  uint               snapshot_lines_ { 0 };
+  uint               num_threads_ { 0 };
+  std::thread        thread_;
+  std::atomic<bool>  cancel_     { false };
+  bool               busy_       { false };
+  std::mutex         mutex_;
+  Results            results_;
+  bool               done_       { false };
+  uint               end_line_   { 0 };
+  bool               end_carry_  { false };
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef CTAB_MAP_H
+#define CTAB_MAP_H
+
+#include <sys/types.h>
+#include <string_view>
+#include <vector>
+
+// Mapping between char index and display column of a line with tabs expanded.
+//
+// Only tabs are stored (char index and display column after the tab) so a
+// line with no tabs needs no storage and each lookup is a binary search over
+// the line's tabs. Built on demand and reset when the line text changes.
+class CTabMap {
+ public:
+  CTabMap() { }
+
+  // build for line text (fixed: tab is always tab_stop columns, e.g. ^I)
+  void build(const std::string_view &str, uint tab_stop, bool fixed=false);
+
+  void reset();
+
+  // built for tab stop
+  bool isValid(uint tab_stop, bool fixed=false) const {
+    return (valid_ && tab_stop_ == tab_stop && fixed_ == fixed);
+  }
+
+  uint length() const { return len_; }
+
+  uint numTabs() const { return uint(tabs_.size()); }
+
+  // display columns of line
+  uint numCols() const { return charToCol(len_); }
+
+  // display column of char (char can be past end of line)
+  uint charToCol(uint char_num) const;
+
+  // display columns used by char
+  uint charCols(uint char_num) const;
+
+  // char at display column (past end of line if column is past last char)
+  uint colToChar(uint col) const;
+
+ private:
+  struct Tab {
+    uint pos { 0 }; // char index
+    uint col { 0 }; // display column after tab
+  };
+
+  using Tabs = std::vector<Tab>;
+
+ private:
+  // index of first tab at or after char
+  uint tabAt(uint char_num) const;
+
+ private:
+  Tabs tabs_;
+  uint len_      { 0 };
+  uint tab_stop_ { 8 };
+  bool fixed_    { false };
+  bool valid_    { false };
+};
+
+#endif
@@ -4,6 +4,9 @@
 #include <CUndo.h>
 #include <CRegExp.h>
 #include <CSyntax.h>
+#include <CFoldTree.h>
+#include <CTabMap.h>
+#include <CWrapIndex.h>
 
 #include <vector>
 #include <map>
@@ -12,6 +15,8 @@
 #include <optional>
 
 class CSyntax;
+class CSyntaxWorker;
+class CSyntaxBrackets;
 
 namespace CVi {
 
@@ -152,6 +157,25 @@ class InsertCharUndoCmd : public UndoCmd {
 
 //---
 
+class InsertCharsUndoCmd : public UndoCmd {
+ public:
+  InsertCharsUndoCmd(App *vi);
+
+  InsertCharsUndoCmd(App *vi, int line_num, int char_num, const std::string &chars);
+
+  const char *getName() const override { return "insert_chars"; }
+
+  bool exec(const std::vector<std::string> &argList) override;
+  bool exec() override;
+
+ private:
+  int         line_num_ { 0 };
+  int         char_num_ { 0 };
+  std::string chars_;
+};
+
+//---
+
 class ReplaceCharUndoCmd : public UndoCmd {
  public:
   ReplaceCharUndoCmd(App *vi);
@@ -226,6 +250,30 @@ class JoinLineUndoCmd : public UndoCmd {
 
 //---
 
+// swap num_lines lines at line_num with saved lines (bulk line delete, join
+// and shift are one entry of this whatever the number of lines)
+class ReplaceLinesUndoCmd : public UndoCmd {
+ public:
+  using Strings = std::vector<std::string>;
+
+ public:
+  ReplaceLinesUndoCmd(App *vi);
+
+  ReplaceLinesUndoCmd(App *vi, int line_num, int num_lines, const Strings &lines);
+
+  const char *getName() const override { return "replace_lines"; }
+
+  bool exec(const std::vector<std::string> &argList) override;
+  bool exec() override;
+
+ private:
+  int     line_num_  { 0 };
+  int     num_lines_ { 0 };
+  Strings lines_;
+};
+
+//---
+
 class MoveToUndoCmd : public UndoCmd {
  public:
   MoveToUndoCmd(App *vi);
@@ -356,12 +404,22 @@ class Line {
   bool getChanged() const { return changed_; }
   virtual void setChanged(bool value);
 
+  // char index <-> display column map for tab stop (built on demand)
+  const CTabMap &tabMap(uint tabStop, bool fixed=false) const;
+
   // annotations
   void clearAnnotations();
   void addAnnotation(uint start, uint end, const CSyntaxToken &token);
 
   bool getCharStyle(int i, Style &style) const;
 
+  // syntax lexer state at end of line (-1 if never lexed)
+  int getSyntaxState() const { return syntaxState_; }
+  void setSyntaxState(int state) { syntaxState_ = state; }
+
+  bool getSyntaxValid() const { return syntaxValid_; }
+  void setSyntaxValid(bool valid) { syntaxValid_ = valid; }
+
   // print
   virtual void print(std::ostream &os) const;
 
@@ -377,6 +435,11 @@ class Line {
   bool        changed_ { false };
 
   CharStyle charStyle_;
+
+  int  syntaxState_ { -1 };
+  bool syntaxValid_ { false };
+
+  mutable CTabMap tabMap_;
 };
 
 //---
@@ -424,6 +487,9 @@ class Lines {
 
   void deleteLine(uint line_num);
 
+  // replace n lines at line_num with lines (one splice)
+  void replaceLines(uint line_num, uint n, const LineList &lines);
+
   void deleteLineChars(uint line_num, uint char_num, uint n);
 
  private:
@@ -529,6 +595,9 @@ class Interface {
 
   virtual void updateSyntax() { }
 
+  // background highlight in progress (redraw later to apply results)
+  virtual void syntaxPending() { }
+
   virtual void quit() { exit(0); }
 
   //------
@@ -672,7 +741,7 @@ class App {
   void setOverwriteMode(bool value);
 
   bool getListMode() const { return listMode_; }
-  void setListMode(bool value) { listMode_ = value; }
+  void setListMode(bool value);
 
   bool getNumberMode() const { return numberMode_; }
   void setNumberMode(bool value) { numberMode_ = value; }
@@ -722,6 +791,9 @@ class App {
 
   void error(const std::string &msg) const;
 
+  // command failed (stops macro playback)
+  void bell() const;
+
   void getPos(uint *x, uint *y) const;
   void setPos(uint x, uint y);
 
@@ -735,9 +807,69 @@ class App {
   const Line *getLine(uint line_num) const { return lines_.getLine(line_num); }
   Line *getLine(uint line_num) { return lines_.getLine(line_num); }
 
+  uint getTabStop() const;
+
+  // tab expanded column map of line (list mode shows tab as ^I)
+  const CTabMap &lineTabMap(uint line_num) const;
+
   CSyntax *syntax() const { return syntax_; }
   void setSyntax(CSyntax *syntax);
 
+  // mark all lines for re-highlight
+  void invalidateSyntax();
+
+  // re-highlight changed lines
+  void updateSyntax();
+
+  // re-highlight changed lines in window now and remaining lines in background
+  void updateSyntax(int lineNum1, int lineNum2);
+
+  // find bracket matching bracket at position using syntax bracket index (false
+  // if no syntax, bracket is in string or comment or is unmatched)
+  bool findMatchingBracket(uint line_num, uint char_num, uint &line_num1, uint &char_num1);
+
+  // folds (rows are visible lines, a closed fold is one row)
+  const CFoldTree &foldTree() const { return foldTree_; }
+
+  uint getNumRows() const { return foldTree_.numRows(); }
+
+  uint lineToRow(uint line_num) const { return foldTree_.lineToRow(line_num); }
+  uint rowToLine(uint row) const { return foldTree_.rowToLine(row); }
+
+  // soft wrap (screen rows are the wrapped rows of visible lines, same as rows
+  // when wrap is off)
+  bool getWrapMode() const { return wrapMode_; }
+  void setWrapMode(bool value);
+
+  // display columns per screen row
+  uint getWrapWidth() const { return wrapIndex_.width(); }
+  void setWrapWidth(uint width);
+
+  // screen rows of line (updated if stale)
+  uint wrapRows(uint line_num) const;
+
+  uint getNumScreenRows() const;
+
+  uint lineToScreenRow(uint line_num) const;
+  uint screenRowToLine(uint row, uint &subRow) const;
+
+  // screen row of char and its display column in row
+  uint posToScreenRow(uint line_num, uint char_num, uint &col) const;
+
+  // create fold at line from bracket (foldmethod=syntax) or indent structure
+  bool createFold(uint line_num, bool closed);
+
+  // create folds for all lines
+  void createAllFolds();
+
+  bool openFold  (uint line_num);
+  bool closeFold (uint line_num);
+  bool toggleFold(uint line_num);
+
+  void openAllFolds();
+  void closeAllFolds();
+  void removeAllFolds();
+
   void undo();
   void redo();
 
@@ -746,6 +878,10 @@ class App {
   bool getSelectStart(int *row, int *col) const;
   bool getSelectEnd  (int *row, int *col) const;
 
+  // move cursor by screen rows (gj, gk)
+  bool cursorScreenUp  (uint n);
+  bool cursorScreenDown(uint n);
+
  protected:
   friend class Ed;
 
@@ -755,10 +891,12 @@ class App {
   friend class MoveLineUndoCmd;
   friend class ReplaceUndoCmd;
   friend class InsertCharUndoCmd;
+  friend class InsertCharsUndoCmd;
   friend class ReplaceCharUndoCmd;
   friend class DeleteCharsUndoCmd;
   friend class SplitLineUndoCmd;
   friend class JoinLineUndoCmd;
+  friend class ReplaceLinesUndoCmd;
   friend class MoveToUndoCmd;
 
   Ed *getEd() const { return ed_; }
@@ -798,6 +936,9 @@ class App {
   void deleteLine();
   void deleteLine(uint line_num);
 
+  // delete n lines (one undo entry)
+  void deleteLines(uint line_num, uint n);
+
   void deleteWord();
   void deleteWord(uint line_num, uint char_num);
 
@@ -810,6 +951,10 @@ class App {
   void deleteChars(uint n);
   void deleteChars(uint line_num, uint char_num, uint n);
 
+  // delete up to n chars at or before cursor (clamped to line)
+  void deleteCharsRight(uint n);
+  void deleteCharsLeft (uint n);
+
   void deleteTo(uint line_num, uint char_num);
   void deleteTo(uint line_num1, uint char_num1, uint line_num2, uint char_num2);
 
@@ -845,6 +990,12 @@ class App {
   void joinLine();
   void joinLine(uint line_num);
 
+  // join n lines after line_num onto it (one undo entry)
+  void joinLines(uint line_num, uint n);
+
+  // replace n lines at line_num with strs (one undo entry)
+  void replaceLines(uint line_num, uint n, const std::vector<std::string> &strs);
+
   void newLineAbove();
   void newLineBelow();
 
@@ -1013,6 +1164,29 @@ class App {
 
   //---
 
+  // macros (q{reg} records keys to register, @{reg} plays them back)
+  bool isRecording() const { return recordRegister_ != '\0'; }
+  char getRecordRegister() const { return recordRegister_; }
+
+  void startRecording(char c);
+  void stopRecording();
+
+  bool playRegister(char c, uint n=1);
+
+  // keys and seconds of last playback
+  uint   getPlayKeys() const { return playKeys_; }
+  double getPlaySecs() const { return playSecs_; }
+
+  // keys per second of last playback
+  double getPlayRate() const;
+
+  // batch (macro playback) : interface notifications are deferred until end
+  void startBatch();
+  void endBatch();
+  bool inBatch() const { return batchDepth_ > 0; }
+
+  //---
+
   bool isWordChar(char c) const;
 
   uint getLineEnd(uint line_num) const;
@@ -1033,10 +1207,41 @@ class App {
   void subReplaceChar(uint line_num, uint char_num, char c);
   void subSplitLine(uint line_num, uint char_num);
   void subJoinLine(uint line_num);
+  void subReplaceLines(uint line_num, uint n, const std::vector<std::string> &strs);
   bool subReplace(uint line_num, uint char_num1, uint char_num2, const std::string &replaceStr);
 
+  // notify line list changes (line_num is index after the change)
+  virtual void lineAdded  (uint line_num);
+  virtual void lineDeleted(uint line_num);
+  virtual void lineChanged(uint line_num);
+
+  // notify n lines added or deleted at line_num (once for the whole range)
+  virtual void linesAdded  (uint line_num, uint n);
+  virtual void linesDeleted(uint line_num, uint n);
+
+  // notify interface (deferred in batch)
+  void notifyStateChanged();
+  void notifyPositionChanged();
+  void notifySelectionChanged();
+
+  void invalidateSyntaxLine(uint line_num);
+
+  void startSyntaxWorker();
+  void applySyntaxResults();
+
   void fixPos();
 
+  // end of fold region starting at line (false if none)
+  bool getFoldRange(uint line_num, uint &line_num2) const;
+
+  // indent of line (false if blank)
+  bool lineIndent(uint line_num, int &indent) const;
+
+  void foldsChanged();
+
+  // set wrap rows of lines after their fold hidden state changed
+  void updateWrapLines(uint line_num1, uint line_num2);
+
   bool runEdCmd(const std::string &cmd, bool &quitted);
 
   Options &getOptions() { return options_; }
@@ -1072,6 +1277,15 @@ class App {
   using OptRegExp  = std::optional<CRegExp>;
   using NameValues = std::map<std::string, std::string>;
 
+  using KeyDataList = std::vector<KeyData>;
+  using Macros      = std::map<char, KeyDataList>;
+
+  enum BatchFlags {
+    BATCH_STATE     = (1<<0),
+    BATCH_POSITION  = (1<<1),
+    BATCH_SELECTION = (1<<2)
+  };
+
   Interface *iface_ { nullptr };
 
   // data
@@ -1092,6 +1306,7 @@ class App {
   bool       overwriteMode_ { false };
   bool       listMode_      { false };
   bool       numberMode_    { false };
+  bool       wrapMode_      { false };
   bool       cmdLineMode_   { false };
   bool       extraLineChar_ { false };
   VisualMode visual_        { VisualMode::NONE };
@@ -1129,7 +1344,40 @@ class App {
 
   NameValues nameValues_;
 
+  // macros
+  Macros      macros_;
+  KeyDataList recordKeys_;
+  char        recordRegister_ { '\0' };
+  char        playRegister_   { '\0' };
+  uint        playDepth_      { 0 };
+  uint        playKeys_       { 0 };
+  double      playSecs_       { 0.0 };
+
+  // batch
+  uint batchDepth_ { 0 };
+  uint batchFlags_ { 0 };
+
+  mutable uint numErrors_ { 0 };
+
   CSyntax *syntax_ { nullptr };
+
+  // range of lines needing re-highlight
+  int syntaxLine1_ { -1 };
+  int syntaxLine2_ { -1 };
+
+  // background highlight of lines outside draw window
+  std::unique_ptr<CSyntaxWorker> syntaxWorker_;
+  uint                           syntaxGen_ { 0 };
+
+  // brackets of highlighted lines (for % matching)
+  std::unique_ptr<CSyntaxBrackets> syntaxBrackets_;
+
+  // fold regions (kept in step with lines by lineAdded/lineDeleted)
+  CFoldTree foldTree_;
+
+  // screen rows of lines for soft wrap (hidden lines have no rows)
+  mutable CWrapIndex wrapIndex_;
+  mutable uint       wrapTabStop_ { 0 };
 };
 
 }
@@ -1262,12 +1262,8 @@ void
 Ed::
 doJoin(int line_num1, int line_num2)
 {
-  app_->startGroup();
-
-  for (int i = line_num1; i < line_num2; ++i)
-    app_->joinLine(line_num1 - 1);
-
-  app_->endGroup();
+  if (line_num2 > line_num1)
+    app_->joinLines(line_num1 - 1, line_num2 - line_num1);
 }
 
 void
@@ -1310,12 +1306,8 @@ void
 Ed::
 doDelete(int line_num1, int line_num2)
 {
-  app_->startGroup();
-
-  for (int i = line_num1; i <= line_num2; ++i)
-    deleteLine(line_num1 - 1);
-
-  app_->endGroup();
+  if (line_num2 >= line_num1)
+    app_->deleteLines(line_num1 - 1, line_num2 - line_num1 + 1);
 
   setPos(0, line_num1 - 1);
 }
@@ -0,0 +1,856 @@
+#include <CFoldTree.h>
+#include <algorithm>
+
+CFoldTree::
+CFoldTree()
+{
+}
+
+void
+CFoldTree::
+reset(uint num_lines)
+{
+  nodes_     .clear();
+  free_      .clear();
+  folds_     .clear();
+  free_folds_.clear();
+
+  root_ = NIL;
+
+  if (num_lines == 0)
+    return;
+
+  nodes_.reserve(num_lines);
+
+  // build treap of lines in O(n) (see CSyntaxBrackets::reset)
+  Inds stack;
+
+  for (uint i = 0; i < num_lines; ++i) {
+    uint t = newNode();
+
+    uint last = NIL;
+
+    while (! stack.empty() && nodes_[stack.back()].prio < nodes_[t].prio) {
+      last = stack.back();
+
+      stack.pop_back();
+    }
+
+    nodes_[t].left = last;
+
+    if (! stack.empty())
+      nodes_[stack.back()].right = t;
+
+    stack.push_back(t);
+  }
+
+  root_ = stack[0];
+
+  // update sizes and parents bottom up
+  Inds order;
+
+  order.reserve(num_lines);
+
+  stack.clear();
+
+  stack.push_back(root_);
+
+  while (! stack.empty()) {
+    uint t = stack.back();
+
+    stack.pop_back();
+
+    order.push_back(t);
+
+    if (nodes_[t].left  != NIL) stack.push_back(nodes_[t].left );
+    if (nodes_[t].right != NIL) stack.push_back(nodes_[t].right);
+  }
+
+  for (auto p = order.rbegin(); p != order.rend(); ++p)
+    pull(*p);
+
+  nodes_[root_].parent = NIL;
+}
+
+uint
+CFoldTree::
+numRows() const
+{
+  if (root_ == NIL)
+    return 0;
+
+  return (nodes_[root_].min_hidden == 0 ? nodes_[root_].min_count : 0);
+}
+
+void
+CFoldTree::
+addLine(uint line_num)
+{
+  line_num = std::min(line_num, numLines());
+
+  // new line is in the same fold bodies as the line it is inserted before
+  int hidden = (line_num < numLines() ? hiddenAt(line_num) : 0);
+
+  uint t = newNode();
+
+  nodes_[t].hidden     = hidden;
+  nodes_[t].min_hidden = hidden;
+
+  uint l, r;
+
+  split(root_, line_num, l, r);
+
+  root_ = merge(merge(l, t), r);
+
+  nodes_[root_].parent = NIL;
+}
+
+bool
+CFoldTree::
+deleteLine(uint line_num, uint &line_num1, uint &line_num2)
+{
+  if (line_num >= numLines())
+    return false;
+
+  uint t = nodeAt(line_num);
+
+  // fold loses its header (closed fold's body is shown)
+  bool shown = false;
+
+  if (nodes_[t].fold != NIL) {
+    const auto &fold = folds_[nodes_[t].fold];
+
+    if (fold.closed) {
+      line_num1 = line_num;
+      line_num2 = nodePos(fold.end) - 1;
+
+      shown = true;
+    }
+
+    removeFold(nodes_[t].fold);
+  }
+
+  // folds ending at line now end at previous line (removed if empty)
+  Inds fold_ends = nodes_[t].fold_ends;
+
+  for (auto f : fold_ends) {
+    auto &fold = folds_[f];
+
+    if (nodePos(fold.start) + 1 >= line_num) {
+      removeFold(f);
+      continue;
+    }
+
+    uint t1 = nodeAt(line_num - 1);
+
+    fold.end = t1;
+
+    nodes_[t1].fold_ends.push_back(f);
+
+    pullPath(t1);
+  }
+
+  nodes_[t].fold_ends.clear();
+
+  pullPath(t);
+
+  //---
+
+  uint l, m, r;
+
+  split(root_, line_num, l, r);
+  split(r, 1, m, r);
+
+  free_.push_back(m);
+
+  root_ = merge(l, r);
+
+  if (root_ != NIL)
+    nodes_[root_].parent = NIL;
+
+  return shown;
+}
+
+//---
+
+bool
+CFoldTree::
+addFold(uint line_num1, uint line_num2, bool closed)
+{
+  if (line_num1 >= line_num2 || line_num2 >= numLines())
+    return false;
+
+  uint start = nodeAt(line_num1);
+  uint end   = nodeAt(line_num2);
+
+  if (nodes_[start].fold != NIL)
+    return false;
+
+  uint f;
+
+  if (! free_folds_.empty()) {
+    f = free_folds_.back();
+
+    free_folds_.pop_back();
+  }
+  else {
+    f = uint(folds_.size());
+
+    folds_.emplace_back();
+  }
+
+  auto &fold = folds_[f];
+
+  fold.start  = start;
+  fold.end    = end;
+  fold.closed = false;
+
+  nodes_[start].fold = f;
+
+  nodes_[end].fold_ends.push_back(f);
+
+  pullPath(start);
+  pullPath(end);
+
+  if (closed)
+    setFoldClosed(f, true);
+
+  return true;
+}
+
+void
+CFoldTree::
+removeAllFolds()
+{
+  for (uint f = 0; f < folds_.size(); ++f)
+    if (folds_[f].start != NIL)
+      removeFold(f);
+}
+
+void
+CFoldTree::
+foldBodies(Ranges &ranges, bool closed) const
+{
+  ranges.clear();
+
+  for (const auto &fold : folds_) {
+    if (fold.start == NIL || (closed && ! fold.closed)) continue;
+
+    ranges.emplace_back(nodePos(fold.start) + 1, nodePos(fold.end));
+  }
+
+  std::sort(ranges.begin(), ranges.end());
+
+  // merge nested and adjacent bodies
+  uint n = 0;
+
+  for (uint i = 0; i < ranges.size(); ++i) {
+    if (n > 0 && ranges[i].first <= ranges[n - 1].second + 1)
+      ranges[n - 1].second = std::max(ranges[n - 1].second, ranges[i].second);
+    else
+      ranges[n++] = ranges[i];
+  }
+
+  ranges.resize(n);
+}
+
+bool
+CFoldTree::
+foldAt(uint line_num, uint &line_num1, uint &line_num2, bool &closed) const
+{
+  int f = innerFold(line_num);
+
+  if (f < 0)
+    return false;
+
+  const auto &fold = folds_[f];
+
+  line_num1 = nodePos(fold.start);
+  line_num2 = nodePos(fold.end);
+  closed    = fold.closed;
+
+  return true;
+}
+
+bool
+CFoldTree::
+openFold(uint line_num)
+{
+  // fold with header at line, otherwise innermost closed fold containing line
+  if (line_num >= numLines())
+    return false;
+
+  int f = int(nodes_[nodeAt(line_num)].fold);
+
+  if (f == int(NIL) || ! folds_[f].closed) {
+    f = containingFold(line_num);
+
+    while (f >= 0 && ! folds_[f].closed)
+      f = containingFold(nodePos(folds_[f].start));
+  }
+
+  if (f < 0)
+    return false;
+
+  setFoldClosed(uint(f), false);
+
+  return true;
+}
+
+bool
+CFoldTree::
+closeFold(uint line_num)
+{
+  // innermost open fold with header at or body containing line
+  if (line_num >= numLines())
+    return false;
+
+  int f = int(nodes_[nodeAt(line_num)].fold);
+
+  if (f == int(NIL) || folds_[f].closed) {
+    f = containingFold(line_num);
+
+    while (f >= 0 && folds_[f].closed)
+      f = containingFold(nodePos(folds_[f].start));
+  }
+
+  if (f < 0)
+    return false;
+
+  setFoldClosed(uint(f), true);
+
+  return true;
+}
+
+void
+CFoldTree::
+openAllFolds()
+{
+  for (uint f = 0; f < folds_.size(); ++f)
+    if (folds_[f].start != NIL)
+      setFoldClosed(f, false);
+}
+
+void
+CFoldTree::
+closeAllFolds()
+{
+  for (uint f = 0; f < folds_.size(); ++f)
+    if (folds_[f].start != NIL)
+      setFoldClosed(f, true);
+}
+
+bool
+CFoldTree::
+isClosedFold(uint line_num, uint &lines) const
+{
+  if (line_num >= numLines())
+    return false;
+
+  uint f = nodes_[nodeAt(line_num)].fold;
+
+  if (f == NIL || ! folds_[f].closed)
+    return false;
+
+  lines = nodePos(folds_[f].end) - line_num;
+
+  return true;
+}
+
+//---
+
+bool
+CFoldTree::
+isHidden(uint line_num) const
+{
+  if (line_num >= numLines())
+    return false;
+
+  return (hiddenAt(line_num) > 0);
+}
+
+uint
+CFoldTree::
+lineToRow(uint line_num) const
+{
+  line_num = std::min(line_num, numLines());
+
+  uint row = visibleBefore(line_num);
+
+  // hidden line is shown as the closed fold header before it
+  if (row > 0 && isHidden(line_num))
+    --row;
+
+  return row;
+}
+
+uint
+CFoldTree::
+rowToLine(uint row) const
+{
+  // find visible line number row in subtree (acc is pending add of ancestors)
+  uint t      = root_;
+  int  acc    = 0;
+  uint offset = 0;
+
+  while (t != NIL) {
+    const auto &node = nodes_[t];
+
+    int acc1 = acc + node.add;
+
+    uint visible = 0;
+
+    if (node.left != NIL) {
+      const auto &left = nodes_[node.left];
+
+      visible = (left.min_hidden + acc1 == 0 ? left.min_count : 0);
+    }
+
+    if      (row < visible)
+      t = node.left;
+    else {
+      row -= visible;
+
+      uint pos = offset + size(node.left);
+
+      if (node.hidden + acc == 0) {
+        if (row == 0)
+          return pos;
+
+        --row;
+      }
+
+      offset = pos + 1;
+
+      t = node.right;
+    }
+
+    acc = acc1;
+  }
+
+  return numLines();
+}
+
+uint
+CFoldTree::
+nextVisibleLine(uint line_num) const
+{
+  if (line_num >= numLines())
+    return numLines();
+
+  return rowToLine(lineToRow(line_num) + 1);
+}
+
+//---
+
+uint
+CFoldTree::
+newNode()
+{
+  uint t;
+
+  if (! free_.empty()) {
+    t = free_.back();
+
+    free_.pop_back();
+
+    nodes_[t] = Node();
+  }
+  else {
+    t = uint(nodes_.size());
+
+    nodes_.emplace_back();
+  }
+
+  nodes_[t].prio = random();
+
+  return t;
+}
+
+void
+CFoldTree::
+pull(uint t)
+{
+  auto &node = nodes_[t];
+
+  node.size       = 1;
+  node.min_hidden = node.hidden;
+  node.min_count  = 1;
+
+  // line's fold ends close before its header opens
+  int open = (node.fold != NIL ? 1 : 0);
+
+  node.fold_sum = open - int(node.fold_ends.size());
+  node.fold_max = open;
+
+  if (node.left != NIL)
+    node.fold_max = std::max(node.fold_max, node.fold_sum + nodes_[node.left].fold_max);
+
+  if (node.right != NIL) {
+    const auto &right = nodes_[node.right];
+
+    node.fold_max = std::max(right.fold_max, right.fold_sum + node.fold_max);
+  }
+
+  for (uint c : { node.left, node.right }) {
+    if (c == NIL) continue;
+
+    auto &child = nodes_[c];
+
+    child.parent = t;
+
+    node.size += child.size;
+
+    // child values do not include this node's pending add
+    int min_hidden = child.min_hidden + node.add;
+
+    if      (min_hidden < node.min_hidden) {
+      node.min_hidden = min_hidden;
+      node.min_count  = child.min_count;
+    }
+    else if (min_hidden == node.min_hidden)
+      node.min_count += child.min_count;
+
+    node.fold_sum += child.fold_sum;
+  }
+}
+
+void
+CFoldTree::
+pullPath(uint t)
+{
+  // update node and ancestors after line's folds change
+  for ( ; t != NIL; t = nodes_[t].parent)
+    pull(t);
+}
+
+void
+CFoldTree::
+push(uint t)
+{
+  auto &node = nodes_[t];
+
+  if (node.add == 0)
+    return;
+
+  if (node.left  != NIL) apply(node.left , node.add);
+  if (node.right != NIL) apply(node.right, node.add);
+
+  node.add = 0;
+}
+
+void
+CFoldTree::
+apply(uint t, int add)
+{
+  auto &node = nodes_[t];
+
+  node.hidden     += add;
+  node.min_hidden += add;
+  node.add        += add;
+}
+
+void
+CFoldTree::
+split(uint t, uint pos, uint &l, uint &r)
+{
+  // first pos lines to l, rest to r
+  if (t == NIL) {
+    l = r = NIL;
+    return;
+  }
+
+  push(t);
+
+  uint lsize = size(nodes_[t].left);
+
+  if (pos <= lsize) {
+    uint l1;
+
+    split(nodes_[t].left, pos, l, l1);
+
+    nodes_[t].left = l1;
+
+    r = t;
+  }
+  else {
+    uint r1;
+
+    split(nodes_[t].right, pos - lsize - 1, r1, r);
+
+    nodes_[t].right = r1;
+
+    l = t;
+  }
+
+  pull(t);
+
+  if (l != NIL) nodes_[l].parent = NIL;
+  if (r != NIL) nodes_[r].parent = NIL;
+}
+
+uint
+CFoldTree::
+merge(uint l, uint r)
+{
+  if (l == NIL) return r;
+  if (r == NIL) return l;
+
+  if (nodes_[l].prio > nodes_[r].prio) {
+    push(l);
+
+    uint r1 = merge(nodes_[l].right, r);
+
+    nodes_[l].right = r1;
+
+    pull(l);
+
+    return l;
+  }
+  else {
+    push(r);
+
+    uint l1 = merge(l, nodes_[r].left);
+
+    nodes_[r].left = l1;
+
+    pull(r);
+
+    return r;
+  }
+}
+
+uint
+CFoldTree::
+nodeAt(uint pos) const
+{
+  uint t = root_;
+
+  while (t != NIL) {
+    uint lsize = size(nodes_[t].left);
+
+    if      (pos < lsize)
+      t = nodes_[t].left;
+    else if (pos > lsize) {
+      pos -= lsize + 1;
+
+      t = nodes_[t].right;
+    }
+    else
+      break;
+  }
+
+  return t;
+}
+
+uint
+CFoldTree::
+nodePos(uint t) const
+{
+  uint pos = size(nodes_[t].left);
+
+  for (uint p = nodes_[t].parent; p != NIL; t = p, p = nodes_[p].parent) {
+    if (nodes_[p].right == t)
+      pos += size(nodes_[p].left) + 1;
+  }
+
+  return pos;
+}
+
+int
+CFoldTree::
+hiddenAt(uint pos) const
+{
+  uint t   = root_;
+  int  acc = 0;
+
+  while (t != NIL) {
+    const auto &node = nodes_[t];
+
+    uint lsize = size(node.left);
+
+    if      (pos < lsize)
+      t = node.left;
+    else if (pos > lsize) {
+      pos -= lsize + 1;
+
+      t = node.right;
+    }
+    else
+      return node.hidden + acc;
+
+    acc += node.add;
+  }
+
+  return 0;
+}
+
+uint
+CFoldTree::
+visibleBefore(uint pos) const
+{
+  // visible lines in [0, pos)
+  uint t       = root_;
+  int  acc     = 0;
+  uint visible = 0;
+
+  while (t != NIL) {
+    const auto &node = nodes_[t];
+
+    int acc1 = acc + node.add;
+
+    uint lsize = size(node.left);
+
+    if (pos <= lsize)
+      t = node.left;
+    else {
+      if (node.left != NIL) {
+        const auto &left = nodes_[node.left];
+
+        if (left.min_hidden + acc1 == 0)
+          visible += left.min_count;
+      }
+
+      if (node.hidden + acc == 0)
+        ++visible;
+
+      pos -= lsize + 1;
+
+      t = node.right;
+    }
+
+    acc = acc1;
+  }
+
+  return visible;
+}
+
+void
+CFoldTree::
+addHidden(uint pos1, uint pos2, int add)
+{
+  // add to hidden count of lines pos1 to pos2
+  if (pos1 > pos2)
+    return;
+
+  uint l, m, r;
+
+  split(root_, pos1, l, r);
+  split(r, pos2 - pos1 + 1, m, r);
+
+  if (m != NIL)
+    apply(m, add);
+
+  root_ = merge(merge(l, m), r);
+
+  nodes_[root_].parent = NIL;
+}
+
+int
+CFoldTree::
+innerFold(uint line_num) const
+{
+  if (line_num >= numLines())
+    return -1;
+
+  uint f = nodes_[nodeAt(line_num)].fold;
+
+  if (f != NIL)
+    return int(f);
+
+  return containingFold(line_num);
+}
+
+int
+CFoldTree::
+containingFold(uint line_num) const
+{
+  // innermost fold with header before line and body containing line is the
+  // last header before line not closed by a fold end before line
+  int depth = 0;
+
+  uint t = findFoldBackward(root_, 0, line_num, depth);
+
+  return (t != NIL ? int(nodes_[t].fold) : -1);
+}
+
+uint
+CFoldTree::
+findFoldBackward(uint t, uint offset, uint pos, int &depth) const
+{
+  // last line before pos where depth (backwards from pos) reaches one
+  if (t == NIL || offset >= pos)
+    return NIL;
+
+  const auto &node = nodes_[t];
+
+  // skip subtree (all before pos) if depth never rises far enough in it
+  if (offset + node.size <= pos && depth + node.fold_max < 1) {
+    depth += node.fold_sum;
+    return NIL;
+  }
+
+  uint ind = offset + size(node.left);
+
+  uint t1 = findFoldBackward(node.right, ind + 1, pos, depth);
+
+  if (t1 != NIL)
+    return t1;
+
+  if (ind < pos) {
+    if (node.fold != NIL && depth == 0)
+      return t;
+
+    depth += (node.fold != NIL ? 1 : 0) - int(node.fold_ends.size());
+  }
+
+  return findFoldBackward(node.left, offset, pos, depth);
+}
+
+void
+CFoldTree::
+setFoldClosed(uint f, bool closed)
+{
+  auto &fold = folds_[f];
+
+  if (fold.closed == closed)
+    return;
+
+  fold.closed = closed;
+
+  addHidden(nodePos(fold.start) + 1, nodePos(fold.end), closed ? 1 : -1);
+}
+
+void
+CFoldTree::
+removeFold(uint f)
+{
+  setFoldClosed(f, false);
+
+  auto &fold = folds_[f];
+
+  nodes_[fold.start].fold = NIL;
+
+  auto &fold_ends = nodes_[fold.end].fold_ends;
+
+  fold_ends.erase(std::remove(fold_ends.begin(), fold_ends.end(), f), fold_ends.end());
+
+  pullPath(fold.start);
+  pullPath(fold.end);
+
+  fold = Fold();
+
+  free_folds_.push_back(f);
+}
+
+uint
+CFoldTree::
+random()
+{
+  // xorshift
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 17;
+  seed_ ^= seed_ << 5;
+
+  return seed_;
+}
@@ -0,0 +1,57 @@
+#include <CQFrameScheduler.h>
+
+#include <QTimer>
+
+CQFrameScheduler::
+CQFrameScheduler(QObject *context, const Flush &flush) :
+ context_(context), flush_(flush)
+{
+}
+
+void
+CQFrameScheduler::
+schedule(uint flags)
+{
+  ++numRequests_;
+
+  flags_ |= flags;
+
+  if (pending_) {
+    ++numSuppressed_;
+    return;
+  }
+
+  pending_ = true;
+
+  // timer is cancelled if context is destroyed first
+  QTimer::singleShot(0, context_, [this]() { flush(); });
+}
+
+void
+CQFrameScheduler::
+flush()
+{
+  // nothing to do if already flushed (e.g. explicit flush before timer fired)
+  if (! pending_)
+    return;
+
+  uint flags = flags_;
+
+  flags_   = 0;
+  pending_ = false;
+
+  ++numFlushes_;
+
+  // flush may schedule more work which is handled next turn
+  if (flush_)
+    flush_(flags);
+}
+
+void
+CQFrameScheduler::
+resetStats()
+{
+  numRequests_   = 0;
+  numFlushes_    = 0;
+  numSuppressed_ = 0;
+}
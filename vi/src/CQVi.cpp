@@ -2,6 +2,7 @@
 #include <CQUtil.h>
 #include <CKeyType.h>
 #include <CSyntaxC.h>
+#include <CDigits.h>
 
 #include <QLineEdit>
 #include <QScrollBar>
@@ -9,6 +10,7 @@
 #include <QHBoxLayout>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QTimer>
 #include <cmath>
 
 namespace CQVi {
@@ -132,6 +134,11 @@ updateMgr()
   fontData_.char_ascent = fm.ascent();
   fontData_.char_height = fm.ascent() + fm.descent();
 
+  glyphAtlas_.setFont(font);
+
+  // gutter width depends on char width
+  lineDigits_ = -1;
+
   update();
 }
 
@@ -144,9 +151,17 @@ hscrollSlot(int)
 
 void
 Widget::
-vscrollSlot(int)
+vscrollSlot(int y)
 {
-  update();
+  // move drawn rows and only draw newly exposed rows
+  int dy = yOffset_ - y;
+
+  yOffset_ = y;
+
+  if (dy != 0 && std::abs(dy) < canvas_->height())
+    canvas_->scroll(0, dy);
+  else
+    update();
 }
 
 //---
@@ -189,7 +204,7 @@ paintEvent(QPaintEvent *)
 
 void
 Widget::
-draw(QPainter *painter)
+draw(QPainter *painter, const QRect &rect)
 {
   auto bg   = Mgr::instance()->bg();
   auto fg   = Mgr::instance()->fg();
@@ -200,19 +215,36 @@ draw(QPainter *painter)
 
   painter->setFont(font);
 
-  painter->fillRect(rect(), QBrush(bg));
+  painter->fillRect(rect, QBrush(bg));
 
   painter->setPen(fg);
 
-  xOffset_ = hscroll_->value();
+  xOffset_ = (! app_->getWrapMode() ? hscroll_->value() : 0);
   yOffset_ = vscroll_->value();
 
+  // bring highlight up to date for visible lines (plus a page either side),
+  // remaining changed lines are processed in background
+  int pageRow1 = yOffset_/fontData_.char_height;
+  int pageRows = h/fontData_.char_height + 1;
+
+  uint subRow;
+
+  int pageLine1 = app_->screenRowToLine(pageRow1, subRow);
+  int pageLine2 = app_->screenRowToLine(pageRow1 + pageRows, subRow);
+
+  app_->updateSyntax(pageLine1 - pageRows, pageLine2 + pageRows);
+
   // get cursor pos
   uint cx, cy;
   app_->getPos(&cx, &cy);
 
   char cc = ' '; // cursor char
-  uint cp = 0;   // cursor pos
+
+  if (cy < app_->getNumLines()) {
+    auto *line = app_->getLine(cy);
+
+    cc = (cx < line->getLength() ? line->getChar(cx) : (app_->getListMode() ? '$' : ' '));
+  }
 
   uint iy = 0;
   int  y  = -yOffset_;
@@ -221,29 +253,10 @@ draw(QPainter *painter)
 
   //---
 
-  static char numberBuffer[256];
-
-  lineDigits_   = -1;
-  lmargin_      = 0;
-  numberFormat_ = "";
-
-  auto getLineNumberStr = [&](int i) {
-    if (lineDigits_ < 0) {
-      int n = app_->getNumLines();
-
-      lineDigits_ = (n > 0 ? int(std::log10(n)) + 1 : 1);
-
-      sprintf(numberBuffer, "%% %dd ", lineDigits_);
+  // wrapped lines fill window columns right of line numbers
+  updateGutter();
 
-      numberFormat_ = numberBuffer;
-
-      lmargin_ = (lineDigits_ + 1)*fontData_.char_width;
-    }
-
-    sprintf(numberBuffer, numberFormat_.c_str(), i);
-
-    return QString(numberBuffer);
-  };
+  app_->setWrapWidth(uint(std::max((w - lmargin_)/fontData_.char_width, 1)));
 
   auto visualMode = app_->getVisualMode();
 
@@ -286,63 +299,130 @@ draw(QPainter *painter)
     int x = -xOffset_;
 
     if (app_->getNumberMode()) {
-      auto numberStr = getLineNumberStr(iy);
-
-      painter->setPen(numberFg());
-      painter->drawText(x, y + fontData_.char_ascent, numberStr);
+      glyphAtlas_.drawNumber(painter, x, y, iy, lineDigits_, numberFg());
 
-      x += numberStr.size()*fontData_.char_width;
+      x += lmargin_;
     }
 
-    uint ix1 = 0; // char pos
-    uint ix2 = 0; // adjusted char pos (tabs)
+    const auto &tabMap = app_->lineTabMap(iy);
 
-    for (const auto &c : line->chars()) {
-      auto isSel = isSelected(iy, ix1);
+    // chars are drawn as runs with the same color and selection (one drawText
+    // per run), blanks and expanded tabs join any run
+    QString runStr;
+    QColor  runFg;
+    bool    runSel   = false;
+    bool    runBlank = true;
+    uint    runCols  = 0;
 
-      if (isSel)
-        painter->fillRect(QRect(x, y, fontData_.char_width, fontData_.char_height),
-                          QBrush(selBg()));
+    auto flushRun = [&]() {
+      if (runCols == 0)
+        return;
 
-      if (ix1 == cx && iy == cy) {
-        cc = c;
-        cp = ix2;
-      }
+      int w = runCols*fontData_.char_width;
 
-      uint n = 1;
+      if (runSel)
+        painter->fillRect(QRect(x, y, w, fontData_.char_height), QBrush(selBg()));
 
-      if (! isspace(c)) {
-        CVi::Line::Style style;
+      if (! runBlank)
+        glyphAtlas_.drawText(painter, x, y, runStr, runFg);
 
-        auto fgc = fg;
+      x += w;
 
-        if (line->getCharStyle(ix1, style))
-          fgc = app_->tokenColor(style.token);
+      runStr.clear();
 
-        painter->setPen(fgc);
-        painter->drawText(x, y + fontData_.char_ascent, QString(c));
-      }
-      else if (c == '\t') {
-        if (app_->getListMode()) {
-          painter->setPen(emptyFg());
-          painter->drawText(x, y + fontData_.char_ascent, "^I");
+      runBlank = true;
+      runCols  = 0;
+    };
+
+    bool listMode = app_->getListMode();
+
+    int xs = x; // line start
+
+    const auto &chars = line->chars();
+
+    uint len = uint(chars.size());
+
+    // draw chars starting in display columns col1 to col2 (exclusive) with
+    // column 0 at x0, chars past right edge of window are skipped
+    auto drawChars = [&](uint col1, uint col2, int x0) {
+      uint ix1 = std::min(tabMap.colToChar(col1), len); // char pos
+      uint col = tabMap.charToCol(ix1);
+
+      x = x0 + int(col)*fontData_.char_width;
+
+      for ( ; ix1 < len && col < col2; ++ix1) {
+        if (x + int(runCols)*fontData_.char_width > w)
+          break;
+
+        char c = chars[ix1];
 
-          n = 2;
+        auto isSel = isSelected(iy, ix1);
+
+        uint n = (c == '\t' ? tabMap.charCols(ix1) : 1);
+
+        bool  blank = (isspace(c) && ! (c == '\t' && listMode));
+        QColor fgc  = fg;
+
+        if      (c == '\t' && listMode)
+          fgc = emptyFg();
+        else if (! blank) {
+          CVi::Line::Style style;
+
+          if (line->getCharStyle(ix1, style))
+            fgc = app_->tokenColor(style.token);
+        }
+
+        if (runCols > 0 && (isSel != runSel || (! blank && ! runBlank && fgc != runFg)))
+          flushRun();
+
+        runSel = isSel;
+
+        if (! blank && runBlank) {
+          runFg    = fgc;
+          runBlank = false;
         }
+
+        if      (blank)
+          runStr += QString(int(n), QLatin1Char(' '));
+        else if (c == '\t')
+          runStr += "^I";
         else
-          n = 8 - (ix2 % 8);
+          runStr += QLatin1Char(c);
+
+        runCols += n;
+        col     += n;
       }
 
-      x += n*fontData_.char_width;
+      flushRun();
+    };
+
+    uint ix2 = tabMap.numCols(); // line display columns
+
+    int y1 = y;
 
-      ix2 += n;
+    if (! app_->getWrapMode()) {
+      // skip chars left of window so very long lines only draw visible columns
+      drawChars(xs < 0 ? uint(-xs/fontData_.char_width) : 0, uint(-1), xs);
 
-      ++ix1;
+      x = xs + int(ix2)*fontData_.char_width;
     }
+    else {
+      // each screen row of line draws the next wrap width columns
+      uint wrapWidth = app_->getWrapWidth();
+      uint wrapRows  = std::max(app_->wrapRows(iy), 1U);
+
+      for (uint r = 0; r < wrapRows; ++r, y += fontData_.char_height) {
+        if (y > rect.bottom() || y + fontData_.char_height <= rect.top())
+          continue;
+
+        uint col1 = r*wrapWidth;
+
+        drawChars(col1, col1 + wrapWidth, xs - int(col1)*fontData_.char_width);
+      }
 
-    if (ix1 == cx && iy == cy) {
-      cc = (app_->getListMode() ? '$' : ' ');
-      cp = ix2;
+      // end of line is on last row
+      y = y1 + int(wrapRows - 1)*fontData_.char_height;
+      x = xs + int(ix2 - (wrapRows - 1)*wrapWidth)*fontData_.char_width;
     }
 
     if (app_->getListMode()) {
@@ -352,36 +432,62 @@ draw(QPainter *painter)
       ++ix2;
     }
 
+    // closed fold header shows hidden line count
+    uint foldLines;
+
+    if (app_->foldTree().isClosedFold(iy, foldLines)) {
+      painter->setPen(emptyFg());
+      painter->drawText(x + fontData_.char_width, y + fontData_.char_ascent,
+                        QString("... %1 lines").arg(foldLines));
+    }
+
+    y = y1;
+
     maxLineLength_ = std::max(ix2, maxLineLength_);
   };
 
   //---
 
-  // draw lines
+  // draw visible lines (screen rows of line, skipping closed fold bodies)
+  // starting at first screen row in window
   y1_ = y;
 
-  for (auto *line : app_->lines()) {
+  uint numLines = app_->getNumLines();
+
+  int row1 = std::max(yOffset_, 0)/fontData_.char_height;
+
+  uint subRow1;
+
+  iy = app_->screenRowToLine(uint(row1), subRow1);
+  y  = (row1 - int(subRow1))*fontData_.char_height - yOffset_;
+
+  for ( ; iy < numLines; iy = app_->foldTree().nextVisibleLine(iy)) {
     if (y > h)
       break;
 
-    if (y + fontData_.char_height >= 0) {
-      yLineMap_[y + fontData_.char_height] = iy;
-
-      drawLine(line);
-    }
+    int lh = int(app_->wrapRows(iy))*fontData_.char_height;
 
-    y += fontData_.char_height;
+    // rows outside update region (e.g. rows moved by scroll) are not drawn
+    if (y < rect.bottom() + 1 && y + lh > rect.top())
+      drawLine(app_->getLine(iy));
+    else
+      maxLineLength_ = std::max(app_->lineTabMap(iy).numCols() + (app_->getListMode() ? 1 : 0),
+                                maxLineLength_);
 
-    ++iy;
+    y += lh;
   }
 
-  y2_ = y1_ + app_->getNumLines()*fontData_.char_height;
+  y2_ = y1_ + app_->getNumScreenRows()*fontData_.char_height;
 
   //---
 
   // draw cursor
+  uint cp; // cursor display column in its row
+
+  uint cr = app_->posToScreenRow(cy, cx, cp);
+
   int xc = lmargin_ + cp*fontData_.char_width  - xOffset_;
-  int yc = cy*fontData_.char_height - yOffset_;
+  int yc = cr*fontData_.char_height - yOffset_;
 
   painter->fillRect(QRect(xc, yc, fontData_.char_width, fontData_.char_height),
                     QBrush(cursorBg()));
@@ -446,18 +552,42 @@ resizeEvent(QResizeEvent *)
   updateScrollbars();
 }
 
+void
+Widget::
+updateGutter()
+{
+  // only recalc gutter when digit count of line count changes
+  int digits = (app_->getNumberMode() ? CDigits::numDigits(app_->getNumLines()) : 0);
+
+  if (digits == lineDigits_)
+    return;
+
+  bool changed = (lineDigits_ >= 0);
+
+  lineDigits_ = digits;
+  lmargin_    = (digits > 0 ? (digits + 1)*fontData_.char_width : 0);
+
+  // rows kept from previous draws (scrolled) have old gutter
+  if (changed)
+    canvas_->update();
+}
+
 int
 Widget::
 pageTop() const
 {
-  return yOffset_/fontData_.char_height;
+  uint subRow;
+
+  return app_->screenRowToLine(yOffset_/fontData_.char_height, subRow);
 }
 
 int
 Widget::
 pageBottom() const
 {
-  int pos = pageTop() + pageLength();
+  uint subRow;
+
+  int pos = app_->screenRowToLine(yOffset_/fontData_.char_height + pageLength(), subRow);
 
   int nl = app_->getNumLines();
 
@@ -502,8 +632,9 @@ updateScrollbars()
   int w = canvas_->width ();
   int h = canvas_->height();
 
-  int aw = maxLineLength_*fontData_.char_width;
-  int ah = app_->getNumLines()*fontData_.char_height;
+  // no horizontal scroll when lines are wrapped
+  int aw = (! app_->getWrapMode() ? int(maxLineLength_*fontData_.char_width) : w);
+  int ah = app_->getNumScreenRows()*fontData_.char_height;
 
   int hs = std::min(w, aw);
   int vs = std::min(h, ah);
@@ -666,56 +797,47 @@ Widget::
 mouseToPos(const QPoint &pos, int &ix, int &iy) const
 {
   ix = 0;
-  iy = -1;
+  iy = 0;
 
-  for (const auto &yLine : yLineMap_) {
-    if (pos.y() < yLine.first) {
-      iy = yLine.second;
-      break;
-    }
-  }
+  // rows are fixed height from top of document
+  int y = pos.y() + yOffset_;
 
-  if (iy < 0) {
-    iy = 0;
+  if (y < 0)
     return false;
-  }
 
-  bool found = false;
+  uint subRow;
 
-  auto *line = app_->getLine(iy);
+  uint line = app_->screenRowToLine(uint(y/fontData_.char_height), subRow);
 
-  int x1 = lmargin_ - xOffset_;
+  if (line >= app_->getNumLines())
+    return false;
 
-  for (const auto &c : line->chars()) {
-    uint n = 1;
+  iy = int(line);
 
-    if (c == '\t') {
-      if (app_->getListMode())
-        n = 2;
-      else
-        n = 8 - (ix % 8);
-    }
+  // display column under mouse to char
+  int x1 = lmargin_ - xOffset_;
 
-    int x2 = x1 + n*fontData_.char_width;
+  if (pos.x() < x1)
+    return false;
 
-    if (pos.x() >= x1 && pos.x() < x2) {
-      found = true;
-      break;
-    }
+  // wrapped row starts at multiple of wrap width
+  uint col = uint((pos.x() - x1)/fontData_.char_width) + subRow*app_->getWrapWidth();
 
-    ++ix;
+  ix = int(app_->lineTabMap(iy).colToChar(col));
 
-    x1 = x2;
+  if (ix >= int(app_->getLine(iy)->getLength())) {
+    ix = int(app_->getLine(iy)->getLength());
+    return false;
   }
 
-  return found;
+  return true;
 }
 
 //------
 
 App::
 App(Widget *widget) :
- CVi::App(), widget_(widget)
+ CVi::App(), widget_(widget), frameScheduler_(this, [this](uint flags) { updateFrame(flags); })
 {
   setObjectName("vi");
 
@@ -737,6 +859,9 @@ int
 App::
 getPageTop() const
 {
+  // apply pending cursor scroll
+  applyScroll();
+
   return widget_->pageTop();
 }
 
@@ -744,6 +869,9 @@ int
 App::
 getPageBottom() const
 {
+  // apply pending cursor scroll
+  applyScroll();
+
   return widget_->pageBottom();
 }
 
@@ -751,6 +879,9 @@ int
 App::
 getPageLength() const
 {
+  // apply pending cursor scroll
+  applyScroll();
+
   return widget_->pageLength();
 }
 
@@ -761,7 +892,11 @@ scrollTop()
   uint cx, cy;
   getPos(&cx, &cy);
 
-  widget_->scrollTo(cx, cy, /*force*/true);
+  uint col;
+
+  uint row = posToScreenRow(cy, cx, col);
+
+  widget_->scrollTo(col, row, /*force*/true);
 }
 
 void
@@ -771,7 +906,11 @@ scrollMiddle()
   uint cx, cy;
   getPos(&cx, &cy);
 
-  widget_->scrollTo(cx, cy - getPageLength()/2, /*force*/true);
+  uint col;
+
+  uint row = posToScreenRow(cy, cx, col);
+
+  widget_->scrollTo(col, row - getPageLength()/2, /*force*/true);
 }
 
 void
@@ -781,53 +920,91 @@ scrollBottom()
   uint cx, cy;
   getPos(&cx, &cy);
 
-  widget_->scrollTo(cx, cy - getPageLength(), /*force*/true);
+  uint col;
+
+  uint row = posToScreenRow(cy, cx, col);
+
+  widget_->scrollTo(col, row - getPageLength(), /*force*/true);
 }
 
 void
 App::
-scrollCursor()
+scrollCursor() const
 {
   uint cx, cy;
   getPos(&cx, &cy);
 
-  widget_->scrollTo(cx, cy);
+  uint col;
+
+  uint row = posToScreenRow(cy, cx, col);
+
+  widget_->scrollTo(col, row);
 }
 
 void
 App::
-stateChanged()
+applyScroll() const
 {
-  update();
+  // in batch (macro playback) only scroll, keep redraw and signals for end
+  if (inBatch())
+    scrollCursor();
+  else
+    flushFrame();
+}
 
-  Q_EMIT widget_->stateChanged();
+void
+App::
+stateChanged()
+{
+  frameScheduler_.schedule(FRAME_STATE);
 }
 
 void
 App::
 positionChanged()
 {
-  scrollCursor();
-
-  update();
-
-  Q_EMIT widget_->positionChanged();
+  frameScheduler_.schedule(FRAME_POSITION);
 }
 
 void
 App::
 selectionChanged()
 {
-  update();
-
-  Q_EMIT widget_->selectionChanged();
+  frameScheduler_.schedule(FRAME_SELECTION);
 }
 
 void
 App::
 update()
 {
+  frameScheduler_.schedule(FRAME_UPDATE);
+}
+
+void
+App::
+flushFrame() const
+{
+  frameScheduler_.flush();
+}
+
+void
+App::
+updateFrame(uint flags)
+{
+  // scroll once to final cursor position
+  if (flags & FRAME_POSITION)
+    scrollCursor();
+
   widget_->update();
+
+  if (flags & FRAME_STATE)
+    Q_EMIT widget_->stateChanged();
+
+  if (flags & FRAME_POSITION)
+    Q_EMIT widget_->positionChanged();
+
+  if (flags & FRAME_SELECTION)
+    Q_EMIT widget_->selectionChanged();
 }
 
 QColor
@@ -880,11 +1057,11 @@ Canvas(Widget *widget) :
 
 void
 Canvas::
-paintEvent(QPaintEvent *)
+paintEvent(QPaintEvent *e)
 {
   QPainter painter(this);
 
-  widget_->draw(&painter);
+  widget_->draw(&painter, e->rect());
 
   //widget_->updateStatus();
 }
@@ -1011,4 +1188,12 @@ selectionChanged()
   app_->selectionChanged();
 }
 
+void
+Interface::
+syntaxPending()
+{
+  // redraw shortly to pick up background highlight results
+  QTimer::singleShot(50, app_, [this]() { app_->update(); });
+}
+
 }
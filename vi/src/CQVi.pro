@@ -21,10 +21,20 @@ CVi.cpp \
 CEd.cpp \
 \
 CSyntaxC.cpp \
+CSyntaxTable.cpp \
 CSyntax.cpp \
 CSyntaxCPP.cpp \
 CSyntaxPython.cpp \
 CSyntaxVHDL.cpp \
+CSyntaxWorker.cpp \
+CSyntaxDef.cpp \
+CSyntaxGeneric.cpp \
+CSyntaxBrackets.cpp \
+CFoldTree.cpp \
+CTabMap.cpp \
+CWrapIndex.cpp \
+CQGlyphAtlas.cpp \
+CQFrameScheduler.cpp \
 
 HEADERS += \
 ../include/CQVi.h \
@@ -0,0 +1,506 @@
+#include <CSyntaxBrackets.h>
+#include <algorithm>
+
+CSyntaxBrackets::
+CSyntaxBrackets()
+{
+}
+
+void
+CSyntaxBrackets::
+reset(uint num_lines)
+{
+  nodes_.clear();
+  free_ .clear();
+
+  root_ = NIL;
+
+  if (num_lines == 0)
+    return;
+
+  nodes_.reserve(num_lines);
+
+  // build treap of lines in O(n) : right spine of tree is on the stack and
+  // each new (last) line becomes right child of the last node with a higher
+  // priority, taking the lower priority nodes as its left subtree
+  Inds stack;
+
+  for (uint i = 0; i < num_lines; ++i) {
+    uint t = newNode();
+
+    uint last = NIL;
+
+    while (! stack.empty() && nodes_[stack.back()].prio < nodes_[t].prio) {
+      last = stack.back();
+
+      stack.pop_back();
+    }
+
+    nodes_[t].left = last;
+
+    if (! stack.empty())
+      nodes_[stack.back()].right = t;
+
+    stack.push_back(t);
+  }
+
+  root_ = stack[0];
+
+  // update sizes and depths bottom up
+  Inds order;
+
+  order.reserve(num_lines);
+
+  stack.clear();
+
+  stack.push_back(root_);
+
+  while (! stack.empty()) {
+    uint t = stack.back();
+
+    stack.pop_back();
+
+    order.push_back(t);
+
+    if (nodes_[t].left  != NIL) stack.push_back(nodes_[t].left );
+    if (nodes_[t].right != NIL) stack.push_back(nodes_[t].right);
+  }
+
+  for (auto p = order.rbegin(); p != order.rend(); ++p)
+    pull(*p);
+}
+
+void
+CSyntaxBrackets::
+addLine(uint line_num)
+{
+  uint t = newNode();
+
+  uint l, r;
+
+  split(root_, line_num, l, r);
+
+  root_ = merge(merge(l, t), r);
+}
+
+void
+CSyntaxBrackets::
+deleteLine(uint line_num)
+{
+  if (line_num >= numLines())
+    return;
+
+  uint l, m, r;
+
+  split(root_, line_num, l, r);
+  split(r, 1, m, r);
+
+  Brackets().swap(nodes_[m].brackets);
+
+  free_.push_back(m);
+
+  root_ = merge(l, r);
+}
+
+void
+CSyntaxBrackets::
+setLine(uint line_num, const std::string_view &str, const CSyntaxSpans &spans)
+{
+  if (line_num >= numLines())
+    return;
+
+  auto &node = nodes_[nodeAt(line_num)];
+
+  node.brackets.clear();
+
+  for (int i = 0; i < NUM_TYPES; ++i)
+    node.line[i] = Depth();
+
+  // add brackets not in string or comment tokens (spans are in column order)
+  uint len = uint(str.size());
+
+  uint si = 0;
+
+  for (uint i = 0; i < len; ++i) {
+    char c = str[i];
+
+    int type = bracketType(c);
+
+    if (type < 0)
+      continue;
+
+    while (si < spans.size() && spans[si].start + spans[si].len <= i)
+      ++si;
+
+    if (si < spans.size() && spans[si].start <= i &&
+        (spans[si].token == CSyntaxToken::STRING || spans[si].token == CSyntaxToken::COMMENT))
+      continue;
+
+    node.brackets.push_back(Bracket { i, c });
+
+    auto &depth = node.line[type];
+
+    depth.sum       += bracketDir(c);
+    depth.min_prefix = std::min(depth.min_prefix, depth.sum);
+  }
+
+  update(root_, line_num);
+}
+
+const CSyntaxBrackets::Brackets &
+CSyntaxBrackets::
+lineBrackets(uint line_num) const
+{
+  static Brackets noBrackets;
+
+  if (line_num >= numLines())
+    return noBrackets;
+
+  return nodes_[nodeAt(line_num)].brackets;
+}
+
+bool
+CSyntaxBrackets::
+findMatch(uint line_num, uint col, uint &match_line, uint &match_col) const
+{
+  const auto &brackets = lineBrackets(line_num);
+
+  auto p = std::lower_bound(brackets.begin(), brackets.end(), col,
+    [](const Bracket &b, uint col) { return b.col < col; });
+
+  if (p == brackets.end() || (*p).col != col)
+    return false;
+
+  int type = bracketType((*p).c);
+
+  if (bracketDir((*p).c) > 0) {
+    // forward to depth zero in rest of line
+    int depth = 1;
+
+    for (auto p1 = p + 1; p1 != brackets.end(); ++p1) {
+      if (bracketType((*p1).c) != type) continue;
+
+      depth += bracketDir((*p1).c);
+
+      if (depth == 0) {
+        match_line = line_num;
+        match_col  = (*p1).col;
+        return true;
+      }
+    }
+
+    // find first later line closing remaining depth
+    int depth1 = 0;
+
+    int line_num1 = findForward(root_, 0, line_num + 1, type, depth, depth1);
+
+    if (line_num1 < 0)
+      return false;
+
+    for (const auto &bracket : nodes_[nodeAt(uint(line_num1))].brackets) {
+      if (bracketType(bracket.c) != type) continue;
+
+      depth1 += bracketDir(bracket.c);
+
+      if (depth1 == -depth) {
+        match_line = uint(line_num1);
+        match_col  = bracket.col;
+        return true;
+      }
+    }
+  }
+  else {
+    // backward to depth zero in start of line
+    int depth = 1;
+
+    for (auto p1 = p; p1 != brackets.begin(); ) {
+      --p1;
+
+      if (bracketType((*p1).c) != type) continue;
+
+      depth -= bracketDir((*p1).c);
+
+      if (depth == 0) {
+        match_line = line_num;
+        match_col  = (*p1).col;
+        return true;
+      }
+    }
+
+    // find last earlier line opening remaining depth
+    int depth1 = 0;
+
+    int line_num1 = findBackward(root_, 0, line_num, type, depth, depth1);
+
+    if (line_num1 < 0)
+      return false;
+
+    const auto &brackets1 = nodes_[nodeAt(uint(line_num1))].brackets;
+
+    for (auto p1 = brackets1.rbegin(); p1 != brackets1.rend(); ++p1) {
+      if (bracketType((*p1).c) != type) continue;
+
+      depth1 += bracketDir((*p1).c);
+
+      if (depth1 == depth) {
+        match_line = uint(line_num1);
+        match_col  = (*p1).col;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+int
+CSyntaxBrackets::
+bracketType(char c)
+{
+  switch (c) {
+    case '(': case ')': return 0;
+    case '[': case ']': return 1;
+    case '{': case '}': return 2;
+    default           : return -1;
+  }
+}
+
+int
+CSyntaxBrackets::
+bracketDir(char c)
+{
+  return (c == '(' || c == '[' || c == '{' ? 1 : -1);
+}
+
+uint
+CSyntaxBrackets::
+newNode()
+{
+  uint t;
+
+  if (! free_.empty()) {
+    t = free_.back();
+
+    free_.pop_back();
+
+    nodes_[t] = Node();
+  }
+  else {
+    t = uint(nodes_.size());
+
+    nodes_.emplace_back();
+  }
+
+  nodes_[t].prio = random();
+
+  return t;
+}
+
+void
+CSyntaxBrackets::
+pull(uint t)
+{
+  auto &node = nodes_[t];
+
+  node.size = 1 + size(node.left) + size(node.right);
+
+  auto combine = [](const Depth &d1, const Depth &d2) {
+    Depth d;
+
+    d.sum        = d1.sum + d2.sum;
+    d.min_prefix = std::min(d1.min_prefix, d1.sum + d2.min_prefix);
+
+    return d;
+  };
+
+  for (int i = 0; i < NUM_TYPES; ++i) {
+    Depth d = node.line[i];
+
+    if (node.left  != NIL) d = combine(nodes_[node.left].total[i], d);
+    if (node.right != NIL) d = combine(d, nodes_[node.right].total[i]);
+
+    node.total[i] = d;
+  }
+}
+
+void
+CSyntaxBrackets::
+split(uint t, uint pos, uint &l, uint &r)
+{
+  // first pos lines to l, rest to r
+  if (t == NIL) {
+    l = r = NIL;
+    return;
+  }
+
+  uint lsize = size(nodes_[t].left);
+
+  if (pos <= lsize) {
+    uint l1;
+
+    split(nodes_[t].left, pos, l, l1);
+
+    nodes_[t].left = l1;
+
+    r = t;
+  }
+  else {
+    uint r1;
+
+    split(nodes_[t].right, pos - lsize - 1, r1, r);
+
+    nodes_[t].right = r1;
+
+    l = t;
+  }
+
+  pull(t);
+}
+
+uint
+CSyntaxBrackets::
+merge(uint l, uint r)
+{
+  if (l == NIL) return r;
+  if (r == NIL) return l;
+
+  if (nodes_[l].prio > nodes_[r].prio) {
+    uint r1 = merge(nodes_[l].right, r);
+
+    nodes_[l].right = r1;
+
+    pull(l);
+
+    return l;
+  }
+  else {
+    uint l1 = merge(l, nodes_[r].left);
+
+    nodes_[r].left = l1;
+
+    pull(r);
+
+    return r;
+  }
+}
+
+uint
+CSyntaxBrackets::
+nodeAt(uint pos) const
+{
+  uint t = root_;
+
+  while (t != NIL) {
+    uint lsize = size(nodes_[t].left);
+
+    if      (pos < lsize)
+      t = nodes_[t].left;
+    else if (pos > lsize) {
+      pos -= lsize + 1;
+
+      t = nodes_[t].right;
+    }
+    else
+      break;
+  }
+
+  return t;
+}
+
+void
+CSyntaxBrackets::
+update(uint t, uint pos)
+{
+  // recalc subtree depths on path to changed line
+  uint lsize = size(nodes_[t].left);
+
+  if      (pos < lsize)
+    update(nodes_[t].left, pos);
+  else if (pos > lsize)
+    update(nodes_[t].right, pos - lsize - 1);
+
+  pull(t);
+}
+
+int
+CSyntaxBrackets::
+findForward(uint t, uint offset, uint pos, int type, int k, int &depth) const
+{
+  // first line at or after pos where depth (from pos) reaches -k. depth is
+  // returned as depth at start of found line
+  if (t == NIL)
+    return -1;
+
+  const auto &node = nodes_[t];
+
+  if (offset + node.size <= pos)
+    return -1;
+
+  // skip subtree (all after pos) if depth never drops far enough in it
+  if (offset >= pos && depth + node.total[type].min_prefix > -k) {
+    depth += node.total[type].sum;
+    return -1;
+  }
+
+  int line_num = findForward(node.left, offset, pos, type, k, depth);
+
+  if (line_num >= 0)
+    return line_num;
+
+  uint ind = offset + size(node.left);
+
+  if (ind >= pos) {
+    if (depth + node.line[type].min_prefix <= -k)
+      return int(ind);
+
+    depth += node.line[type].sum;
+  }
+
+  return findForward(node.right, ind + 1, pos, type, k, depth);
+}
+
+int
+CSyntaxBrackets::
+findBackward(uint t, uint offset, uint pos, int type, int k, int &depth) const
+{
+  // last line before pos where depth (backwards from pos) reaches k. depth is
+  // returned as depth at end of found line
+  if (t == NIL || offset >= pos)
+    return -1;
+
+  const auto &node = nodes_[t];
+
+  // skip subtree (all before pos) if depth never rises far enough in it
+  if (offset + node.size <= pos && depth + node.total[type].maxSuffix() < k) {
+    depth += node.total[type].sum;
+    return -1;
+  }
+
+  uint ind = offset + size(node.left);
+
+  int line_num = findBackward(node.right, ind + 1, pos, type, k, depth);
+
+  if (line_num >= 0)
+    return line_num;
+
+  if (ind < pos) {
+    if (depth + node.line[type].maxSuffix() >= k)
+      return int(ind);
+
+    depth += node.line[type].sum;
+  }
+
+  return findBackward(node.left, offset, pos, type, k, depth);
+}
+
+uint
+CSyntaxBrackets::
+random()
+{
+  // xorshift
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 17;
+  seed_ ^= seed_ << 5;
+
+  return seed_;
+}
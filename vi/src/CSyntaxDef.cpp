@@ -0,0 +1,540 @@
+#include <CSyntaxDef.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char     IMAGE_MAGIC[8] = { 'C', 'S', 'Y', 'N', 'D', 'E', 'F', '\0' };
+const uint32_t IMAGE_VERSION  = 1;
+
+const uint32_t FLAG_CASE_SENSITIVE = (1<<0);
+
+// compiled image header (offsets are from start of image, 0 if not set)
+struct ImageHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t size;                // image size
+  int64_t  src_mtime;           // definition file time (nsecs) and size
+  int64_t  src_size;
+  uint32_t flags;
+  uint32_t seed;                // keyword hash seed
+  uint32_t mask;                // slot table size - 1
+  uint32_t num_keywords;
+  uint32_t keywords;            // keyword (offset, length) pairs
+  uint32_t slots;               // slot table (keyword index + 1, 0 if empty)
+  uint32_t name;                // nul terminated strings
+  uint32_t line_comment;
+  uint32_t block_comment_start;
+  uint32_t block_comment_end;
+  uint32_t quotes;
+  uint32_t prepro;              // prefix char
+};
+
+int64_t
+fileTime(const struct stat &st)
+{
+  return int64_t(st.st_mtim.tv_sec)*1000000000 + int64_t(st.st_mtim.tv_nsec);
+}
+
+// create directory and its parents (if missing)
+bool
+makeDirs(const std::string &dir)
+{
+  for (auto pos = dir.find('/', 1); ; pos = dir.find('/', pos + 1)) {
+    auto dir1 = dir.substr(0, pos);
+
+    if (mkdir(dir1.c_str(), 0700) != 0 && errno != EEXIST)
+      return false;
+
+    if (pos == std::string::npos)
+      break;
+  }
+
+  return true;
+}
+
+uint32_t
+addImageData(std::string &image, const void *data, size_t len)
+{
+  // keep data 4 byte aligned
+  while (image.size() % 4)
+    image += '\0';
+
+  uint32_t offset = uint32_t(image.size());
+
+  image.append(static_cast<const char *>(data), len);
+
+  return offset;
+}
+
+uint32_t
+addImageString(std::string &image, const std::string &str)
+{
+  return addImageData(image, str.c_str(), str.size() + 1);
+}
+
+}
+
+//---
+
+CSyntaxDef::
+CSyntaxDef()
+{
+}
+
+CSyntaxDef::
+~CSyntaxDef()
+{
+  reset();
+}
+
+std::string
+CSyntaxDef::
+cacheFileName(const std::string &fileName)
+{
+  // <cache dir>/csyntax/<absolute file path with '/' replaced by '%'>c
+  std::string dir;
+
+  const char *cacheDir = getenv("XDG_CACHE_HOME");
+
+  // relative XDG_CACHE_HOME is ignored
+  if (cacheDir && cacheDir[0] == '/')
+    dir = cacheDir;
+  else {
+    const char *home = getenv("HOME");
+
+    if (! home || home[0] == '\0')
+      return "";
+
+    dir = std::string(home) + "/.cache";
+  }
+
+  char *path = realpath(fileName.c_str(), nullptr);
+
+  if (! path)
+    return "";
+
+  std::string name = path;
+
+  free(path);
+
+  std::replace(name.begin(), name.end(), '/', '%');
+
+  return dir + "/csyntax/" + name + "c";
+}
+
+bool
+CSyntaxDef::
+load(const std::string &fileName, bool useCache)
+{
+  reset();
+
+  struct stat st;
+
+  if (stat(fileName.c_str(), &st) != 0 || ! S_ISREG(st.st_mode))
+    return error("Failed to read '" + fileName + "'");
+
+  int64_t mtime = fileTime(st);
+  int64_t size  = int64_t(st.st_size);
+
+  std::string cacheName = (useCache ? cacheFileName(fileName) : "");
+
+  if (cacheName == "")
+    useCache = false;
+
+  if (useCache && mapCache(cacheName, mtime, size))
+    return true;
+
+  std::string image;
+
+  if (! compile(fileName, mtime, size, image))
+    return false;
+
+  // failure to write cache (e.g. no cache directory) is not an error
+  if (useCache)
+    (void) writeCache(cacheName, image);
+
+  image_ = std::move(image);
+
+  return setImage(image_.data(), image_.size());
+}
+
+bool
+CSyntaxDef::
+compile(const std::string &fileName, int64_t mtime, int64_t size, std::string &image)
+{
+  std::ifstream file(fileName);
+
+  if (! file)
+    return error("Failed to read '" + fileName + "'");
+
+  std::string              name;
+  std::vector<std::string> keywords;
+  bool                     case_sensitive = true;
+  std::string              line_comment, block_comment_start, block_comment_end;
+  std::string              quotes;
+  char                     prepro = '\0';
+
+  std::string line;
+  uint        line_num = 0;
+
+  auto lineError = [&](const std::string &msg) {
+    return error(fileName + ":" + std::to_string(line_num) + ": " + msg);
+  };
+
+  while (std::getline(file, line)) {
+    ++line_num;
+
+    std::istringstream words(line);
+
+    std::string key;
+
+    if (! (words >> key) || key[0] == '#')
+      continue;
+
+    std::vector<std::string> values;
+
+    std::string value;
+
+    while (words >> value)
+      values.push_back(value);
+
+    if      (key == "name") {
+      if (values.size() != 1) return lineError("expected name");
+
+      name = values[0];
+    }
+    else if (key == "keywords") {
+      for (auto &keyword : values)
+        keywords.push_back(keyword);
+    }
+    else if (key == "case") {
+      if      (values.size() == 1 && values[0] == "sensitive"  ) case_sensitive = true;
+      else if (values.size() == 1 && values[0] == "insensitive") case_sensitive = false;
+      else return lineError("expected sensitive or insensitive");
+    }
+    else if (key == "line_comment") {
+      if (values.size() != 1) return lineError("expected comment start");
+
+      line_comment = values[0];
+    }
+    else if (key == "block_comment") {
+      if (values.size() != 2) return lineError("expected comment start and end");
+
+      block_comment_start = values[0];
+      block_comment_end   = values[1];
+    }
+    else if (key == "quotes") {
+      if (values.size() != 1) return lineError("expected quote chars");
+
+      quotes = values[0];
+    }
+    else if (key == "prepro") {
+      if (values.size() != 1 || values[0].size() != 1) return lineError("expected prefix char");
+
+      prepro = values[0][0];
+    }
+    else
+      return lineError("unknown setting '" + key + "'");
+  }
+
+  //---
+
+  // case insensitive keywords are matched in lower case
+  if (! case_sensitive) {
+    for (auto &keyword : keywords)
+      for (auto &c : keyword)
+        c = CSyntaxKeywordUtil::lower(c);
+  }
+
+  // remove duplicates (keeping first)
+  std::vector<std::string> keywords1;
+
+  for (const auto &keyword : keywords)
+    if (std::find(keywords1.begin(), keywords1.end(), keyword) == keywords1.end())
+      keywords1.push_back(keyword);
+
+  keywords.swap(keywords1);
+
+  uint num_keywords = uint(keywords.size());
+
+  if (num_keywords >= 255)
+    return error(fileName + ": too many keywords");
+
+  //---
+
+  // find seed which maps every keyword to its own slot (as CSyntaxKeywordHash)
+  uint table_size = uint(CSyntaxKeywordUtil::tableSize(num_keywords));
+
+  std::vector<unsigned char> slots;
+
+  uint seed = 1;
+
+  for ( ; ; ++seed) {
+    slots.assign(table_size, 0);
+
+    uint i = 0;
+
+    for ( ; i < num_keywords; ++i) {
+      const auto &keyword = keywords[i];
+
+      uint h = CSyntaxKeywordUtil::hash(keyword.c_str(), uint(keyword.size()),
+                                        seed, case_sensitive) & (table_size - 1);
+
+      if (slots[h])
+        break;
+
+      slots[h] = (unsigned char) (i + 1);
+    }
+
+    if (i >= num_keywords)
+      break;
+
+    if (seed > 100000)
+      return error(fileName + ": no perfect hash for keywords");
+  }
+
+  //---
+
+  ImageHeader header;
+
+  memset(&header, 0, sizeof(header));
+
+  memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+
+  header.version      = IMAGE_VERSION;
+  header.src_mtime    = mtime;
+  header.src_size     = size;
+  header.flags        = (case_sensitive ? FLAG_CASE_SENSITIVE : 0);
+  header.seed         = seed;
+  header.mask         = table_size - 1;
+  header.num_keywords = num_keywords;
+
+  image.assign(sizeof(header), '\0');
+
+  std::vector<uint32_t> keywordData;
+
+  for (const auto &keyword : keywords) {
+    keywordData.push_back(addImageString(image, keyword));
+    keywordData.push_back(uint32_t(keyword.size()));
+  }
+
+  header.keywords = addImageData(image, keywordData.data(), keywordData.size()*sizeof(uint32_t));
+  header.slots    = addImageData(image, slots.data(), slots.size());
+
+  header.name = addImageString(image, name);
+
+  if (line_comment != "")
+    header.line_comment = addImageString(image, line_comment);
+
+  if (block_comment_start != "") {
+    header.block_comment_start = addImageString(image, block_comment_start);
+    header.block_comment_end   = addImageString(image, block_comment_end);
+  }
+
+  header.quotes = addImageString(image, quotes);
+  header.prepro = uint32_t((unsigned char) prepro);
+
+  header.size = uint32_t(image.size());
+
+  memcpy(&image[0], &header, sizeof(header));
+
+  return true;
+}
+
+bool
+CSyntaxDef::
+mapCache(const std::string &cacheName, int64_t mtime, int64_t size)
+{
+  int fd = open(cacheName.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(ImageHeader)) {
+    close(fd);
+    return false;
+  }
+
+  void *map = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+  close(fd);
+
+  if (map == MAP_FAILED)
+    return false;
+
+  map_      = map;
+  map_size_ = size_t(st.st_size);
+
+  // cache must be for current definition file
+  ImageHeader header;
+
+  memcpy(&header, map_, sizeof(header));
+
+  if (header.src_mtime != mtime || header.src_size != size ||
+      ! setImage(static_cast<const char *>(map_), map_size_)) {
+    reset();
+    return false;
+  }
+
+  return true;
+}
+
+bool
+CSyntaxDef::
+writeCache(const std::string &cacheName, const std::string &image) const
+{
+  if (! makeDirs(cacheName.substr(0, cacheName.rfind('/'))))
+    return false;
+
+  // write to temporary and rename so readers never see partial file
+  std::string tmpName = cacheName + ".tmp";
+
+  {
+  std::ofstream file(tmpName, std::ios::binary | std::ios::trunc);
+
+  if (! file)
+    return false;
+
+  file.write(image.data(), std::streamsize(image.size()));
+
+  if (! file) {
+    file.close();
+
+    (void) remove(tmpName.c_str());
+
+    return false;
+  }
+  }
+
+  return (rename(tmpName.c_str(), cacheName.c_str()) == 0);
+}
+
+bool
+CSyntaxDef::
+setImage(const char *data, size_t len)
+{
+  if (len < sizeof(ImageHeader))
+    return error("Invalid syntax image");
+
+  ImageHeader header;
+
+  memcpy(&header, data, sizeof(header));
+
+  if (memcmp(header.magic, IMAGE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != IMAGE_VERSION || header.size != len)
+    return error("Invalid syntax image");
+
+  auto validData = [&](uint32_t offset, size_t n) {
+    return (offset >= sizeof(header) && offset <= len && n <= len - offset);
+  };
+
+  // string at offset (null if not set)
+  bool valid = true;
+
+  auto imageString = [&](uint32_t offset) -> const char * {
+    if (offset == 0)
+      return nullptr;
+
+    if (! validData(offset, 1) || ! memchr(data + offset, '\0', len - offset)) {
+      valid = false;
+      return nullptr;
+    }
+
+    return data + offset;
+  };
+
+  uint table_size = header.mask + 1;
+
+  if (header.num_keywords >= 255 || table_size == 0 || (table_size & header.mask) != 0 ||
+      ! validData(header.keywords, size_t(header.num_keywords)*2*sizeof(uint32_t)) ||
+      ! validData(header.slots, table_size))
+    return error("Invalid syntax image");
+
+  const auto *slots = reinterpret_cast<const unsigned char *>(data + header.slots);
+
+  for (uint i = 0; i < table_size; ++i)
+    if (slots[i] > header.num_keywords)
+      return error("Invalid syntax image");
+
+  keywords_.clear();
+
+  for (uint i = 0; i < header.num_keywords; ++i) {
+    uint32_t keywordData[2];
+
+    memcpy(keywordData, data + header.keywords + i*sizeof(keywordData), sizeof(keywordData));
+
+    const char *str = imageString(keywordData[0]);
+
+    if (! str || keywordData[1] != strlen(str))
+      return error("Invalid syntax image");
+
+    keywords_.emplace_back(str, keywordData[1]);
+  }
+
+  //---
+
+  CSyntaxTable::Def def;
+
+  const char *name   = imageString(header.name);
+  const char *quotes = imageString(header.quotes);
+
+  def.name                = (name   ? name   : "");
+  def.line_comment        = imageString(header.line_comment);
+  def.block_comment_start = imageString(header.block_comment_start);
+  def.block_comment_end   = imageString(header.block_comment_end);
+  def.quotes              = (quotes ? quotes : "");
+  def.prepro              = char(header.prepro);
+
+  if (! valid || (def.block_comment_start && ! def.block_comment_end))
+    return error("Invalid syntax image");
+
+  def.keywords.keywords       = keywords_.data();
+  def.keywords.slots          = (header.num_keywords ? slots : nullptr);
+  def.keywords.mask           = header.mask;
+  def.keywords.seed           = header.seed;
+  def.keywords.case_sensitive = (header.flags & FLAG_CASE_SENSITIVE);
+
+  def_ = def;
+
+  return true;
+}
+
+void
+CSyntaxDef::
+reset()
+{
+  if (map_)
+    munmap(map_, map_size_);
+
+  map_      = nullptr;
+  map_size_ = 0;
+
+  image_.clear();
+
+  keywords_.clear();
+
+  def_ = CSyntaxTable::Def();
+
+  error_msg_ = "";
+}
+
+bool
+CSyntaxDef::
+error(const std::string &msg)
+{
+  error_msg_ = msg;
+
+  return false;
+}
@@ -1,9 +1,6 @@
 #include <CSyntaxPython.h>
-#include <CFile.h>
-#include <map>
-#include <cstring>
 
-static const char *
+static constexpr std::string_view
 keywords[] = {
   "and",
   "as",
@@ -42,6 +39,8 @@ keywords[] = {
   "yield",
 };
 
+static constexpr CSyntaxKeywordHash keywordHash(keywords);
+
 // "match", "case" and "_" are 'soft keywords
 
 #if 0
@@ -103,141 +102,29 @@ operators[] = {
 };
 #endif
 
-using TokenHash = std::map<std::string, CSyntaxToken>;
-
-static TokenHash token_hash[20];
-
-CSyntaxPython::
-CSyntaxPython()
+static CSyntaxTable::Def
+pythonDef()
 {
-  continued_  = false;
-  last_token_ = CSyntaxToken::NONE;
-
-  auto num_keywords = sizeof(keywords)/sizeof(char *);
+  CSyntaxTable::Def def;
 
-  for (uint i = 0; i < num_keywords; ++i) {
-    auto len = strlen(keywords[i]);
+  def.name                = "Python";
+  def.keywords            = keywordHash.keywords();
+  def.line_comment        = "#";
+  def.block_comment_start = nullptr;
+  def.block_comment_end   = nullptr;
+  def.quotes              = "\"'";
+  def.prepro              = '\0';
 
-    token_hash[len][keywords[i]] = CSyntaxToken::KEYWORD;
-  }
+  return def;
 }
 
 CSyntaxPython::
-~CSyntaxPython()
+CSyntaxPython() :
+ CSyntaxTable(pythonDef())
 {
 }
 
-void
 CSyntaxPython::
-processLine(const std::string &line)
-{
-  //bool continued = continued_;
-
-  continued_ = false;
-
-  uint i   = 0;
-  auto len = line.size();
-
-  const char *cstr = line.c_str();
-
-  // skip leading space
-  while (i < len && isspace(cstr[i]))
-    ++i;
-
-  //uint lead = i;
-
-  //------
-
-  std::string word;
-  bool        in_word    = false;
-  bool        in_string  = false;
-  uint        word_start = 0;
-
-  for ( ; i < len; ++i) {
-    char c = cstr[i];
-
-    if      (in_word) {
-      if (isalnum(c) || c == '_')
-        word += c;
-      else {
-        auto token = findWord(word);
-
-        if (token != CSyntaxToken::NONE) {
-          addToken(line_num_, word_start, word, token);
-
-          word = c;
-
-          addText(line_num_, word_start, word);
-        }
-        else {
-          word += c;
-
-          addText(line_num_, word_start, word);
-        }
-
-        in_word = false;
-      }
-    }
-    else if (in_string) {
-      if (c == word[0]) {
-        word += c;
-
-        addToken(line_num_, word_start, word, CSyntaxToken::STRING);
-
-        in_string = false;
-      }
-      else
-        word += c;
-    }
-    else {
-      if      (c == '#') {
-        word_start = i;
-        word       = line.substr(i);
-
-        addToken(line_num_, word_start, word, CSyntaxToken::COMMENT);
-
-        break;
-      }
-      else if (isalpha(c) || c == '_') {
-        word_start = i;
-        word       = c;
-        in_word    = true;
-      }
-      else if (c == '\'' || c == '\"') {
-        word_start = i;
-        word       = c;
-        in_string  = true;
-      }
-      else {
-        word = c;
-
-        addText(line_num_, i, word);
-      }
-    }
-  }
-
-  if      (in_word) {
-    auto token = findWord(word);
-
-    if (token != CSyntaxToken::NONE)
-      addToken(line_num_, word_start, word, token);
-    else
-      addText(line_num_, word_start, word);
-  }
-  else if (in_string)
-    addToken(line_num_, word_start, word, CSyntaxToken::STRING);
-}
-
-CSyntaxToken
-CSyntaxPython::
-findWord(const std::string &word)
+~CSyntaxPython()
 {
-  const auto &hash = token_hash[word.size()];
-
-  auto p = hash.find(word);
-
-  if (p == hash.end())
-    return CSyntaxToken::NONE;
-
-  return (*p).second;
 }
@@ -0,0 +1,206 @@
+#include <CSyntaxTable.h>
+#include <cstring>
+
+CSyntaxTable::
+CSyntaxTable(const Def &def) :
+ def_(def)
+{
+  // character tables
+  for (uint c = 0; c < 256; ++c) {
+    action_[c] = ACTION_TEXT;
+    word_  [c] = (isalnum(int(c)) || c == '_');
+
+    if      (isspace(int(c)))
+      action_[c] = ACTION_SPACE;
+    else if (isalpha(int(c)) || c == '_')
+      action_[c] = ACTION_WORD;
+  }
+
+  for (const char *q = def_.quotes; q && *q; ++q)
+    action_[(unsigned char) *q] = ACTION_STRING;
+
+  // first char of comment delimiter needs a check for the rest
+  if (def_.line_comment && *def_.line_comment)
+    action_[(unsigned char) def_.line_comment[0]] = ACTION_COMMENT;
+
+  if (def_.block_comment_start && *def_.block_comment_start)
+    action_[(unsigned char) def_.block_comment_start[0]] = ACTION_COMMENT;
+}
+
+CSyntaxTable::
+~CSyntaxTable()
+{
+}
+
+void
+CSyntaxTable::
+init()
+{
+  CSyntax::init();
+
+  state_ = STATE_NORMAL;
+}
+
+void
+CSyntaxTable::
+processLine(const std::string_view &line)
+{
+  lexLine(line.data(), uint(line.size()), spans_);
+
+  addSpans(line_num_, line, spans_);
+}
+
+void
+CSyntaxTable::
+lexLine(const char *str, uint len, Spans &spans)
+{
+  spans.clear();
+
+  auto addSpan = [&](uint start, uint end, CSyntaxToken token) {
+    if (end > start)
+      spans.push_back(Span { start, end - start, token });
+  };
+
+  auto continuedLine = [&]() {
+    return (len > 0 && str[len - 1] == '\\');
+  };
+
+  uint i = 0;
+
+  //---
+
+  if      (state_ == STATE_PREPRO) {
+    // continued preprocessor line
+    addSpan(0, len, CSyntaxToken::PREPRO);
+
+    state_ = (continuedLine() ? STATE_PREPRO : STATE_NORMAL);
+
+    return;
+  }
+  else if (state_ == STATE_BLOCK_COMMENT) {
+    // continued block comment
+    uint end;
+
+    bool closed = findBlockEnd(str, len, 0, end);
+
+    addSpan(0, end, CSyntaxToken::COMMENT);
+
+    if (! closed)
+      return;
+
+    state_ = STATE_NORMAL;
+
+    i = end;
+  }
+  else {
+    // preprocessor line (first non-space char)
+    while (i < len && action_[(unsigned char) str[i]] == ACTION_SPACE)
+      ++i;
+
+    if (def_.prepro && i < len && str[i] == def_.prepro) {
+      addSpan(i, len, CSyntaxToken::PREPRO);
+
+      if (continuedLine())
+        state_ = STATE_PREPRO;
+
+      return;
+    }
+  }
+
+  //---
+
+  while (i < len) {
+    char c = str[i];
+
+    switch (action_[(unsigned char) c]) {
+      case ACTION_WORD: {
+        uint start = i++;
+
+        while (i < len && word_[(unsigned char) str[i]])
+          ++i;
+
+        auto token = findWord(&str[start], i - start);
+
+        if (token != CSyntaxToken::NONE)
+          addSpan(start, i, token);
+
+        break;
+      }
+      case ACTION_STRING: {
+        // string to matching quote (or end of line)
+        uint start = i++;
+
+        while (i < len && str[i] != c)
+          ++i;
+
+        if (i < len)
+          ++i;
+
+        addSpan(start, i, CSyntaxToken::STRING);
+
+        break;
+      }
+      case ACTION_COMMENT: {
+        if      (matchAt(str, len, i, def_.line_comment)) {
+          addSpan(i, len, CSyntaxToken::COMMENT);
+
+          i = len;
+        }
+        else if (matchAt(str, len, i, def_.block_comment_start)) {
+          uint start = i;
+
+          uint end;
+
+          if (! findBlockEnd(str, len, i + uint(strlen(def_.block_comment_start)), end))
+            state_ = STATE_BLOCK_COMMENT;
+
+          addSpan(start, end, CSyntaxToken::COMMENT);
+
+          i = end;
+        }
+        else
+          ++i;
+
+        break;
+      }
+      default: {
+        ++i;
+
+        break;
+      }
+    }
+  }
+}
+
+bool
+CSyntaxTable::
+matchAt(const char *str, uint len, uint i, const char *delim) const
+{
+  if (! delim || ! *delim)
+    return false;
+
+  uint n = uint(strlen(delim));
+
+  return (i + n <= len && memcmp(&str[i], delim, n) == 0);
+}
+
+bool
+CSyntaxTable::
+findBlockEnd(const char *str, uint len, uint i, uint &end) const
+{
+  // end is position after end delimiter (or len if not found)
+  const char *delim = def_.block_comment_end;
+
+  uint n = uint(strlen(delim));
+
+  for ( ; i + n <= len; ++i) {
+    if (memcmp(&str[i], delim, n) == 0) {
+      end = i + n;
+      return true;
+    }
+  }
+
+  end = len;
+
+  return false;
+}
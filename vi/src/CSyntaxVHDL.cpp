@@ -1,10 +1,7 @@
 #include <CSyntaxVHDL.h>
-#include <CFile.h>
-#include <map>
-#include <cstring>
 #include <iostream>
 
-static const char *
+static constexpr std::string_view
 keywords[] = {
   "abs",
   "access",
@@ -104,17 +101,27 @@ keywords[] = {
   "xor"
 };
 
-CSyntaxVHDL::
-CSyntaxVHDL()
+// VHDL is case insensitive
+static constexpr CSyntaxKeywordHash<sizeof(keywords)/sizeof(keywords[0]), false>
+keywordHash(keywords);
+
+static CSyntaxTable::Def
+vhdlDef()
 {
-  auto num_keywords = sizeof(keywords)/sizeof(char *);
+  CSyntaxTable::Def def;
 
-  for (uint i = 0; i < num_keywords; ++i) {
-    auto len = strlen(keywords[i]);
+  def.name         = "VHDL";
+  def.keywords     = keywordHash.keywords();
+  def.line_comment = "--";
+  def.quotes       = "\"'";
 
-    tokenHash_[len][keywords[i]] = CSyntaxToken::KEYWORD;
-  }
+  return def;
+}
 
+CSyntaxVHDL::
+CSyntaxVHDL() :
+ CSyntaxTable(vhdlDef())
+{
   auto addBlock = [&](const std::string &name, BlockType type,
                       bool hasName, const std::string &extraKeyword) {
     BlockDef blockDef;
@@ -144,6 +151,13 @@ void
 CSyntaxVHDL::
 init()
 {
+  CSyntaxTable::init();
+
+  // block state is not part of lexer state so restart it with each pass
+  blockStack_.clear();
+
+  blockData_   = BlockData();
+  inBlockName_ = false;
 }
 
 void
@@ -151,60 +165,45 @@ CSyntaxVHDL::
 term()
 {
   while (blockData_.blockType != BlockType::NONE) {
-    printBlock(blockData_);
+    if (debug_)
+      printBlock(blockData_);
 
-    if (! blockStack_.empty())
+    if (! blockStack_.empty()) {
       blockData_ = blockStack_.back();
+
+      blockStack_.pop_back();
+    }
     else
       blockData_ = BlockData();
-
-    blockStack_.pop_back();
   }
+
+  CSyntaxTable::term();
 }
 
 void
 CSyntaxVHDL::
-processLine(const std::string &line)
+processLine(const std::string_view &line)
 {
-  auto len = line.size();
-
-  //------
-
-  // skip leading space
-  auto *cstr = line.c_str();
-
-  //------
-
-#if 0
-  auto endBlockName = [&]() {
-    if (inBlockName_) {
-      auto pn = blockTypeName_.find(blockData_.blockType);
-
-      if      (pn != blockTypeName_.end()) {
-        const auto &blockDef = (*pn).second;
-
-        std::cerr << blockDef.name;
-      }
-      else
-        std::cerr << "<block>";
-
-      std::cerr << " " << blockData_.blockName << "\n";
+  CSyntaxTable::processLine(line);
 
-      inBlockName_ = false;
-    }
-  };
-#endif
+  // blocks are only tracked for debug output
+  if (debug_)
+    updateBlocks(line);
+}
 
-  auto nameBlockType = [&](const std::string &name) {
+void
+CSyntaxVHDL::
+updateBlocks(const std::string_view &line)
+{
+  // keywords are case insensitive (words are compared lowercase)
+  auto nameBlockType = [&](const std::string_view &name) {
     auto pb = nameBlockType_.find(name);
     if (pb == nameBlockType_.end()) return BlockType::NONE;
 
     return (*pb).second;
   };
 
-  auto startKeyword = [&](const std::string &word) {
-    //endBlockName();
-
+  auto startKeyword = [&](const std::string_view &word) {
     auto blockType = nameBlockType(word);
     if (blockType == BlockType::NONE) return;
 
@@ -227,18 +226,18 @@ processLine(const std::string &line)
       extraKeyword_ = "";
     }
 
-    std::cerr << "Start: "; printBlockName(blockData_);
+    if (debug_) {
+      std::cerr << "Start: "; printBlockName(blockData_);
+    }
   };
 
   auto endKeyword = [&](BlockType blockType) {
-    //endBlockName();
-
     if (blockType != BlockType::NONE) {
       while (blockData_.blockType != BlockType::NONE &&
              blockData_.blockType != blockType) {
         blockData_.endLine = int(line_num_);
 
-        if (blockData_.blockType != BlockType::NONE) {
+        if (debug_ && blockData_.blockType != BlockType::NONE) {
           std::cerr << "End: "; printBlock(blockData_);
         }
 
@@ -258,7 +257,7 @@ processLine(const std::string &line)
 
     blockData_.endLine = int(line_num_);
 
-    if (blockData_.blockType != BlockType::NONE) {
+    if (debug_ && blockData_.blockType != BlockType::NONE) {
       std::cerr << "End: "; printBlock(blockData_);
     }
 
@@ -275,189 +274,122 @@ processLine(const std::string &line)
 
   //------
 
-  auto readWord = [&](uint &i) {
-    std::string word;
-
-    while (i < len) {
-      char c = cstr[i];
-
-      if (isalnum(c) || c == '_')
-        word += c;
-      else
-        break;
-
-      ++i;
-    }
-
-    return word;
-  };
-
-  auto readString = [&](char startChar, uint &i) {
-    std::string word;
-
-    while (i < len) {
-      char c = cstr[i++];
+  // collect words outside strings and comments
+  words_.clear();
 
-      if (c == startChar) {
-        word += c;
-        break;
-      }
-      else
-        word += c;
-    }
+  auto len  = uint(line.size());
+  auto cstr = line.data();
 
-    return word;
-  };
+  // line lowercased once (buffer reused) for keyword compares
+  lowerLine_.assign(line.data(), line.size());
 
-  auto skipSpace = [&](uint &i) {
-    while (i < len && isspace(cstr[i]))
-      ++i;
-  };
+  for (auto &c : lowerLine_)
+    c = char(tolower(c));
 
-  //------
+  bool follows = false;
 
   uint i = 0;
 
-  skipSpace(i);
-
   while (i < len) {
     char c = cstr[i];
 
-    // -- comment to end of line
-    if      (i < len - 1 && c == '-' && cstr[i + 1] == '-') {
-      uint wordStart = i;
-
-      std::string word = line.substr(i);
-
-      addToken(line_num_, wordStart, word, CSyntaxToken::COMMENT);
-
+    if      (i < len - 1 && c == '-' && cstr[i + 1] == '-')
       break;
-    }
-    // word
     else if (isalpha(c) || c == '_') {
       uint wordStart = i;
 
-      std::string word = readWord(i);
-
-      //---
-
-      CSyntaxToken token = findWord(word);
-
-      if (token != CSyntaxToken::NONE) {
-        if (word == "end") {
-          skipSpace(i);
-
-          uint wordStart1 = i;
-
-          std::string word1 = readWord(i);
-
-          CSyntaxToken token1 = findWord(word1);
+      while (i < len && (isalnum(cstr[i]) || cstr[i] == '_'))
+        ++i;
 
-          if (token1 != CSyntaxToken::NONE) {
-            auto blockType1 = nameBlockType(word1);
+      Word word;
 
-            endKeyword(blockType1);
+      word.str     = std::string_view(&cstr[wordStart], i - wordStart);
+      word.lower   = std::string_view(&lowerLine_[wordStart], i - wordStart);
+      word.keyword = (findWord(&cstr[wordStart], i - wordStart) != CSyntaxToken::NONE);
+      word.follows = follows;
 
-            addToken(line_num_, wordStart, word , token );
-            addToken(line_num_, wordStart, word1, token1);
-          }
-          else {
-            endKeyword(BlockType::NONE);
-
-            addToken(line_num_, wordStart, word, token);
-
-            if (word1 == blockData_.blockName)
-              endKeyword(BlockType::NONE);
-
-            addText(line_num_, wordStart1, word1);
-          }
-        }
-        else {
-          startKeyword(word);
-
-          addToken(line_num_, wordStart, word, token);
+      words_.push_back(word);
 
-          if (inBlockName_) {
-            skipSpace(i);
+      follows = true;
+    }
+    else if (c == '\'' || c == '\"') {
+      ++i;
 
-            uint wordStart1 = i;
+      while (i < len && cstr[i] != c)
+        ++i;
 
-            std::string word1 = readWord(i);
+      if (i < len)
+        ++i;
 
-            blockData_.blockName = word1;
+      follows = false;
+    }
+    else {
+      if (! isspace(c))
+        follows = false;
 
-            addText(line_num_, wordStart1, word1);
+      ++i;
+    }
+  }
 
-            if (extraKeyword_ != "") {
-              skipSpace(i);
+  //------
 
-              uint wordStart2 = i;
+  uint numWords = uint(words_.size());
 
-              std::string word2 = readWord(i);
+  // next word (if only separated by space)
+  auto nextWord = [&](uint k) -> const Word * {
+    return (k < numWords && words_[k].follows ? &words_[k] : nullptr);
+  };
 
-              CSyntaxToken token2 = findWord(word2);
+  for (uint k = 0; k < numWords; ++k) {
+    const auto &word = words_[k];
 
-              if (token2 != CSyntaxToken::NONE) {
-                if (word2 != extraKeyword_)
-                  endKeyword(BlockType::NONE);
+    if (! word.keyword) {
+      if (inBlockName_)
+        blockData_.blockName = std::string(word.str);
 
-                addToken(line_num_, wordStart2, word2, token2);
-              }
-              else {
-                endKeyword(BlockType::NONE);
+      continue;
+    }
 
-                addText(line_num_, wordStart2, word2);
-              }
-            }
+    if (word.lower == "end") {
+      auto *word1 = nextWord(k + 1);
 
-            inBlockName_ = false;
-          }
-        }
-      }
+      if (word1 && word1->keyword)
+        endKeyword(nameBlockType(word1->lower));
       else {
-        if (inBlockName_)
-          blockData_.blockName = word;
+        endKeyword(BlockType::NONE);
 
-        addText(line_num_, wordStart, word);
+        if ((word1 ? word1->str : std::string_view()) == blockData_.blockName)
+          endKeyword(BlockType::NONE);
       }
-    }
-    // start string
-    else if (c == '\'' || c == '\"') {
-      uint wordStart = i;
-
-      std::string word = readString(c, i);
 
-      addToken(line_num_, wordStart, word, CSyntaxToken::STRING);
+      if (word1)
+        ++k;
     }
     else {
-      std::string word = std::string(&c, 1);
-
-      addText(line_num_, i, word);
+      startKeyword(word.lower);
 
-      ++i;
-    }
-
-    skipSpace(i);
-  }
-}
+      if (inBlockName_) {
+        auto *word1 = nextWord(k + 1);
 
-CSyntaxToken
-CSyntaxVHDL::
-findWord(const std::string &word)
-{
-  auto len = word.size();
+        blockData_.blockName = (word1 ? std::string(word1->str) : std::string());
 
-  if (len >= MAX_TOKEN_LEN)
-    return CSyntaxToken::NONE;
+        if (word1)
+          ++k;
 
-  const auto &hash = tokenHash_[len];
+        if (extraKeyword_ != "") {
+          auto *word2 = (word1 ? nextWord(k + 1) : nullptr);
 
-  auto p = hash.find(word);
+          if (! word2 || ! word2->keyword || word2->lower != extraKeyword_)
+            endKeyword(BlockType::NONE);
 
-  if (p == hash.end())
-    return CSyntaxToken::NONE;
+          if (word2)
+            ++k;
+        }
 
-  return (*p).second;
+        inBlockName_ = false;
+      }
+    }
+  }
 }
 
 void
@@ -0,0 +1,391 @@
+#include <CSyntaxWorker.h>
+#include <algorithm>
+
+namespace {
+
+// lines lexed between publishing results
+const uint BATCH_SIZE = 256;
+
+// lines of first snapshot after lines changed
+const uint MIN_SNAPSHOT_LINES = 4096;
+
+// minimum lines per chunk of parallel initial pass. Follows snapshot size so
+// the first snapshot splits in two and each doubled snapshot after it can use
+// twice as many chunks (up to number of threads)
+const uint CHUNK_SIZE = MIN_SNAPSHOT_LINES/2;
+
+class SpanNotifier : public CSyntaxNotifier {
+ public:
+  void setSpans(CSyntaxWorker::Spans *spans) { spans_ = spans; }
+
+  void addToken(uint, uint word_start, const std::string &word, CSyntaxToken token) override {
+    spans_->push_back(CSyntaxSpan { word_start, uint(word.size()), token });
+  }
+
+  void addSpans(uint, const std::string_view &, const CSyntaxSpans &spans) override {
+    spans_->insert(spans_->end(), spans.begin(), spans.end());
+  }
+
+ private:
+  CSyntaxWorker::Spans *spans_ { nullptr };
+};
+
+}
+
+//---
+
+CSyntaxWorker::
+CSyntaxWorker()
+{
+}
+
+CSyntaxWorker::
+~CSyntaxWorker()
+{
+  cancel();
+}
+
+uint
+CSyntaxWorker::
+snapshotLines(uint generation)
+{
+  if (snapshot_lines_ == 0 || generation != generation_)
+    snapshot_lines_ = MIN_SNAPSHOT_LINES;
+  else
+    snapshot_lines_ = std::min(snapshot_lines_*2, 1U<<30);
+
+  return snapshot_lines_;
+}
+
+bool
+CSyntaxWorker::
+start(const CSyntax &syntax, uint generation, uint line_num, uint state,
+      Lines &&lines, uint stop_line, uint num_lines)
+{
+  cancel();
+
+  syntax_ = SyntaxP(syntax.dup());
+
+  if (! syntax_)
+    return false;
+
+  generation_ = generation;
+  line_num_   = line_num;
+  state_      = state;
+  lines_      = std::move(lines);
+  stop_line_  = stop_line;
+  num_lines_  = num_lines;
+
+  cancel_ = false;
+  done_   = false;
+  busy_   = true;
+
+  thread_ = std::thread(&CSyntaxWorker::run, this);
+
+  return true;
+}
+
+void
+CSyntaxWorker::
+cancel()
+{
+  if (thread_.joinable()) {
+    cancel_ = true;
+
+    thread_.join();
+  }
+
+  results_.clear();
+
+  lines_.clear();
+
+  busy_ = false;
+}
+
+bool
+CSyntaxWorker::
+takeResults(Results &results, uint &end_line, bool &carry)
+{
+  if (! busy_)
+    return false;
+
+  bool done;
+
+  {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (results.empty())
+    results.swap(results_);
+  else {
+    for (auto &result : results_)
+      results.push_back(std::move(result));
+
+    results_.clear();
+  }
+
+  done     = done_;
+  end_line = end_line_;
+  carry    = end_carry_;
+  }
+
+  if (done) {
+    thread_.join();
+
+    lines_.clear();
+
+    busy_ = false;
+  }
+
+  return done;
+}
+
+void
+CSyntaxWorker::
+run()
+{
+  if (runChunks())
+    return;
+
+  SpanNotifier notifier;
+
+  syntax_->setNotifier(&notifier);
+
+  if (line_num_ == 0)
+    syntax_->init();
+
+  syntax_->setState(state_);
+
+  // same convergence rule as the synchronous update : a line is skipped when
+  // the state carried into it is unchanged and its stored result is valid
+  bool carry = true;
+
+  Results results;
+
+  uint num_lines = uint(lines_.size());
+
+  uint i = 0;
+
+  for ( ; i < num_lines; ++i) {
+    if (cancel_)
+      break;
+
+    const auto &line = lines_[i];
+
+    uint line_num = line_num_ + i;
+
+    if (! carry && line.valid) {
+      if (line_num > stop_line_)
+        break;
+
+      syntax_->setState(uint(line.state));
+
+      continue;
+    }
+
+    results.emplace_back();
+
+    auto &result = results.back();
+
+    result.line_num = line_num;
+
+    notifier.setSpans(&result.spans);
+
+    syntax_->setLineNum(line_num);
+
+    syntax_->processLine(line.str);
+
+    result.state = syntax_->getState();
+
+    carry = (int(result.state) != line.state);
+
+    if (results.size() >= BATCH_SIZE) {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      for (auto &result1 : results)
+        results_.push_back(std::move(result1));
+
+      results.clear();
+    }
+  }
+
+  // end of file (not just end of snapshot)
+  bool at_end = (line_num_ + i >= num_lines_);
+
+  if (at_end && ! cancel_)
+    syntax_->term();
+
+  syntax_->setNotifier(nullptr);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (auto &result1 : results)
+    results_.push_back(std::move(result1));
+
+  end_line_  = line_num_ + i;
+  end_carry_ = (i >= num_lines && carry && ! at_end);
+  done_      = true;
+}
+
+bool
+CSyntaxWorker::
+runChunks()
+{
+  uint num_lines = uint(lines_.size());
+
+  uint num_threads = num_threads_;
+
+  if (num_threads == 0)
+    num_threads = std::thread::hardware_concurrency();
+
+  uint num_chunks = std::min(num_threads, num_lines/CHUNK_SIZE);
+
+  if (num_chunks < 2)
+    return false;
+
+  // only for initial pass (no stored results to converge with)
+  for (const auto &line : lines_)
+    if (line.valid)
+      return false;
+
+  //---
+
+  // lex chunks in parallel, first from the start state, rest from guess
+  const uint guess_state = 0;
+
+  struct Chunk {
+    uint    start     { 0 };
+    uint    end       { 0 };
+    Results results;
+    uint    published { 0 };
+  };
+
+  std::vector<Chunk> chunks(num_chunks);
+
+  for (uint c = 0; c < num_chunks; ++c) {
+    chunks[c].start = uint((size_t(num_lines)* c     )/num_chunks);
+    chunks[c].end   = uint((size_t(num_lines)*(c + 1))/num_chunks);
+  }
+
+  // queue chunk results up to n for owner
+  auto publish = [&](Chunk &chunk, uint n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (uint i = chunk.published; i < n; ++i)
+      results_.push_back(std::move(chunk.results[i]));
+
+    chunk.published = n;
+  };
+
+  auto lexChunk = [&](uint c) {
+    SyntaxP syntax(syntax_->dup());
+
+    SpanNotifier notifier;
+
+    syntax->setNotifier(&notifier);
+
+    if (line_num_ == 0)
+      syntax->init();
+
+    syntax->setState(c == 0 ? state_ : guess_state);
+
+    auto &chunk = chunks[c];
+
+    chunk.results.resize(chunk.end - chunk.start);
+
+    for (uint i = chunk.start; i < chunk.end; ++i) {
+      if (cancel_)
+        break;
+
+      auto &result = chunk.results[i - chunk.start];
+
+      result.line_num = line_num_ + i;
+
+      notifier.setSpans(&result.spans);
+
+      syntax->setLineNum(result.line_num);
+
+      syntax->processLine(lines_[i].str);
+
+      result.state = syntax->getState();
+
+      // first chunk starts from true state so is shown as it is lexed
+      if (c == 0 && (i + 1 - chunk.start) % BATCH_SIZE == 0)
+        publish(chunk, i + 1 - chunk.start);
+    }
+
+    syntax->setNotifier(nullptr);
+  };
+
+  std::vector<std::thread> threads(num_chunks);
+
+  for (uint c = 1; c < num_chunks; ++c)
+    threads[c] = std::thread(lexChunk, c);
+
+  lexChunk(0);
+
+  //---
+
+  // publish chunks in order as they complete, fixing up each chunk head :
+  // re-lex from true incoming state until the end state matches the guessed
+  // one (rest of chunk is then unchanged)
+  SpanNotifier notifier;
+
+  syntax_->setNotifier(&notifier);
+
+  uint state = state_;
+
+  for (uint c = 0; c < num_chunks; ++c) {
+    if (c > 0)
+      threads[c].join();
+
+    if (cancel_)
+      continue;
+
+    auto &chunk = chunks[c];
+
+    if (c > 0) {
+      if (state != guess_state) {
+        syntax_->setState(state);
+
+        for (auto &result : chunk.results) {
+          uint old_state = result.state;
+
+          result.spans.clear();
+
+          notifier.setSpans(&result.spans);
+
+          syntax_->setLineNum(result.line_num);
+
+          syntax_->processLine(lines_[result.line_num - line_num_].str);
+
+          result.state = syntax_->getState();
+
+          if (result.state == old_state)
+            break;
+        }
+      }
+    }
+
+    state = chunk.results.back().state;
+
+    publish(chunk, uint(chunk.results.size()));
+
+    Results().swap(chunk.results);
+  }
+
+  bool at_end = (line_num_ + num_lines >= num_lines_);
+
+  if (at_end && ! cancel_)
+    syntax_->term();
+
+  syntax_->setNotifier(nullptr);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // state into line after snapshot is unknown (nothing stored to compare)
+  end_line_  = line_num_ + num_lines;
+  end_carry_ = ! at_end;
+  done_      = true;
+
+  return true;
+}
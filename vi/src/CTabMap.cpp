@@ -0,0 +1,105 @@
+#include <CTabMap.h>
+#include <algorithm>
+
+void
+CTabMap::
+build(const std::string_view &str, uint tab_stop, bool fixed)
+{
+  tabs_.clear();
+
+  if (tab_stop == 0)
+    tab_stop = 1;
+
+  len_      = uint(str.size());
+  tab_stop_ = tab_stop;
+  fixed_    = fixed;
+
+  uint col = 0;
+
+  for (uint i = 0; i < len_; ++i) {
+    if (str[i] == '\t') {
+      col += (fixed ? tab_stop : tab_stop - (col % tab_stop));
+
+      Tab tab;
+
+      tab.pos = i;
+      tab.col = col;
+
+      tabs_.push_back(tab);
+    }
+    else
+      ++col;
+  }
+
+  valid_ = true;
+}
+
+void
+CTabMap::
+reset()
+{
+  tabs_.clear();
+
+  len_   = 0;
+  valid_ = false;
+}
+
+uint
+CTabMap::
+tabAt(uint char_num) const
+{
+  auto p = std::lower_bound(tabs_.begin(), tabs_.end(), char_num,
+    [](const Tab &tab, uint pos) { return tab.pos < pos; });
+
+  return uint(p - tabs_.begin());
+}
+
+uint
+CTabMap::
+charToCol(uint char_num) const
+{
+  // chars after last tab before char are one column each
+  uint i = tabAt(char_num);
+
+  if (i == 0)
+    return char_num;
+
+  const Tab &tab = tabs_[i - 1];
+
+  return tab.col + (char_num - tab.pos - 1);
+}
+
+uint
+CTabMap::
+charCols(uint char_num) const
+{
+  uint i = tabAt(char_num);
+
+  if (i < tabs_.size() && tabs_[i].pos == char_num)
+    return tabs_[i].col - charToCol(char_num);
+
+  return 1;
+}
+
+uint
+CTabMap::
+colToChar(uint col) const
+{
+  // first tab ending after column
+  auto p = std::upper_bound(tabs_.begin(), tabs_.end(), col,
+    [](uint col, const Tab &tab) { return col < tab.col; });
+
+  uint i = uint(p - tabs_.begin());
+
+  // column inside tab
+  if (i < tabs_.size() && col >= charToCol(tabs_[i].pos))
+    return tabs_[i].pos;
+
+  // column in chars after previous tab
+  if (i == 0)
+    return col;
+
+  const Tab &tab = tabs_[i - 1];
+
+  return tab.pos + 1 + (col - tab.col);
+}
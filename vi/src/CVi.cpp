@@ -2,13 +2,129 @@
 #include <CEd.h>
 #include <CSyntaxC.h>
 #include <CSyntaxCPP.h>
+#include <CSyntaxBrackets.h>
+#include <CSyntaxGeneric.h>
+#include <CSyntaxWorker.h>
 #include <CFile.h>
 #include <CStrUtil.h>
 
+#include <algorithm>
 #include <cstring>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 
+namespace {
+
+// adds syntax tokens to line annotations
+class SyntaxNotifier : public CSyntaxNotifier {
+ public:
+  SyntaxNotifier(CSyntaxBrackets *brackets=nullptr) :
+   brackets_(brackets) {
+  }
+
+  void setLine(CVi::Line *line) {
+    line_ = line;
+  }
+
+  void addToken(uint, uint word_start, const std::string &word, CSyntaxToken token) override {
+    line_->addAnnotation(word_start, int(word_start + word.size() - 1), token);
+  }
+
+  void addSpans(uint line_num, const std::string_view &str, const CSyntaxSpans &spans) override {
+    for (const auto &span : spans)
+      line_->addAnnotation(span.start, int(span.start + span.len - 1), span.token);
+
+    if (brackets_)
+      brackets_->setLine(line_num, str, spans);
+  }
+
+ private:
+  CSyntaxBrackets* brackets_ { nullptr };
+  CVi::Line*       line_     { nullptr };
+};
+
+// lines to re-lex from lineNum to before lineEnd (views of line text). The end
+// state of each line is stored when the next line is requested and once it
+// matches the previously stored state, valid lines are skipped (restoring
+// their state) up to lineNum2. If the start state is a guess (not exact)
+// results are shown but never stored : a valid line's stored state may be
+// stale too so it only improves the guess.
+class SyntaxLines : public CSyntaxLineIterator {
+ public:
+  SyntaxLines(CVi::App *app, SyntaxNotifier &notifier, int lineNum, int lineNum2,
+              int lineEnd, bool exact=true) :
+   app_(app), notifier_(notifier), lineNum_(lineNum), lineNum2_(lineNum2),
+   lineEnd_(lineEnd), exact_(exact) {
+  }
+
+  int lineNum() const { return lineNum_; }
+
+  bool isExact() const { return exact_; }
+  bool isCarry() const { return carry_; }
+
+  bool nextLine(uint &line_num, std::string_view &str) override {
+    auto *syntax = app_->syntax();
+
+    // store end state of last line (guessed results are not stored so later
+    // lines still compare against states they were lexed with)
+    if (line_) {
+      if (exact_) {
+        int state = int(syntax->getState());
+
+        carry_ = (state != line_->getSyntaxState());
+
+        line_->setSyntaxState(state);
+        line_->setSyntaxValid(true);
+      }
+
+      line_ = nullptr;
+
+      ++lineNum_;
+    }
+
+    for ( ; lineNum_ < lineEnd_; ++lineNum_) {
+      auto *line = app_->getLine(lineNum_);
+
+      if (line->getSyntaxValid() && (! exact_ || ! carry_)) {
+        if (lineNum_ > lineNum2_)
+          return false;
+
+        syntax->setState(uint(line->getSyntaxState()));
+
+        carry_ = false;
+
+        continue;
+      }
+
+      notifier_.setLine(line);
+
+      line->clearAnnotations();
+
+      line_ = line;
+
+      line_num = uint(lineNum_);
+      str      = line->chars();
+
+      return true;
+    }
+
+    return false;
+  }
+
+ private:
+  CVi::App*       app_      { nullptr };
+  SyntaxNotifier& notifier_;
+  int             lineNum_  { 0 };
+  int             lineNum2_ { 0 };
+  int             lineEnd_  { 0 };
+  bool            exact_    { true };
+  bool            carry_    { true };
+  CVi::Line*      line_     { nullptr };
+};
+
+}
+
 static bool my_assert(const char *m, bool ret) {
   std::cerr << m << "\n";
   return ret;
@@ -184,6 +300,10 @@ void
 App::
 processChar(const KeyData &keyData)
 {
+  // record typed keys (not keys replayed by '.' or '@')
+  if (isRecording() && playDepth_ == 0)
+    recordKeys_.push_back(keyData);
+
   if      (getInsertMode())
     processInsertChar(keyData);
   else if (getCmdLineMode())
@@ -228,6 +348,34 @@ processCommandChar(const KeyData &keyData)
 
         goto done;
       }
+      case 'q': { // start recording keys to register
+        if (isalnum(key))
+          startRecording(key);
+        else
+          error("Invalid register");
+
+        goto done;
+      }
+      case '@': { // play keys in register
+        uint n = std::max(count_, 1U);
+
+        count_   = 0;
+        lastKey_ = '\0';
+
+        // @@ repeats last played register
+        if (key == '@') {
+          if (playRegister_ == '\0') {
+            error("No previous register");
+            return;
+          }
+
+          key = playRegister_;
+        }
+
+        playRegister(key, n);
+
+        return;
+      }
       case '"': { // set register
         if      (key == '\t') {
           iface_->displayRegisters();
@@ -269,8 +417,7 @@ processCommandChar(const KeyData &keyData)
         else if (key == 'l') {
           setInsertMode(true);
 
-          for (uint i = 0; i < std::max(count_, 1U); ++i)
-            deleteChar();
+          deleteCharsRight(std::max(count_, 1U));
         }
         else {
           uint start_x, start_y;
@@ -297,11 +444,11 @@ processCommandChar(const KeyData &keyData)
       }
       case 'd': { // delete
         if      (key == 'd')
-          deleteLine();
+          deleteLines(getRow(), std::max(count_, 1U));
         else if (key == 'w')
           deleteWord();
         else if (key == 'l')
-          deleteChar();
+          deleteCharsRight(std::max(count_, 1U));
         else {
           uint start_x, start_y;
           getPos(&start_x, &start_y);
@@ -316,6 +463,7 @@ processCommandChar(const KeyData &keyData)
         }
 
         lastCommand_.clear();
+        lastCommand_.addCount(count_);
         lastCommand_.addKey(lastKey_);
         lastCommand_.addKey(key);
 
@@ -332,6 +480,16 @@ processCommandChar(const KeyData &keyData)
         break;
       }
       case 'g': {
+        // move by screen rows (differs from j/k for wrapped lines)
+        if      (key == 'j') {
+          cursorScreenDown(std::max(count_, 1U));
+          break;
+        }
+        else if (key == 'k') {
+          cursorScreenUp(std::max(count_, 1U));
+          break;
+        }
+
         uint x1, y1;
         getPos(&x1, &y1);
 
@@ -423,8 +581,28 @@ processCommandChar(const KeyData &keyData)
           iface_->scrollBottom();
         else if (key == 't')
           iface_->scrollTop();
-        else if (key == 'f') // fold
-          error("Unimplemented");
+        else if (key == 'c') { // fold close
+          if (! closeFold(getRow()))
+            error("No fold found");
+        }
+        else if (key == 'o') { // fold open
+          if (! openFold(getRow()))
+            error("No fold found");
+        }
+        else if (key == 'a') { // fold toggle
+          if (! toggleFold(getRow()))
+            error("No fold found");
+        }
+        else if (key == 'R') // open all folds
+          openAllFolds();
+        else if (key == 'M') { // close all folds
+          if (foldTree_.numFolds() == 0)
+            createAllFolds();
+
+          closeAllFolds();
+        }
+        else if (key == 'E') // remove all folds
+          removeAllFolds();
         else
           error("Unimplemented");
 
@@ -483,7 +661,7 @@ processCommandChar(const KeyData &keyData)
         int end_y = start_y;
 
         if      (key == '>')
-          shiftRight(start_y, end_y);
+          shiftRight(start_y, start_y + std::max(count_, 1U) - 1);
         else {
           bool rc = processMoveChar(keyData, end_x, end_y);
 
@@ -501,12 +679,12 @@ processCommandChar(const KeyData &keyData)
         int end_y = start_y;
 
         if      (key == '<')
-          shiftLeft(start_y, end_y);
+          shiftLeft(start_y, start_y + std::max(count_, 1U) - 1);
         else {
           bool rc = processMoveChar(keyData, end_x, end_y);
 
           if (rc)
-            shiftRight(start_y, end_y);
+            shiftLeft(start_y, end_y);
         }
 
         break;
@@ -543,7 +721,7 @@ processCommandChar(const KeyData &keyData)
       count_ = count_*10 + (key - '0');
 
       //count_str_ += CEvent::keyTypeChar(key);
-      iface_->stateChanged();
+      notifyStateChanged();
 
       return;
     }
@@ -552,7 +730,7 @@ processCommandChar(const KeyData &keyData)
     count_ = count_*10 + (key - '0');
 
     //count_str_ += CEvent::keyTypeChar(key);
-    iface_->stateChanged();
+    notifyStateChanged();
 
     return;
   }
@@ -582,7 +760,8 @@ processNormalChar(const KeyData &keyData)
     case 'h':
     case '\b':
     case int(KeyData::KeyCode::BACKSPACE): {
-      cursorLeft(std::max(count_, 1U));
+      if (! cursorLeft(std::max(count_, 1U)))
+        bell();
 
       break;
     }
@@ -597,7 +776,8 @@ processNormalChar(const KeyData &keyData)
       break;
     }
     case 'j': {
-      cursorDown(std::max(count_, 1U));
+      if (! cursorDown(std::max(count_, 1U)))
+        bell();
 
       break;
     }
@@ -615,7 +795,8 @@ processNormalChar(const KeyData &keyData)
       break;
     }
     case 'k': {
-      cursorUp(std::max(count_, 1U));
+      if (! cursorUp(std::max(count_, 1U)))
+        bell();
 
       break;
     }
@@ -635,7 +816,8 @@ processNormalChar(const KeyData &keyData)
     case 'l':
     case ' ':
     case '\f': {
-      cursorRight(std::max(count_, 1U));
+      if (! cursorRight(std::max(count_, 1U)))
+        bell();
 
       break;
     }
@@ -897,7 +1079,17 @@ processNormalChar(const KeyData &keyData)
             break;
         }
 
-        if      (c == '(')
+        uint x, y, x1, y1;
+
+        getPos(&x, &y);
+
+        // with syntax an unmatched bracket or one in a string or comment
+        // has no match, otherwise scan for the bracket
+        if      (syntax()) {
+          if (findMatchingBracket(y, x, y1, x1))
+            cursorTo(y1, x1);
+        }
+        else if (c == '(')
           findNextChar(')', true);
         else if (c == '[')
           findNextChar(']', true);
@@ -933,8 +1125,8 @@ processNormalChar(const KeyData &keyData)
       break;
 
     case '@': // execute command in buffer
-      error("Unimplemented");
-      break;
+      lastKey_ = key;
+      return;
 
     case '=': // filter through format command
       error("Unimplemented");
@@ -1055,9 +1247,11 @@ processNormalChar(const KeyData &keyData)
     }
 
     case 'J':
-      joinLine();
+      // count is number of lines to join (at least two)
+      joinLines(getRow(), std::max(count_, 2U) - 1);
 
       lastCommand_.clear();
+      lastCommand_.addCount(count_);
       lastCommand_.addKey(key);
 
       break;
@@ -1100,9 +1294,14 @@ processNormalChar(const KeyData &keyData)
 
       break;
 
-    case 'q':
-      error("Unimplemented");
-      break;
+    case 'q': // start/stop recording
+      if (isRecording()) {
+        stopRecording();
+        break;
+      }
+
+      lastKey_ = key;
+      return;
 
     case 'u': // undo last change
       undo();
@@ -1184,12 +1383,7 @@ processNormalChar(const KeyData &keyData)
 
     case 'x':
     case 0x7f /*DEL*/: {
-      startGroup();
-
-      for (uint i = 0; i < std::max(count_, 1U); ++i)
-        deleteChar();
-
-      endGroup();
+      deleteCharsRight(std::max(count_, 1U));
 
       lastCommand_.clear();
       lastCommand_.addCount(count_);
@@ -1198,14 +1392,7 @@ processNormalChar(const KeyData &keyData)
       break;
     }
     case 'X':
-      startGroup();
-
-      for (uint i = 0; i < std::max(count_, 1U); ++i) {
-        cursorLeft(1);
-        deleteChar();
-      }
-
-      endGroup();
+      deleteCharsLeft(std::max(count_, 1U));
 
       lastCommand_.clear();
       lastCommand_.addCount(count_);
@@ -1255,8 +1442,12 @@ processNormalChar(const KeyData &keyData)
       break;
 
     case '.': {
+      ++playDepth_;
+
       lastCommand_.exec(this);
 
+      --playDepth_;
+
       break;
     }
 
@@ -1637,6 +1828,15 @@ processVisualChar(const KeyData &keyData)
         // last visual mode
         if      (key == 'v') {
         }
+        // move by screen rows
+        else if (key == 'j') {
+          cursorScreenDown(std::max(count_, 1U));
+          break;
+        }
+        else if (key == 'k') {
+          cursorScreenUp(std::max(count_, 1U));
+          break;
+        }
         // select next match
         else if (key == 'n') {
           if (hasFindPattern())
@@ -2182,7 +2382,7 @@ setInsertMode(bool insertMode)
 
   insertMode_ = insertMode;
 
-  iface_->stateChanged();
+  notifyStateChanged();
 
   setOverwriteMode(false);
 
@@ -2210,7 +2410,7 @@ setOverwriteMode(bool value)
 
   overwriteMode_ = value;
 
-  iface_->stateChanged();
+  notifyStateChanged();
 }
 
 void
@@ -2222,7 +2422,7 @@ setVisualMode(VisualMode mode)
 
   visual_ = mode;
 
-  iface_->stateChanged();
+  notifyStateChanged();
 }
 
 
@@ -2651,7 +2851,7 @@ setCmdLineMode(bool cmdLineMode, const std::string &str)
     clearSelection();
   }
 
-  iface_->stateChanged();
+  notifyStateChanged();
 }
 
 bool
@@ -2681,9 +2881,19 @@ void
 App::
 error(const std::string &msg) const
 {
+  bell();
+
   std::cerr << "Error: " << msg << "\n";
 }
 
+void
+App::
+bell() const
+{
+  // stops macro playback
+  ++numErrors_;
+}
+
 //---
 
 void
@@ -2702,7 +2912,7 @@ setPos(uint x, uint y)
     cursorPos_.row = y;
     cursorPos_.col = x;
 
-    iface_->positionChanged();
+    notifyPositionChanged();
   }
 }
 
@@ -2760,6 +2970,168 @@ getNumLines() const
   return uint(lines_.size());
 }
 
+uint
+App::
+getTabStop() const
+{
+  return (iface_ ? iface_->getTabStop() : 8);
+}
+
+const CTabMap &
+App::
+lineTabMap(uint line_num) const
+{
+  static CTabMap noTabMap;
+
+  if (line_num >= getNumLines())
+    return noTabMap;
+
+  const auto *line = getLine(line_num);
+
+  if (getListMode())
+    return line->tabMap(2, /*fixed*/true);
+
+  return line->tabMap(getTabStop());
+}
+
+void
+App::
+setListMode(bool value)
+{
+  if (value == listMode_)
+    return;
+
+  listMode_ = value;
+
+  // line display widths changed
+  wrapIndex_.invalidateAll();
+}
+
+//---
+
+void
+App::
+setWrapMode(bool value)
+{
+  wrapMode_ = value;
+}
+
+void
+App::
+setWrapWidth(uint width)
+{
+  // wrapped lines are updated when next used (see wrapRows)
+  wrapIndex_.setWidth(width);
+}
+
+uint
+App::
+wrapRows(uint line_num) const
+{
+  if (! wrapMode_)
+    return 1;
+
+  if (line_num >= getNumLines())
+    return 0;
+
+  if (getTabStop() != wrapTabStop_) {
+    wrapTabStop_ = getTabStop();
+
+    wrapIndex_.invalidateAll();
+  }
+
+  if (! wrapIndex_.isValid(line_num)) {
+    uint rows = 0;
+
+    if (! foldTree_.isHidden(line_num)) {
+      // room for list mode $
+      uint cols = lineTabMap(line_num).numCols() + (getListMode() ? 1 : 0);
+
+      rows = CWrapIndex::colsToRows(cols, wrapIndex_.width());
+    }
+
+    wrapIndex_.setRows(line_num, rows);
+  }
+
+  return wrapIndex_.rows(line_num);
+}
+
+uint
+App::
+getNumScreenRows() const
+{
+  if (! wrapMode_)
+    return getNumRows();
+
+  return wrapIndex_.numRows();
+}
+
+uint
+App::
+lineToScreenRow(uint line_num) const
+{
+  if (! wrapMode_)
+    return lineToRow(line_num);
+
+  // hidden line is shown as its closed fold header
+  if (foldTree_.isHidden(line_num))
+    line_num = rowToLine(lineToRow(line_num));
+
+  return wrapIndex_.lineToRow(line_num);
+}
+
+uint
+App::
+screenRowToLine(uint row, uint &subRow) const
+{
+  if (! wrapMode_) {
+    subRow = 0;
+
+    return rowToLine(row);
+  }
+
+  return wrapIndex_.rowToLine(row, subRow);
+}
+
+uint
+App::
+posToScreenRow(uint line_num, uint char_num, uint &col) const
+{
+  col = lineTabMap(line_num).charToCol(char_num);
+
+  if (! wrapMode_)
+    return lineToRow(line_num);
+
+  uint width = wrapIndex_.width();
+  uint rows  = std::max(wrapRows(line_num), 1U);
+
+  // char past end of full last row stays on last row
+  uint subRow = std::min(col/width, rows - 1);
+
+  col -= subRow*width;
+
+  return lineToScreenRow(line_num) + subRow;
+}
+
+void
+App::
+updateWrapLines(uint line_num1, uint line_num2)
+{
+  uint num_lines = getNumLines();
+
+  for (uint i = line_num1; i <= line_num2 && i < num_lines; ++i) {
+    if (foldTree_.isHidden(i))
+      wrapIndex_.setRows(i, 0);
+    else {
+      // shown line has at least one row (actual rows set when next used)
+      if (wrapIndex_.rows(i) == 0)
+        wrapIndex_.setRows(i, 1);
+
+      wrapIndex_.invalidate(i);
+    }
+  }
+}
+
 bool
 App::
 isLinesEmpty() const
@@ -2838,6 +3210,8 @@ subAddLine(uint line_num, Line *line)
 {
   lines_.addLine(line_num, line);
 
+  lineAdded(line_num);
+
   addUndo(new DeleteLineUndoCmd(this, line_num));
 
   setChanged(true);
@@ -2859,6 +3233,8 @@ subAddChars(uint line_num, uint char_num, const std::string &chars)
 {
   lines_.addLineChars(line_num, char_num, chars);
 
+  lineChanged(line_num);
+
   addUndo(new DeleteCharsUndoCmd(this, line_num, char_num, int(chars.size())));
 
   setChanged(true);
@@ -2884,6 +3260,9 @@ subMoveLine(uint line_num1, int line_num2)
 {
   lines_.moveLine(line_num1, line_num2);
 
+  lineDeleted(line_num1);
+  lineAdded  (line_num2 > int(line_num1) ? line_num2 : line_num2 + 1);
+
   addUndo(new MoveLineUndoCmd(this, line_num2, line_num1 - 1));
 
   setChanged(true);
@@ -2960,12 +3339,41 @@ subDeleteLine(uint line_num)
 
   lines_.deleteLine(line_num);
 
+  lineDeleted(line_num);
+
   addUndo(new AddLineUndoCmd(this, line_num, str));
 
   setChanged(true);
   setUnsaved(true);
 }
 
+void
+App::
+deleteLines(uint line_num, uint n)
+{
+  if (! CASSERT(line_num < getNumLines(), "Invalid Line Num"))
+    return;
+
+  n = std::min(n, getNumLines() - line_num);
+
+  if (n == 0)
+    return;
+
+  startGroup();
+
+  yankLines('\0', line_num, n);
+
+  // keep one empty line if all lines deleted
+  std::vector<std::string> strs;
+
+  if (n == getNumLines())
+    strs.push_back("");
+
+  subReplaceLines(line_num, n, strs);
+
+  endGroup();
+}
+
 void
 App::
 deleteWord()
@@ -3038,8 +3446,7 @@ deleteTo(uint line_num1, uint char_num1, uint line_num2, uint char_num2)
 
     deleteChars(line_num1, char_num1, num);
 
-    for (uint i = 0; i < line_num2 - line_num1 - 1; ++i)
-      deleteLine(line_num1 + i + 1);
+    deleteLines(line_num1 + 1, line_num2 - line_num1 - 1);
 
     cursorDown(1);
 
@@ -3050,8 +3457,7 @@ deleteTo(uint line_num1, uint char_num1, uint line_num2, uint char_num2)
   else if (line_num2 < line_num1) {
     deleteChars(line_num1, 0, char_num1);
 
-    for (uint i = 0; i < line_num1 - line_num2 - 1; ++i)
-      deleteLine(line_num2 + i + 1);
+    deleteLines(line_num2 + 1, line_num1 - line_num2 - 1);
 
     cursorUp(1);
 
@@ -3120,58 +3526,92 @@ deleteChars(uint line_num, uint char_num, uint n)
 
 void
 App::
-subDeleteChars(uint line_num, uint char_num, uint n)
+deleteCharsRight(uint n)
 {
-  const auto *line = getLine(line_num);
-
-  CASSERT(char_num + n <= line->getLength(), "Invalid Number of Chars");
-
-  for (uint i = 0; i < n; ++i) {
-    char c = line->getChar(char_num + i);
-
-    addUndo(new InsertCharUndoCmd(this, line_num, char_num, c));
-  }
+  uint line_num = getRow();
+  uint char_num = getCol();
 
-  lines_.deleteLineChars(line_num, char_num, n);
+  uint len = getLine(line_num)->getLength();
 
-  //fixPos();
+  if (char_num >= len)
+    return;
 
-  setChanged(true);
-  setUnsaved(true);
+  deleteChars(line_num, char_num, std::min(n, len - char_num));
 }
 
-//---
-
 void
 App::
-shiftLeft(uint line_num1, uint line_num2)
+deleteCharsLeft(uint n)
 {
-  if (line_num1 > line_num2)
-    std::swap(line_num1, line_num2);
+  uint line_num = getRow();
+  uint char_num = getCol();
 
-  uint n = getOptions().getShiftWidth();
+  n = std::min(n, char_num);
 
-  startGroup();
+  if (n == 0)
+    return;
+
+  cursorLeft(n);
+
+  deleteChars(line_num, char_num - n, n);
+}
+
+void
+App::
+subDeleteChars(uint line_num, uint char_num, uint n)
+{
+  const auto *line = getLine(line_num);
+
+  CASSERT(char_num + n <= line->getLength(), "Invalid Number of Chars");
+
+  if (n > 0)
+    addUndo(new InsertCharsUndoCmd(this, line_num, char_num,
+                                   line->getSubString(char_num, char_num + n - 1)));
+
+  lines_.deleteLineChars(line_num, char_num, n);
+
+  lineChanged(line_num);
+
+  //fixPos();
+
+  setChanged(true);
+  setUnsaved(true);
+}
+
+//---
+
+void
+App::
+shiftLeft(uint line_num1, uint line_num2)
+{
+  if (line_num1 > line_num2)
+    std::swap(line_num1, line_num2);
+
+  line_num2 = std::min(line_num2, getNumLines() - 1);
+
+  uint n = getOptions().getShiftWidth();
+
+  std::vector<std::string> strs;
+
+  strs.reserve(line_num2 - line_num1 + 1);
 
   for (uint line_num = line_num1; line_num <= line_num2; ++line_num) {
-    auto *line = getLine(line_num);
+    const auto &str = getLine(line_num)->getString();
 
-    uint len = line->getLength();
+    uint len = uint(str.size());
 
     uint n1 = 0;
 
     for (uint j = 0; j < n && j < len; ++j) {
-      char c = line->getChar(j);
-
-      if (! isspace(c)) break;
+      if (! isspace(str[j])) break;
 
       ++n1;
     }
 
-    deleteChars(line_num, 0, n1);
+    strs.push_back(str.substr(n1));
   }
 
-  endGroup();
+  replaceLines(line_num1, uint(strs.size()), strs);
 }
 
 void
@@ -3181,24 +3621,24 @@ shiftRight(uint line_num1, uint line_num2)
   if (line_num1 > line_num2)
     std::swap(line_num1, line_num2);
 
-  std::string chars;
+  line_num2 = std::min(line_num2, getNumLines() - 1);
 
-  uint n = getOptions().getShiftWidth();
+  std::string chars(getOptions().getShiftWidth(), ' ');
 
-  for (uint j = 0; j < n; ++j)
-    chars += " ";
+  std::vector<std::string> strs;
 
-  startGroup();
+  strs.reserve(line_num2 - line_num1 + 1);
 
   for (uint line_num = line_num1; line_num <= line_num2; ++line_num) {
-    auto *line = getLine(line_num);
-
-    if (line->isEmpty()) continue;
+    const auto &str = getLine(line_num)->getString();
 
-    addChars(line_num, 0, chars);
+    if (str.empty())
+      strs.push_back(str);
+    else
+      strs.push_back(chars + str);
   }
 
-  endGroup();
+  replaceLines(line_num1, uint(strs.size()), strs);
 }
 
 //---
@@ -3542,6 +3982,8 @@ subInsertChar(uint line_num, uint char_num, char c)
 
   lines_.addLineChar(line_num, char_num, c);
 
+  lineChanged(line_num);
+
   addUndo(new DeleteCharsUndoCmd(this, line_num, char_num, 1));
 
   setChanged(true);
@@ -3591,6 +4033,8 @@ subReplaceChar(uint line_num, uint char_num, char c)
 
   lines_.replaceLineChar(line_num, char_num, c);
 
+  lineChanged(line_num);
+
   addUndo(new ReplaceCharUndoCmd(this, line_num, char_num, c1));
 
   setChanged(true);
@@ -3627,6 +4071,9 @@ subSplitLine(uint line_num, uint char_num)
 
   lines_.splitLine(line_num, char_num);
 
+  lineChanged(line_num);
+  lineAdded  (line_num + 1);
+
   addUndo(new JoinLineUndoCmd(this, line_num));
 
   setChanged(true);
@@ -3668,11 +4115,95 @@ subJoinLine(uint line_num)
 
   lines_.joinLine(line_num);
 
+  lineChanged(line_num);
+
   addUndo(new SplitLineUndoCmd(this, line_num, len1));
 
   subDeleteLine(line_num + 1);
 }
 
+void
+App::
+joinLines(uint line_num, uint n)
+{
+  if (! CASSERT(line_num < getNumLines(), "Invalid Line Num"))
+    return;
+
+  n = std::min(n, getNumLines() - line_num - 1);
+
+  if (n == 0)
+    return;
+
+  uint len = 0;
+
+  for (uint i = 0; i <= n; ++i)
+    len += getLine(line_num + i)->getLength();
+
+  std::string str;
+
+  str.reserve(len);
+
+  for (uint i = 0; i <= n; ++i)
+    str += getLine(line_num + i)->getString();
+
+  replaceLines(line_num, n + 1, std::vector<std::string>(1, str));
+}
+
+void
+App::
+replaceLines(uint line_num, uint n, const std::vector<std::string> &strs)
+{
+  startGroup();
+
+  subReplaceLines(line_num, n, strs);
+
+  endGroup();
+}
+
+void
+App::
+subReplaceLines(uint line_num, uint n, const std::vector<std::string> &strs)
+{
+  if (! CASSERT(line_num + n <= getNumLines(), "Invalid Line Num"))
+    return;
+
+  ReplaceLinesUndoCmd::Strings oldStrs;
+
+  oldStrs.reserve(n);
+
+  for (uint i = 0; i < n; ++i)
+    oldStrs.push_back(getLine(line_num + i)->getString());
+
+  Lines::LineList lines;
+
+  lines.reserve(strs.size());
+
+  for (const auto &str : strs) {
+    auto *line = new Line;
+
+    line->addChars(0, str);
+
+    lines.push_back(line);
+  }
+
+  lines_.replaceLines(line_num, n, lines);
+
+  uint m = uint(strs.size());
+
+  for (uint i = 0; i < std::min(n, m); ++i)
+    lineChanged(line_num + i);
+
+  if      (n > m)
+    linesDeleted(line_num + m, n - m);
+  else if (m > n)
+    linesAdded(line_num + n, m - n);
+
+  addUndo(new ReplaceLinesUndoCmd(this, line_num, m, oldStrs));
+
+  setChanged(true);
+  setUnsaved(true);
+}
+
 //---
 
 void
@@ -3788,15 +4319,24 @@ cursorUp(uint n, uint *line_num, uint *char_num)
 {
   bool rc = true;
 
+  // move by rows (closed fold is one row) keeping display column
+  uint col = lineTabMap(*line_num).charToCol(*char_num);
+
+  uint row = lineToRow(*line_num);
+
   for (uint i = 0; i < n; ++i) {
-    if (*line_num <= 0) {
+    if (row <= 0) {
       rc = false;
       break;
     }
 
-    --(*line_num);
+    --row;
   }
 
+  *line_num = rowToLine(row);
+
+  *char_num = lineTabMap(*line_num).colToChar(col);
+
   auto *line = getLine(*line_num);
 
   uint line_end = line->getEnd(isExtraLineChar());
@@ -3833,15 +4373,24 @@ cursorDown(uint n, uint *line_num, uint *char_num)
 
   bool rc = true;
 
+  // move by rows (closed fold is one row) keeping display column
+  uint col = lineTabMap(*line_num).charToCol(*char_num);
+
+  uint row = lineToRow(*line_num);
+
   for (uint i = 0; i < n; ++i) {
-    if (*line_num >= getNumLines() - 1) {
+    if (row + 1 >= getNumRows()) {
       rc = false;
       break;
     }
 
-    ++(*line_num);
+    ++row;
   }
 
+  *line_num = rowToLine(row);
+
+  *char_num = lineTabMap(*line_num).colToChar(col);
+
   auto *line = getLine(*line_num);
 
   uint line_end = line->getEnd(isExtraLineChar());
@@ -3852,6 +4401,78 @@ cursorDown(uint n, uint *line_num, uint *char_num)
   return rc;
 }
 
+bool
+App::
+cursorScreenUp(uint n)
+{
+  if (! wrapMode_)
+    return cursorUp(n);
+
+  uint x, y;
+  getPos(&x, &y);
+
+  // move by screen rows keeping column in row
+  uint col;
+
+  uint row = posToScreenRow(y, x, col);
+
+  bool rc = (row >= n);
+
+  row = (rc ? row - n : 0);
+
+  uint subRow;
+
+  y = screenRowToLine(row, subRow);
+  x = lineTabMap(y).colToChar(subRow*getWrapWidth() + col);
+
+  uint line_end = getLine(y)->getEnd(isExtraLineChar());
+
+  setPos(std::min(x, line_end), y);
+
+  if (getVisualMode() != VisualMode::NONE)
+    updateSelectRange();
+
+  return rc;
+}
+
+bool
+App::
+cursorScreenDown(uint n)
+{
+  if (! wrapMode_)
+    return cursorDown(n);
+
+  if (n > 0 && isLinesEmpty())
+    return false;
+
+  uint x, y;
+  getPos(&x, &y);
+
+  // move by screen rows keeping column in row
+  uint col;
+
+  uint row     = posToScreenRow(y, x, col);
+  uint numRows = getNumScreenRows();
+
+  bool rc = (row + n < numRows);
+
+  row = (rc ? row + n : numRows - 1);
+
+  uint subRow;
+
+  y = screenRowToLine(row, subRow);
+  x = lineTabMap(y).colToChar(subRow*getWrapWidth() + col);
+
+  uint line_end = getLine(y)->getEnd(isExtraLineChar());
+
+  setPos(std::min(x, line_end), y);
+
+  if (getVisualMode() != VisualMode::NONE)
+    updateSelectRange();
+
+  return rc;
+}
+
 void
 App::
 cursorToLeft()
@@ -5351,6 +5972,8 @@ subReplace(uint line_num, uint char_num1, uint char_num2, const std::string &rep
 
   lines_.replaceLineChars(line_num, char_num1, char_num2, replaceStr);
 
+  lineChanged(line_num);
+
   char_num2 = char_num1 + uint(replaceStr.size()) - 1;
 
   addUndo(new ReplaceUndoCmd(this, line_num, char_num1, char_num2, old));
@@ -5536,128 +6159,309 @@ resetUndo()
 
 //---
 
-Buffer &
+void
 App::
-getBuffer(char c)
+startRecording(char c)
 {
-  return buffers_[c];
-}
+  // upper case register appends to lower case one
+  char id = char(tolower(c));
 
-//---
+  if (isupper(c))
+    recordKeys_ = macros_[id];
+  else
+    recordKeys_.clear();
 
-bool
-App::
-isWordChar(char c) const
-{
-  return (isalnum(c) || c == '_');
+  recordRegister_ = id;
+
+  notifyStateChanged();
 }
 
-uint
+void
 App::
-getLineEnd(uint line_num) const
+stopRecording()
 {
-  if (line_num >= getNumLines())
-    return 0;
+  if (! isRecording())
+    return;
 
-  const auto *line = getLine(line_num);
+  // remove terminating 'q'
+  if (! recordKeys_.empty())
+    recordKeys_.pop_back();
 
-  uint len = line->getLength();
+  macros_[recordRegister_] = recordKeys_;
 
-  if (len > 0 && ! isExtraLineChar())
-    --len;
+  recordKeys_.clear();
 
-  return len;
-}
+  recordRegister_ = '\0';
 
-//---
+  notifyStateChanged();
+}
 
 bool
 App::
-isSentenceEnd(const Line *line, uint pos, uint *n) const
+playRegister(char c, uint n)
 {
-  *n = 0;
+  // guard against register playing itself forever
+  static const uint MAX_PLAY_DEPTH = 100;
 
-  uint len = line->getLength();
+  char id = char(tolower(c));
 
-  if (pos + *n >= len)
-    return false;
+  auto p = macros_.find(id);
 
-  char c = line->getChar(pos + *n);
+  if (p == macros_.end() || (*p).second.empty()) {
+    error(std::string("Register '") + c + "' is empty");
+    return false;
+  }
 
-  // check for . ! ?
-  if (strchr(".?!", c) == nullptr)
+  if (playDepth_ >= MAX_PLAY_DEPTH) {
+    error("Recursive register");
     return false;
+  }
 
-  (*n)++;
+  playRegister_ = id;
 
-  // skip (, ], " and ' after . ! ?
-  while (pos + *n < len - 1) {
-    char ec = line->getChar(pos + *n);
+  // copy keys as register can be re-recorded while playing
+  auto keys = (*p).second;
 
-    if (strchr(")]\"\'", ec) == nullptr)
-      break;
+  auto t1 = std::chrono::steady_clock::now();
 
-    (*n)++;
-  }
+  uint numErrors = numErrors_;
+  uint numKeys   = 0;
 
-  // EOL is ok
-  if (pos + *n >= len)
-    return true;
+  ++playDepth_;
 
-  c = line->getChar(pos + *n);
+  startBatch();
 
-  // space is ok
-  if (isspace(c))
-    return true;
+  // one undo step for whole playback (undo group only as App::startGroup
+  // collects deleted text which would hide yanks from later keys)
+  undo_.startGroup();
 
-  return false;
-}
+  addUndo(new MoveToUndoCmd(this, getRow(), getCol()));
 
-bool
-App::
-isSection(const Line *line, uint, uint *n) const
-{
-  uint len = line->getLength();
+  // stop on first error (like vim)
+  for (uint i = 0; i < n && numErrors_ == numErrors; ++i) {
+    for (const auto &keyData : keys) {
+      processChar(keyData);
 
-  if (len > 0 && line->getChar(0) == '{') {
-    *n = 0;
-    return true;
+      ++numKeys;
+
+      if (numErrors_ != numErrors)
+        break;
+    }
   }
 
-  return false;
-}
+  undo_.endGroup();
 
-bool
-App::
-isBlank(const Line *line) const
-{
-  uint len = line->getLength();
+  --playDepth_;
 
-  for (uint i = 0; i < len; ++i) {
-    char c = line->getChar(i);
+  // only report outermost playback (state notify is sent with batch ones)
+  if (playDepth_ == 0) {
+    auto t2 = std::chrono::steady_clock::now();
 
-    if (! isspace(c))
-      return false;
+    playKeys_ = numKeys;
+    playSecs_ = std::chrono::duration<double>(t2 - t1).count();
+
+    notifyStateChanged();
   }
 
-  return true;
+  endBatch();
+
+  return (numErrors_ == numErrors);
 }
 
-bool
+double
 App::
-findNext(const Line *line, const std::string &pattern, int char_num1, int char_num2,
-         uint *char_num) const
+getPlayRate() const
 {
-  if (line->isEmpty())
-    return false;
+  if (playSecs_ <= 0.0)
+    return 0.0;
 
-  uint num_chars = line->getLength();
+  return playKeys_/playSecs_;
+}
 
-  if (char_num1 >= int(num_chars))
-    return false;
+void
+App::
+startBatch()
+{
+  ++batchDepth_;
+}
 
-  if (char_num2 < 0)
-    char_num2 = num_chars - 1;
+void
+App::
+endBatch()
+{
+  assert(batchDepth_ > 0);
+
+  if (--batchDepth_ > 0)
+    return;
+
+  uint flags = batchFlags_;
+
+  batchFlags_ = 0;
+
+  if (flags & BATCH_STATE)
+    iface_->stateChanged();
+
+  if (flags & BATCH_POSITION)
+    iface_->positionChanged();
+
+  if (flags & BATCH_SELECTION)
+    iface_->selectionChanged();
+}
+
+void
+App::
+notifyStateChanged()
+{
+  if (inBatch())
+    batchFlags_ |= BATCH_STATE;
+  else
+    iface_->stateChanged();
+}
+
+void
+App::
+notifyPositionChanged()
+{
+  if (inBatch())
+    batchFlags_ |= BATCH_POSITION;
+  else
+    iface_->positionChanged();
+}
+
+void
+App::
+notifySelectionChanged()
+{
+  if (inBatch())
+    batchFlags_ |= BATCH_SELECTION;
+  else
+    iface_->selectionChanged();
+}
+
+//---
+
+Buffer &
+App::
+getBuffer(char c)
+{
+  return buffers_[c];
+}
+
+//---
+
+bool
+App::
+isWordChar(char c) const
+{
+  return (isalnum(c) || c == '_');
+}
+
+uint
+App::
+getLineEnd(uint line_num) const
+{
+  if (line_num >= getNumLines())
+    return 0;
+
+  const auto *line = getLine(line_num);
+
+  uint len = line->getLength();
+
+  if (len > 0 && ! isExtraLineChar())
+    --len;
+
+  return len;
+}
+
+//---
+
+bool
+App::
+isSentenceEnd(const Line *line, uint pos, uint *n) const
+{
+  *n = 0;
+
+  uint len = line->getLength();
+
+  if (pos + *n >= len)
+    return false;
+
+  char c = line->getChar(pos + *n);
+
+  // check for . ! ?
+  if (strchr(".?!", c) == nullptr)
+    return false;
+
+  (*n)++;
+
+  // skip (, ], " and ' after . ! ?
+  while (pos + *n < len - 1) {
+    char ec = line->getChar(pos + *n);
+
+    if (strchr(")]\"\'", ec) == nullptr)
+      break;
+
+    (*n)++;
+  }
+
+  // EOL is ok
+  if (pos + *n >= len)
+    return true;
+
+  c = line->getChar(pos + *n);
+
+  // space is ok
+  if (isspace(c))
+    return true;
+
+  return false;
+}
+
+bool
+App::
+isSection(const Line *line, uint, uint *n) const
+{
+  uint len = line->getLength();
+
+  if (len > 0 && line->getChar(0) == '{') {
+    *n = 0;
+    return true;
+  }
+
+  return false;
+}
+
+bool
+App::
+isBlank(const Line *line) const
+{
+  uint len = line->getLength();
+
+  for (uint i = 0; i < len; ++i) {
+    char c = line->getChar(i);
+
+    if (! isspace(c))
+      return false;
+  }
+
+  return true;
+}
+
+bool
+App::
+findNext(const Line *line, const std::string &pattern, int char_num1, int char_num2,
+         uint *char_num) const
+{
+  if (line->isEmpty())
+    return false;
+
+  uint num_chars = line->getLength();
+
+  if (char_num1 >= int(num_chars))
+    return false;
+
+  if (char_num2 < 0)
+    char_num2 = num_chars - 1;
 
   const char *cline = line->getCString();
 
@@ -5798,175 +6602,892 @@ getSelectEnd(int *row, int *col) const
     *col = -1;
   }
 
-  return selection_.set;
+  return selection_.set;
+}
+
+void
+App::
+setSelectRange(int row1, int col1, int row2, int col2)
+{
+  selection_.set = true;
+
+  selection_.row1 = row1;
+  selection_.col1 = col1;
+  selection_.row2 = row2;
+  selection_.col2 = col2;
+
+  notifySelectionChanged();
+}
+
+void
+App::
+clearSelection()
+{
+  lastSelection_ = selection_;
+
+  selection_.set = false;
+
+  notifySelectionChanged();
+}
+
+void
+App::
+rangeSelect(int row1, int col1, int row2, int col2, bool select)
+{
+  selection_.set = select;
+
+  selection_.row1 = row1;
+  selection_.col1 = col1;
+  selection_.row2 = row2;
+  selection_.col2 = col2;
+
+  notifySelectionChanged();
+}
+
+//---
+
+bool
+App::
+runEdCmd(const std::string &str, bool &quitted)
+{
+  //std::cerr << "Run Ed Cmd '" << str << "'\n";
+
+  quitted = false;
+
+  bool rc = true;
+
+  std::vector<std::string> words;
+
+  CStrUtil::toWords(str, words);
+
+  uint num_words = uint(words.size());
+
+  auto cmd = (num_words > 0 ? words[0] : std::string());
+
+  if (cmd == "exit" || cmd == "quit") {
+    quitted = true;
+  }
+  else {
+    rc = ed_->execCmd(str);
+
+    if (rc)
+      quitted = ed_->isQuit();
+  }
+
+  return rc;
+}
+
+void
+App::
+setNameValue(const std::string &name, const std::string &value)
+{
+  if      (name == "list") {
+    if (value == "1")
+      setListMode(true);
+  }
+  else if (name == "nolist") {
+    if (value == "1")
+      setListMode(false);
+  }
+  else if (name == "number") {
+    if (value == "1")
+      setNumberMode(true);
+  }
+  else if (name == "nonumber") {
+    if (value == "1")
+      setNumberMode(false);
+  }
+  else if (name == "wrap") {
+    if (value == "1")
+      setWrapMode(true);
+  }
+  else if (name == "nowrap") {
+    if (value == "1")
+      setWrapMode(false);
+  }
+  else if (name == "ignorecase") {
+    if (value == "1")
+      setCaseSensitive(false);
+  }
+  else if (name == "noignorecase") {
+    if (value == "1")
+      setCaseSensitive(true);
+  }
+  else if (name == "syntax") {
+    if      (value == "c")
+      setSyntax(new CSyntaxC);
+    else if (value == "cpp")
+      setSyntax(new CSyntaxCPP);
+    else if (value != "") {
+      // language definition file <syntaxdir>/<value>.syn (syntaxdir defaults
+      // to $CVI_SYNTAX_DIR)
+      std::string dir;
+
+      auto p = nameValues_.find("syntaxdir");
+
+      if      (p != nameValues_.end())
+        dir = (*p).second;
+      else if (getenv("CVI_SYNTAX_DIR"))
+        dir = getenv("CVI_SYNTAX_DIR");
+
+      std::string msg;
+
+      auto *syntax = CSyntaxGeneric::load((dir != "" ? dir + "/" : "") + value + ".syn", msg);
+
+      if (! syntax)
+        error(msg);
+
+      setSyntax(syntax);
+    }
+    else
+      setSyntax(nullptr);
+  }
+
+  nameValues_[name] = value;
+
+  notifyStateChanged();
+}
+
+void
+App::
+setSyntax(CSyntax *syntax)
+{
+  if (syntaxWorker_)
+    syntaxWorker_->cancel();
+
+  delete syntax_;
+
+  syntax_ = syntax;
+
+  if (syntax_) {
+    if (! syntaxBrackets_)
+      syntaxBrackets_ = std::make_unique<CSyntaxBrackets>();
+
+    syntaxBrackets_->reset(getNumLines());
+
+    // visible lines are highlighted on next draw, the rest in background
+    invalidateSyntax();
+  }
+  else {
+    syntaxBrackets_.reset();
+
+    for (auto *line : lines_)
+      line->clearAnnotations();
+  }
+}
+
+void
+App::
+invalidateSyntax()
+{
+  ++syntaxGen_;
+
+  uint num_lines = getNumLines();
+
+  for (uint i = 0; i < num_lines; ++i)
+    invalidateSyntaxLine(i);
+}
+
+void
+App::
+updateSyntax()
+{
+  if (! syntax_ || syntaxLine1_ < 0) return;
+
+  // synchronous update supersedes any background one
+  if (syntaxWorker_)
+    syntaxWorker_->cancel();
+
+  int numLines = getNumLines();
+
+  int lineNum1 = std::min(syntaxLine1_, numLines);
+  int lineNum2 = std::min(syntaxLine2_, numLines - 1);
+
+  syntaxLine1_ = -1;
+  syntaxLine2_ = -1;
+
+  SyntaxNotifier notifier(syntaxBrackets_.get());
+
+  syntax_->setNotifier(&notifier);
+
+  // restart lexer from end state of the line before the first changed line
+  if (lineNum1 > 0) {
+    auto *line = lines_.getLine(lineNum1 - 1);
+
+    syntax_->setState(uint(std::max(line->getSyntaxState(), 0)));
+  }
+  else {
+    syntax_->init();
+
+    syntax_->setState(0);
+  }
+
+  // re-lex changed lines, continuing past the changed range until the new
+  // end state matches the stored one (later lines are then unaffected)
+  SyntaxLines lines(this, notifier, lineNum1, lineNum2, numLines);
+
+  syntax_->parse(lines);
+
+  if (lines.lineNum() >= numLines)
+    syntax_->term();
+
+  syntax_->setNotifier(nullptr);
+}
+
+void
+App::
+updateSyntax(int lineNum1, int lineNum2)
+{
+  if (! syntax_) return;
+
+  applySyntaxResults();
+
+  int numLines = getNumLines();
+
+  // pending range may end past lines since deleted
+  if (syntaxLine2_ >= numLines) {
+    syntaxLine2_ = numLines - 1;
+
+    if (syntaxLine1_ > syntaxLine2_) {
+      syntaxLine1_ = -1;
+      syntaxLine2_ = -1;
+    }
+  }
+
+  if (syntaxLine1_ < 0) {
+    // worker (same generation) may still be carrying a changed state past
+    // the pending range
+    if (syntaxWorker_ && syntaxWorker_->isBusy())
+      iface_->syntaxPending();
+
+    return;
+  }
+
+  lineNum1 = std::max(lineNum1, 0);
+  lineNum2 = std::min(lineNum2, numLines - 1);
+
+  // lex pending lines in window (priority over background)
+  int lineNum = std::max(lineNum1, syntaxLine1_);
+
+  if (lineNum <= lineNum2) {
+    SyntaxNotifier notifier(syntaxBrackets_.get());
+
+    syntax_->setNotifier(&notifier);
+
+    // start state is exact if previous line is before pending range (valid
+    // lines inside it may be stale), otherwise guess from its old state and
+    // only show result until background catches up
+    bool exact = (lineNum == syntaxLine1_);
+
+    if (lineNum > 0) {
+      auto *line = lines_.getLine(lineNum - 1);
+
+      syntax_->setState(uint(std::max(line->getSyntaxState(), 0)));
+    }
+    else {
+      syntax_->init();
+
+      syntax_->setState(0);
+    }
+
+    SyntaxLines lines(this, notifier, lineNum, lineNum2, lineNum2 + 1, exact);
+
+    syntax_->parse(lines);
+
+    syntax_->setNotifier(nullptr);
+
+    // changed end state must propagate past window
+    if (lines.isExact() && lines.isCarry() && lines.lineNum() < numLines)
+      invalidateSyntaxLine(lines.lineNum());
+
+    // drop leading lines now up to date from pending range
+    while (syntaxLine1_ >= 0 && syntaxLine1_ <= syntaxLine2_ &&
+           lines_.getLine(syntaxLine1_)->getSyntaxValid())
+      ++syntaxLine1_;
+
+    if (syntaxLine1_ > syntaxLine2_) {
+      syntaxLine1_ = -1;
+      syntaxLine2_ = -1;
+    }
+  }
+
+  if (syntaxLine1_ < 0) {
+    // worker (same generation) may still be carrying a changed state past
+    // the pending range
+    if (syntaxWorker_ && syntaxWorker_->isBusy())
+      iface_->syntaxPending();
+
+    return;
+  }
+
+  // lex remaining lines in background (restart if lines changed since start)
+  if (! syntaxWorker_ || ! syntaxWorker_->isBusy() ||
+      syntaxWorker_->generation() != syntaxGen_)
+    startSyntaxWorker();
+
+  if (syntaxWorker_ && syntaxWorker_->isBusy())
+    iface_->syntaxPending();
+}
+
+bool
+App::
+findMatchingBracket(uint line_num, uint char_num, uint &line_num1, uint &char_num1)
+{
+  if (! syntax_ || ! syntaxBrackets_)
+    return false;
+
+  int numLines = getNumLines();
+
+  if (int(line_num) >= numLines)
+    return false;
+
+  // lines before pending range are lexed (and indexed) exactly
+  auto lexedLines = [&]() { return (syntaxLine1_ < 0 ? numLines : syntaxLine1_); };
+
+  // lex up to bracket's line only
+  if (lexedLines() <= int(line_num))
+    updateSyntax(syntaxLine1_, int(line_num));
+
+  // bracket in string or comment is not indexed so has no match
+  const auto &brackets = syntaxBrackets_->lineBrackets(line_num);
+
+  auto p = std::find_if(brackets.begin(), brackets.end(),
+                        [&](const CSyntaxBrackets::Bracket &bracket) {
+                          return bracket.col == char_num;
+                        });
+
+  if (p == brackets.end())
+    return false;
+
+  // close bracket's match is before it (in lexed lines)
+  if (! strchr("([{", p->c))
+    return syntaxBrackets_->findMatch(line_num, char_num, line_num1, char_num1);
+
+  // open bracket's match is after it : lex increasing regions after the
+  // bracket until the match is in lexed lines (or all lines are lexed)
+  int lineNum2 = int(line_num);
+  int region   = 256;
+
+  while (true) {
+    bool found = syntaxBrackets_->findMatch(line_num, char_num, line_num1, char_num1);
+
+    if (found && int(line_num1) < lexedLines())
+      return true;
+
+    if (lexedLines() >= numLines)
+      return false;
+
+    lineNum2 = std::min(lineNum2 + region, numLines - 1);
+
+    region *= 2;
+
+    updateSyntax(syntaxLine1_, lineNum2);
+  }
+}
+
+bool
+App::
+createFold(uint line_num, bool closed)
+{
+  uint line_num2;
+
+  if (! getFoldRange(line_num, line_num2))
+    return false;
+
+  return foldTree_.addFold(line_num, line_num2, closed);
+}
+
+void
+App::
+createAllFolds()
+{
+  uint num_lines = getNumLines();
+
+  auto p = nameValues_.find("foldmethod");
+
+  if (p != nameValues_.end() && (*p).second == "syntax") {
+    for (uint i = 0; i < num_lines; ++i) {
+      uint line_num2;
+
+      if (getFoldRange(i, line_num2))
+        (void) foldTree_.addFold(i, line_num2);
+    }
+
+    return;
+  }
+
+  // indent : single pass with stack of fold headers. Header's fold ends at
+  // last non blank line before next line indented no more than it
+  struct Header {
+    uint line_num;
+    int  indent;
+  };
+
+  std::vector<Header> headers;
+
+  uint last_line = 0;
+
+  for (uint i = 0; i < num_lines; ++i) {
+    int indent;
+
+    if (! lineIndent(i, indent))
+      continue;
+
+    while (! headers.empty() && headers.back().indent >= indent) {
+      if (last_line > headers.back().line_num)
+        (void) foldTree_.addFold(headers.back().line_num, last_line);
+
+      headers.pop_back();
+    }
+
+    headers.push_back({i, indent});
+
+    last_line = i;
+  }
+
+  for ( ; ! headers.empty(); headers.pop_back()) {
+    if (last_line > headers.back().line_num)
+      (void) foldTree_.addFold(headers.back().line_num, last_line);
+  }
+}
+
+bool
+App::
+getFoldRange(uint line_num, uint &line_num2) const
+{
+  if (line_num >= getNumLines())
+    return false;
+
+  // syntax : first open bracket on line closed on later line
+  auto p = nameValues_.find("foldmethod");
+
+  if (p != nameValues_.end() && (*p).second == "syntax") {
+    if (! syntaxBrackets_)
+      return false;
+
+    auto *th = const_cast<App *>(this);
+
+    // lex up to line only (match lexes on to its close bracket)
+    if (syntaxLine1_ >= 0 && syntaxLine1_ <= int(line_num))
+      th->updateSyntax(syntaxLine1_, int(line_num));
+
+    // copy as matching may update line's brackets
+    auto brackets = syntaxBrackets_->lineBrackets(line_num);
+
+    for (const auto &bracket : brackets) {
+      if (bracket.c != '(' && bracket.c != '[' && bracket.c != '{') continue;
+
+      uint match_line, match_col;
+
+      if (th->findMatchingBracket(line_num, bracket.col, match_line, match_col) &&
+          match_line > line_num) {
+        line_num2 = match_line;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // indent : following lines indented more than line (ignoring blank lines)
+  int indent;
+
+  if (! lineIndent(line_num, indent))
+    return false;
+
+  uint num_lines = getNumLines();
+
+  line_num2 = line_num;
+
+  for (uint i = line_num + 1; i < num_lines; ++i) {
+    int indent1;
+
+    if (! lineIndent(i, indent1))
+      continue;
+
+    if (indent1 <= indent)
+      break;
+
+    line_num2 = i;
+  }
+
+  return (line_num2 > line_num);
+}
+
+bool
+App::
+lineIndent(uint line_num, int &indent) const
+{
+  int tabStop = int(getTabStop());
+
+  indent = 0;
+
+  for (auto c : getLine(line_num)->chars()) {
+    if      (c == ' ' ) ++indent;
+    else if (c == '\t') indent += tabStop - (indent % tabStop);
+    else                return true;
+  }
+
+  return false; // blank
+}
+
+bool
+App::
+openFold(uint line_num)
+{
+  // lines shown by fold are in hidden lines after closed fold header
+  uint line_num1 = rowToLine(lineToRow(line_num));
+  uint line_num2 = foldTree_.nextVisibleLine(line_num1);
+
+  if (! foldTree_.openFold(line_num))
+    return false;
+
+  updateWrapLines(line_num1 + 1, line_num2 - 1);
+
+  foldsChanged();
+
+  return true;
+}
+
+bool
+App::
+closeFold(uint line_num)
+{
+  // create fold for line's region if no fold starts at line
+  uint line_num1, line_num2;
+  bool closed;
+
+  if (! foldTree_.foldAt(line_num, line_num1, line_num2, closed) || line_num1 != line_num)
+    (void) createFold(line_num, false);
+
+  if (! foldTree_.closeFold(line_num))
+    return false;
+
+  // lines hidden by fold follow its header
+  uint header = rowToLine(lineToRow(line_num));
+
+  updateWrapLines(header + 1, foldTree_.nextVisibleLine(header) - 1);
+
+  foldsChanged();
+
+  return true;
+}
+
+bool
+App::
+toggleFold(uint line_num)
+{
+  uint lines;
+
+  if (foldTree_.isClosedFold(line_num, lines))
+    return openFold(line_num);
+  else
+    return closeFold(line_num);
+}
+
+void
+App::
+openAllFolds()
+{
+  // lines hidden by closed folds are shown
+  CFoldTree::Ranges ranges;
+
+  foldTree_.foldBodies(ranges, true);
+
+  foldTree_.openAllFolds();
+
+  for (const auto &range : ranges)
+    updateWrapLines(range.first, range.second);
+
+  foldsChanged();
+}
+
+void
+App::
+closeAllFolds()
+{
+  // lines in fold bodies may be hidden
+  CFoldTree::Ranges ranges;
+
+  foldTree_.foldBodies(ranges);
+
+  foldTree_.closeAllFolds();
+
+  for (const auto &range : ranges)
+    updateWrapLines(range.first, range.second);
+
+  foldsChanged();
 }
 
 void
 App::
-setSelectRange(int row1, int col1, int row2, int col2)
+removeAllFolds()
 {
-  selection_.set = true;
+  // lines hidden by closed folds are shown
+  CFoldTree::Ranges ranges;
 
-  selection_.row1 = row1;
-  selection_.col1 = col1;
-  selection_.row2 = row2;
-  selection_.col2 = col2;
+  foldTree_.foldBodies(ranges, true);
+
+  foldTree_.removeAllFolds();
 
-  iface_->selectionChanged();
+  for (const auto &range : ranges)
+    updateWrapLines(range.first, range.second);
+
+  foldsChanged();
 }
 
 void
 App::
-clearSelection()
+foldsChanged()
 {
-  lastSelection_ = selection_;
+  // move cursor from hidden line to its closed fold header
+  uint x, y;
+  getPos(&x, &y);
 
-  selection_.set = false;
+  if (foldTree_.isHidden(y)) {
+    setPos(x, rowToLine(lineToRow(y)));
+
+    fixPos();
+  }
 
-  iface_->selectionChanged();
+  notifyStateChanged();
 }
 
 void
 App::
-rangeSelect(int row1, int col1, int row2, int col2, bool select)
+startSyntaxWorker()
 {
-  selection_.set = select;
+  if (! syntaxWorker_)
+    syntaxWorker_ = std::make_unique<CSyntaxWorker>();
 
-  selection_.row1 = row1;
-  selection_.col1 = col1;
-  selection_.row2 = row2;
-  selection_.col2 = col2;
+  int numLines = getNumLines();
 
-  iface_->selectionChanged();
-}
+  int lineNum1 = std::min(syntaxLine1_, numLines);
+  int lineNum2 = std::min(syntaxLine2_, numLines - 1);
 
-//---
+  // lines before pending range are up to date so state is exact
+  uint state = 0;
 
-bool
+  if (lineNum1 > 0)
+    state = uint(std::max(lines_.getLine(lineNum1 - 1)->getSyntaxState(), 0));
+
+  // snapshot bounded batch of lines from start of pending range (worker is
+  // continued with next batch if state still carries at its end)
+  int numSnapshot = std::min(numLines - lineNum1,
+                             int(syntaxWorker_->snapshotLines(syntaxGen_)));
+
+  CSyntaxWorker::Lines lines;
+
+  lines.resize(numSnapshot);
+
+  for (int i = lineNum1; i < lineNum1 + numSnapshot; ++i) {
+    auto *line = lines_.getLine(i);
+
+    auto &line1 = lines[i - lineNum1];
+
+    line1.str   = line->chars();
+    line1.state = line->getSyntaxState();
+    line1.valid = line->getSyntaxValid();
+  }
+
+  // fall back to synchronous update if lexer can't be run in background
+  if (! syntaxWorker_->start(*syntax_, syntaxGen_, lineNum1, state,
+                             std::move(lines), lineNum2, numLines))
+    updateSyntax();
+}
+
+void
 App::
-runEdCmd(const std::string &str, bool &quitted)
+applySyntaxResults()
 {
-  //std::cerr << "Run Ed Cmd '" << str << "'\n";
+  if (! syntaxWorker_ || ! syntaxWorker_->isBusy())
+    return;
 
-  quitted = false;
+  // results for old line contents are discarded
+  if (syntaxWorker_->generation() != syntaxGen_) {
+    syntaxWorker_->cancel();
+    return;
+  }
 
-  bool rc = true;
+  CSyntaxWorker::Results results;
 
-  std::vector<std::string> words;
+  uint endLine = 0;
+  bool carry   = false;
 
-  CStrUtil::toWords(str, words);
+  bool done = syntaxWorker_->takeResults(results, endLine, carry);
 
-  uint num_words = uint(words.size());
+  for (const auto &result : results) {
+    auto *line = lines_.getLine(result.line_num);
 
-  auto cmd = (num_words > 0 ? words[0] : std::string());
+    line->clearAnnotations();
 
-  if (cmd == "exit" || cmd == "quit") {
-    quitted = true;
+    for (const auto &span : result.spans)
+      line->addAnnotation(span.start, span.start + span.len - 1, span.token);
+
+    syntaxBrackets_->setLine(result.line_num, line->chars(), result.spans);
+
+    line->setSyntaxState(int(result.state));
+    line->setSyntaxValid(true);
   }
-  else {
-    rc = ed_->execCmd(str);
 
-    if (rc)
-      quitted = ed_->isQuit();
+  // lines before end line are now up to date
+  if (done && syntaxLine1_ >= 0) {
+    syntaxLine1_ = std::max(syntaxLine1_, int(endLine));
+
+    if (syntaxLine1_ > syntaxLine2_) {
+      syntaxLine1_ = -1;
+      syntaxLine2_ = -1;
+    }
   }
 
-  return rc;
+  // end of batch not converged so continue from it
+  if (done && carry && int(endLine) < getNumLines())
+    invalidateSyntaxLine(endLine);
 }
 
 void
 App::
-setNameValue(const std::string &name, const std::string &value)
+lineAdded(uint line_num)
 {
-  if      (name == "list") {
-    if (value == "1")
-      setListMode(true);
-  }
-  else if (name == "nolist") {
-    if (value == "1")
-      setListMode(false);
-  }
-  else if (name == "number") {
-    if (value == "1")
-      setNumberMode(true);
-  }
-  else if (name == "nonumber") {
-    if (value == "1")
-      setNumberMode(false);
-  }
-  else if (name == "ignorecase") {
-    if (value == "1")
-      setCaseSensitive(false);
-  }
-  else if (name == "noignorecase") {
-    if (value == "1")
-      setCaseSensitive(true);
-  }
-  else if (name == "syntax") {
-    if      (value == "c")
-      setSyntax(new CSyntaxC);
-    else if (value == "cpp")
-      setSyntax(new CSyntaxCPP);
-    else
-      setSyntax(nullptr);
-  }
+  ++syntaxGen_;
 
-  nameValues_[name] = value;
+  // shift pending range for inserted line
+  if (syntaxLine1_ >= int(line_num)) ++syntaxLine1_;
+  if (syntaxLine2_ >= int(line_num)) ++syntaxLine2_;
 
-  iface_->stateChanged();
+  if (syntaxBrackets_)
+    syntaxBrackets_->addLine(line_num);
+
+  foldTree_.addLine(line_num);
+
+  // new line in closed fold body has no rows
+  wrapIndex_.addLine(line_num, foldTree_.isHidden(line_num) ? 0 : 1);
+
+  invalidateSyntaxLine(line_num);
 }
 
 void
 App::
-setSyntax(CSyntax *syntax)
+lineDeleted(uint line_num)
 {
-  delete syntax_;
+  ++syntaxGen_;
 
-  syntax_ = syntax;
+  // shift pending range for removed line
+  if (syntaxLine1_ > int(line_num)) --syntaxLine1_;
+  if (syntaxLine2_ > int(line_num)) --syntaxLine2_;
 
-  if (syntax_) {
-    class Notifier : public CSyntaxNotifier {
-     public:
-      Notifier(App *app) :
-       app_(app) {
-      }
+  if (syntaxBrackets_)
+    syntaxBrackets_->deleteLine(line_num);
 
-      App *app() const { return app_; }
+  uint fold_line1, fold_line2;
 
-      void setLine(Line *line) {
-        line_ = line;
-      }
+  bool shown = foldTree_.deleteLine(line_num, fold_line1, fold_line2);
 
-      void addToken(uint, uint word_start, const std::string &word, CSyntaxToken token) override {
-        line_->addAnnotation(word_start, int(word_start + word.size() - 1), token);
-      }
+  wrapIndex_.deleteLine(line_num);
 
-     private:
-      App*  app_  { nullptr };
-      Line* line_ { nullptr };
-    };
+  // body of removed closed fold is shown
+  if (shown)
+    updateWrapLines(fold_line1, fold_line2);
 
-    //---
+  // next line now follows a different line so its start state may change
+  if (line_num < getNumLines())
+    invalidateSyntaxLine(line_num);
+}
 
-    Notifier notifier(this);
+void
+App::
+linesAdded(uint line_num, uint n)
+{
+  if (n == 0)
+    return;
 
-    syntax_->init();
+  ++syntaxGen_;
 
-    syntax_->setNotifier(&notifier);
+  // shift pending range for inserted lines
+  if (syntaxLine1_ >= int(line_num)) syntaxLine1_ += n;
+  if (syntaxLine2_ >= int(line_num)) syntaxLine2_ += n;
 
-    for (auto *line : lines_) {
-      notifier.setLine(line);
+  for (uint i = 0; i < n; ++i) {
+    uint line_num1 = line_num + i;
 
-      line->clearAnnotations();
+    if (syntaxBrackets_)
+      syntaxBrackets_->addLine(line_num1);
 
-      syntax_->processLine(line->chars());
-    }
+    foldTree_.addLine(line_num1);
 
-    syntax_->term();
+    wrapIndex_.addLine(line_num1, foldTree_.isHidden(line_num1) ? 0 : 1);
   }
-  else {
-    for (auto *line : lines_)
-      line->clearAnnotations();
+
+  invalidateSyntaxLine(line_num);
+  invalidateSyntaxLine(line_num + n - 1);
+}
+
+void
+App::
+linesDeleted(uint line_num, uint n)
+{
+  if (n == 0)
+    return;
+
+  ++syntaxGen_;
+
+  // shift pending range for removed lines (range in removed lines moves to line_num)
+  int line_num1 = int(line_num);
+  int line_num2 = int(line_num + n);
+
+  if      (syntaxLine1_ >= line_num2) syntaxLine1_ -= n;
+  else if (syntaxLine1_ >  line_num1) syntaxLine1_  = line_num1;
+
+  if      (syntaxLine2_ >= line_num2) syntaxLine2_ -= n;
+  else if (syntaxLine2_ >  line_num1) syntaxLine2_  = line_num1;
+
+  // body lines of removed closed folds (line_num to shown_line2) are shown
+  int shown_line2 = -1;
+
+  for (uint i = 0; i < n; ++i) {
+    if (syntaxBrackets_)
+      syntaxBrackets_->deleteLine(line_num);
+
+    if (shown_line2 >= line_num1)
+      --shown_line2;
+
+    uint fold_line1, fold_line2;
+
+    if (foldTree_.deleteLine(line_num, fold_line1, fold_line2))
+      shown_line2 = std::max(shown_line2, int(fold_line2));
+
+    wrapIndex_.deleteLine(line_num);
   }
+
+  if (shown_line2 >= line_num1)
+    updateWrapLines(line_num, uint(shown_line2));
+
+  if (line_num < getNumLines())
+    invalidateSyntaxLine(line_num);
+}
+
+void
+App::
+lineChanged(uint line_num)
+{
+  ++syntaxGen_;
+
+  wrapIndex_.invalidate(line_num);
+
+  invalidateSyntaxLine(line_num);
+}
+
+void
+App::
+invalidateSyntaxLine(uint line_num)
+{
+  auto *line = lines_.getLine(line_num);
+
+  if (line)
+    line->setSyntaxValid(false);
+
+  if (syntaxLine1_ < 0 || int(line_num) < syntaxLine1_) syntaxLine1_ = line_num;
+  if (syntaxLine2_ < 0 || int(line_num) > syntaxLine2_) syntaxLine2_ = line_num;
 }
 
 //------
@@ -6168,14 +7689,33 @@ deleteLine(uint line_num)
     lines_[i]->setChanged(true);
 }
 
+void
+Lines::
+replaceLines(uint line_num, uint n, const LineList &lines)
+{
+  auto p = lines_.begin() + line_num;
+
+  for (uint i = 0; i < n; ++i)
+    delete p[i];
+
+  p = lines_.erase(p, p + n);
+
+  lines_.insert(p, lines.begin(), lines.end());
+
+  // following lines only move if line count changed
+  uint line_num2 = uint(n != lines.size() ? lines_.size() : line_num + lines.size());
+
+  for (uint i = line_num; i < line_num2; ++i)
+    lines_[i]->setChanged(true);
+}
+
 void
 Lines::
 deleteLineChars(uint line_num, uint char_num, uint n)
 {
   auto *line = lines_[line_num];
 
-  for (uint i = 0; i < n; ++i)
-    line->deleteChar(char_num);
+  line->deleteChars(char_num, n);
 
   line->setChanged(true);
 }
@@ -6206,6 +7746,8 @@ operator=(const Line &line)
   chars_   = line.chars_;
   changed_ = true;
 
+  tabMap_.reset();
+
   return *this;
 }
 
@@ -6241,6 +7783,8 @@ addChars(uint pos, const std::string &chars)
   //for (uint i = pos; i < new_len; ++i)
   //  chars_[i]->setChanged(true);
 
+  tabMap_.reset();
+
   setChanged(true);
 }
 
@@ -6298,6 +7842,8 @@ clear()
 {
   chars_.clear();
 
+  tabMap_.reset();
+
   setChanged(true);
 }
 
@@ -6321,6 +7867,8 @@ setChar(uint pos, char c)
 
   chars_[pos] = c;
 
+  tabMap_.reset();
+
   setChanged(true);
 }
 
@@ -6341,6 +7889,8 @@ insertChar(uint pos, char c)
     chars_[pos] = c;
   }
 
+  tabMap_.reset();
+
   setChanged(true);
 }
 
@@ -6360,10 +7910,11 @@ void
 Line::
 deleteChars(uint pos, uint num)
 {
-  if (! CASSERT(pos < getLength() + num - 1, "Invalid Char Num")) return;
+  if (! CASSERT(pos + num <= getLength(), "Invalid Char Num")) return;
 
-  for (uint i = 0; i < num; ++i)
-    deleteChar(pos);
+  chars_.erase(pos, num);
+
+  tabMap_.reset();
 }
 
 void
@@ -6378,6 +7929,8 @@ deleteChar(uint pos)
     chars_ = chars_.substr(0, pos) + chars_.substr(pos + 1);
   else
     chars_ = chars_.substr(pos + 1);
+
+  tabMap_.reset();
 }
 
 bool
@@ -6463,6 +8016,10 @@ split(Line *line, uint pos)
 
   chars_ = chars_.substr(0, pos);
 
+  tabMap_.reset();
+
+  line->tabMap_.reset();
+
   setChanged(true);
 
   line->setChanged(true);
@@ -6476,6 +8033,10 @@ join(Line *line)
 
   line->chars_.clear();
 
+  tabMap_.reset();
+
+  line->tabMap_.reset();
+
   setChanged(true);
 }
 
@@ -6531,6 +8092,16 @@ setChanged(bool changed)
   changed_ = changed;
 }
 
+const CTabMap &
+Line::
+tabMap(uint tabStop, bool fixed) const
+{
+  if (! tabMap_.isValid(tabStop, fixed))
+    tabMap_.build(chars_, tabStop, fixed);
+
+  return tabMap_;
+}
+
 void
 Line::
 addAnnotation(uint start, uint end, const CSyntaxToken &token)
@@ -6887,6 +8458,60 @@ exec()
 
 //------
 
+InsertCharsUndoCmd::
+InsertCharsUndoCmd(App *vi) :
+ UndoCmd(vi), line_num_(0), char_num_(0)
+{
+}
+
+InsertCharsUndoCmd::
+InsertCharsUndoCmd(App *vi, int line_num, int char_num, const std::string &chars) :
+ UndoCmd(vi), line_num_(line_num), char_num_(char_num), chars_(chars)
+{
+  if (vi_->getDebug())
+    std::cerr << "Add: Insert Chars " << line_num_ << " " << char_num_ <<
+                 " '" << chars_ << "'\n";
+}
+
+bool
+InsertCharsUndoCmd::
+exec(const std::vector<std::string> &argList)
+{
+  assert(argList.size() == 3);
+
+  int  line_num = int(CStrUtil::toInteger(argList[0]));
+  int  char_num = int(CStrUtil::toInteger(argList[1]));
+  auto str      = argList[2];
+
+  vi_->addChars(line_num, char_num, str);
+
+  return true;
+}
+
+bool
+InsertCharsUndoCmd::
+exec()
+{
+  if (getState() == UNDO_STATE) {
+    if (vi_->getDebug())
+      std::cerr << "Exec: Insert Chars " << line_num_ << " " << char_num_ <<
+                   " '" << chars_ << "'\n";
+
+    vi_->addChars(line_num_, char_num_, chars_);
+  }
+  else {
+    if (vi_->getDebug())
+      std::cerr << "Exec: Delete Chars " << line_num_ << " " << char_num_ <<
+                   " " << chars_.size() << "\n";
+
+    vi_->deleteChars(line_num_, char_num_, uint(chars_.size()));
+  }
+
+  return true;
+}
+
+//------
+
 ReplaceCharUndoCmd::
 ReplaceCharUndoCmd(App *vi) :
  UndoCmd(vi), line_num_(0), char_num_(0), c_(0)
@@ -7064,6 +8689,64 @@ exec()
 
 //------
 
+ReplaceLinesUndoCmd::
+ReplaceLinesUndoCmd(App *vi) :
+ UndoCmd(vi), line_num_(0), num_lines_(0)
+{
+}
+
+ReplaceLinesUndoCmd::
+ReplaceLinesUndoCmd(App *vi, int line_num, int num_lines, const Strings &lines) :
+ UndoCmd(vi), line_num_(line_num), num_lines_(num_lines), lines_(lines)
+{
+  if (vi_->getDebug())
+    std::cerr << "Add: Replace Lines " << line_num_ << " " << num_lines_ <<
+                 " " << lines_.size() << "\n";
+}
+
+bool
+ReplaceLinesUndoCmd::
+exec(const std::vector<std::string> &argList)
+{
+  assert(argList.size() >= 2);
+
+  int line_num  = int(CStrUtil::toInteger(argList[0]));
+  int num_lines = int(CStrUtil::toInteger(argList[1]));
+
+  Strings lines(argList.begin() + 2, argList.end());
+
+  vi_->replaceLines(line_num, num_lines, lines);
+
+  return true;
+}
+
+bool
+ReplaceLinesUndoCmd::
+exec()
+{
+  // undo and redo both swap current lines with saved lines
+  Strings lines;
+
+  lines.reserve(num_lines_);
+
+  for (int i = 0; i < num_lines_; ++i)
+    lines.push_back(vi_->getLine(line_num_ + i)->getString());
+
+  if (vi_->getDebug())
+    std::cerr << "Exec: Replace Lines " << line_num_ << " " << num_lines_ <<
+                 " " << lines_.size() << "\n";
+
+  vi_->replaceLines(line_num_, num_lines_, lines_);
+
+  num_lines_ = int(lines_.size());
+
+  lines_.swap(lines);
+
+  return true;
+}
+
+//------
+
 MoveToUndoCmd::
 MoveToUndoCmd(App *vi) :
  UndoCmd(vi)
@@ -423,6 +423,17 @@ updateState()
     arg(edit->app()->getRow() + 1).arg(currentEdit()->app()->getCol() + 1);
 
   positionLabel_->setText(pos);
+
+  // recording register or last macro playback throughput
+  QString msg = " ";
+
+  if      (edit->app()->isRecording())
+    msg = QString("recording @%1").arg(QChar(edit->app()->getRecordRegister()));
+  else if (edit->app()->getPlayKeys() > 0)
+    msg = QString("%1 keys (%2 keys/s)").
+      arg(edit->app()->getPlayKeys()).arg(edit->app()->getPlayRate(), 0, 'f', 0);
+
+  messageLabel_->setText(msg);
 }
 
 void
@@ -0,0 +1,355 @@
+// Syntax lexer throughput benchmark.
+//
+// Usage: CSyntaxBench [-time <secs>] [-threads <n>] [<lang>=<file> ...]
+//
+// Lexes each language's sample text (generated, or mapped from file) repeatedly
+// for the given time through CSyntax::parse and reports throughput in MB/s.
+//
+// With -threads the text is also lexed once by CSyntaxWorker's parallel initial
+// pass for 1, 2, 4 ... n threads (0 is hardware concurrency), reporting time to
+// first and to all results.
+
+#include <CSyntaxC.h>
+#include <CSyntaxCPP.h>
+#include <CSyntaxPython.h>
+#include <CSyntaxVHDL.h>
+#include <CSyntaxWorker.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// counts spans of processed lines
+class SpanCounter : public CSyntaxNotifier {
+ public:
+  size_t numSpans() const { return numSpans_; }
+
+  void addToken(uint, uint, const std::string &, CSyntaxToken) override { }
+
+  void addSpans(uint, const std::string_view &, const CSyntaxSpans &spans) override {
+    numSpans_ += spans.size();
+  }
+
+ private:
+  size_t numSpans_ { 0 };
+};
+
+std::string
+sampleText(const std::string &lang)
+{
+  static const char *cLines[] = {
+    "#include <stdio.h>",
+    "static int count_chars(const char *str, char c) {",
+    "  int n = 0;",
+    "  for (int i = 0; str[i] != '\\0'; ++i) {",
+    "    if (str[i] == c) ++n; /* count */",
+    "  }",
+    "  return n; // done",
+    "}",
+    "",
+    "/* multi-line",
+    "   comment */ typedef struct { unsigned long id; double value; } Item;",
+    "  printf(\"%d items\\n\", count_chars(\"hello world\", 'o'));",
+  };
+
+  static const char *pyLines[] = {
+    "import os",
+    "def count_chars(text, c):",
+    "    n = 0",
+    "    for ch in text:  # scan",
+    "        if ch == c and not ch.isspace():",
+    "            n += 1",
+    "    return n",
+    "",
+    "class Item(object):",
+    "    def __init__(self, name='item', value=None):",
+    "        self.name = \"name: \" + name",
+    "        print(count_chars(self.name, 'a'))",
+  };
+
+  static const char *vhdlLines[] = {
+    "library ieee;",
+    "use ieee.std_logic_1164.all;",
+    "entity counter is",
+    "  port ( clk : in std_logic; -- clock",
+    "         q   : out std_logic_vector(3 downto 0));",
+    "end counter;",
+    "architecture rtl of counter is",
+    "  signal cnt : unsigned(3 downto 0) := \"0000\";",
+    "begin",
+    "  process (clk) begin if rising_edge(clk) then cnt <= cnt + 1; end if;",
+    "  end process;",
+    "end architecture rtl;",
+  };
+
+  const char **lines    = cLines;
+  uint         numLines = sizeof(cLines)/sizeof(char *);
+
+  if      (lang == "python") {
+    lines    = pyLines;
+    numLines = sizeof(pyLines)/sizeof(char *);
+  }
+  else if (lang == "vhdl") {
+    lines    = vhdlLines;
+    numLines = sizeof(vhdlLines)/sizeof(char *);
+  }
+
+  // ~4MB of text
+  std::string sample;
+
+  while (sample.size() < 4*1024*1024) {
+    for (uint i = 0; i < numLines; ++i) {
+      sample += lines[i];
+      sample += '\n';
+    }
+  }
+
+  return sample;
+}
+
+// map file text (unmapped by unmapFile)
+bool
+mapFile(const std::string &fileName, std::string_view &text)
+{
+  int fd = open(fileName.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+
+  void *map = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+  close(fd);
+
+  if (map == MAP_FAILED)
+    return false;
+
+  text = std::string_view(static_cast<const char *>(map), size_t(st.st_size));
+
+  return true;
+}
+
+void
+unmapFile(const std::string_view &text)
+{
+  munmap(const_cast<char *>(text.data()), text.size());
+}
+
+CSyntaxTable *
+createSyntax(const std::string &lang)
+{
+  if      (lang == "c"     ) return new CSyntaxC;
+  else if (lang == "cpp"   ) return new CSyntaxCPP;
+  else if (lang == "python") return new CSyntaxPython;
+  else if (lang == "vhdl"  ) return new CSyntaxVHDL;
+
+  return nullptr;
+}
+
+void
+benchmark(const std::string &lang, const std::string_view &text, double secs)
+{
+  std::unique_ptr<CSyntaxTable> syntax(createSyntax(lang));
+
+  SpanCounter counter;
+
+  syntax->setNotifier(&counter);
+
+  uint numLines = 0;
+
+  size_t total = 0;
+
+  using Clock = std::chrono::steady_clock;
+
+  auto t1 = Clock::now();
+
+  double elapsed = 0.0;
+
+  while (elapsed < secs) {
+    syntax->setState(0);
+
+    CSyntaxTextLines lines(text);
+
+    syntax->parse(lines);
+
+    numLines = syntax->lineNum() + 1;
+
+    total += text.size();
+
+    elapsed = std::chrono::duration<double>(Clock::now() - t1).count();
+  }
+
+  double mb = double(total)/(1024.0*1024.0);
+
+  std::cout << lang << ": " << mb/elapsed << " MB/s (" <<
+               numLines << " lines, " << counter.numSpans() << " spans)\n";
+}
+
+void
+benchmarkThreads(const std::string &lang, const std::string_view &text, uint maxThreads)
+{
+  std::unique_ptr<CSyntaxTable> syntax(createSyntax(lang));
+
+  CSyntaxWorker::Lines lines;
+
+  for (size_t pos = 0; pos < text.size(); ) {
+    auto pos1 = text.find('\n', pos);
+
+    if (pos1 == std::string_view::npos)
+      pos1 = text.size();
+
+    lines.emplace_back();
+
+    lines.back().str = std::string(text.substr(pos, pos1 - pos));
+
+    pos = pos1 + 1;
+  }
+
+  uint numLines = uint(lines.size());
+
+  if (maxThreads == 0)
+    maxThreads = std::max(std::thread::hardware_concurrency(), 1U);
+
+  using Clock = std::chrono::steady_clock;
+
+  double elapsed1 = 0.0;
+
+  for (uint n = 1; ; n = std::min(2*n, maxThreads)) {
+    CSyntaxWorker worker;
+
+    worker.setNumThreads(n);
+
+    auto lines1 = lines;
+
+    auto t1 = Clock::now();
+
+    if (! worker.start(*syntax, 0, 0, 0, std::move(lines1), numLines, numLines)) {
+      std::cerr << lang << ": no background lexer\n";
+      return;
+    }
+
+    // poll results as an editor would (first ones show streaming)
+    CSyntaxWorker::Results results;
+
+    uint endLine = 0;
+    bool carry   = false;
+
+    double first = -1.0;
+
+    while (true) {
+      bool done = worker.takeResults(results, endLine, carry);
+
+      if (first < 0.0 && ! results.empty())
+        first = std::chrono::duration<double>(Clock::now() - t1).count();
+
+      results.clear();
+
+      if (done)
+        break;
+
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - t1).count();
+
+    if (n == 1)
+      elapsed1 = elapsed;
+
+    std::cout << lang << ": " << n << " threads " << 1000.0*elapsed << " ms (first " <<
+                 1000.0*first << " ms, speedup " << elapsed1/elapsed << ")\n";
+
+    if (n >= maxThreads)
+      break;
+  }
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+  double secs = 1.0;
+
+  bool threads    = false;
+  uint maxThreads = 0;
+
+  std::vector<std::pair<std::string, std::string>> langFiles;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-time") == 0 && i < argc - 1) {
+      secs = atof(argv[++i]);
+      continue;
+    }
+
+    if (strcmp(argv[i], "-threads") == 0 && i < argc - 1) {
+      threads    = true;
+      maxThreads = uint(atoi(argv[++i]));
+      continue;
+    }
+
+    std::string arg = argv[i];
+
+    auto pos = arg.find('=');
+
+    if (pos == std::string::npos) {
+      std::cerr << "Usage: CSyntaxBench [-time <secs>] [-threads <n>] [<lang>=<file> ...]\n";
+      exit(1);
+    }
+
+    langFiles.emplace_back(arg.substr(0, pos), arg.substr(pos + 1));
+  }
+
+  if (langFiles.empty()) {
+    for (const auto &lang : { "c", "cpp", "python", "vhdl" }) {
+      auto text = sampleText(lang);
+
+      benchmark(lang, text, secs);
+
+      if (threads)
+        benchmarkThreads(lang, text, maxThreads);
+    }
+
+    return 0;
+  }
+
+  for (const auto &langFile : langFiles) {
+    std::unique_ptr<CSyntaxTable> syntax(createSyntax(langFile.first));
+
+    if (! syntax) {
+      std::cerr << "Invalid language '" << langFile.first << "'\n";
+      continue;
+    }
+
+    std::string_view text;
+
+    if (! mapFile(langFile.second, text)) {
+      std::cerr << "Failed to read '" << langFile.second << "'\n";
+      continue;
+    }
+
+    benchmark(langFile.first, text, secs);
+
+    if (threads)
+      benchmarkThreads(langFile.first, text, maxThreads);
+
+    unmapFile(text);
+  }
+
+  return 0;
+}
@@ -0,0 +1,44 @@
+TEMPLATE = app
+
+QT -= core gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = CSyntaxBench
+
+DEPENDPATH += .
+
+QMAKE_CXXFLAGS += -std=c++17
+
+CONFIG += release
+
+# Input
+SOURCES += \
+CSyntaxBench.cpp \
+\
+../src/CSyntax.cpp \
+../src/CSyntaxTable.cpp \
+../src/CSyntaxC.cpp \
+../src/CSyntaxCPP.cpp \
+../src/CSyntaxPython.cpp \
+../src/CSyntaxVHDL.cpp \
+../src/CSyntaxWorker.cpp \
+
+DESTDIR     = ../bin
+OBJECTS_DIR = ../obj/bench
+
+INCLUDEPATH += \
+. \
+../include \
+../../../CFile/include \
+../../../CStrUtil/include \
+../../../CUtil/include \
+../../../COS/include \
+
+unix:LIBS += \
+-L../../../CFile/lib \
+-L../../../CStrUtil/lib \
+-L../../../CUtil/lib \
+-L../../../COS/lib \
+-lCFile -lCStrUtil -lCUtil -lCOS -lpthread